@@ -20,10 +20,17 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+    delete[] buffer;
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
+    if (buffer == nullptr) {
+        buffer = NEW_NOTHROW uint8_t[LOGREADER_BUFFER_SIZE];
+        if (buffer == nullptr) {
+            return false;
+        }
+    }
     fd = AP::FS().open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
@@ -36,11 +43,27 @@ bool AP_LoggerFileReader::open_log(const char *logfile)
     return true;
 }
 
-ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
+/*
+  make sure there are at least count bytes of unparsed data in the
+  buffer. When there are not, the partial message at the end of the
+  buffer is moved to the start and the rest of the buffer refilled
+ */
+bool AP_LoggerFileReader::fill_buffer(uint16_t count)
 {
-    uint64_t ret = AP::FS().read(fd, buffer, count);
-    bytes_read += ret;
-    return ret;
+    if (buffer_len - buffer_ofs >= count) {
+        return true;
+    }
+    buffer_len -= buffer_ofs;
+    memmove(buffer, &buffer[buffer_ofs], buffer_len);
+    buffer_ofs = 0;
+    while (buffer_len < LOGREADER_BUFFER_SIZE) {
+        const int32_t ret = AP::FS().read(fd, &buffer[buffer_len], LOGREADER_BUFFER_SIZE - buffer_len);
+        if (ret <= 0) {
+            break;
+        }
+        buffer_len += ret;
+    }
+    return buffer_len >= count;
 }
 
 void AP_LoggerFileReader::format_type(uint16_t type, char dest[5])
@@ -59,10 +82,10 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
 
 bool AP_LoggerFileReader::update()
 {
-    uint8_t hdr[3];
-    if (read_input(hdr, 3) != 3) {
+    if (!fill_buffer(3)) {
         return false;
     }
+    const uint8_t *hdr = &buffer[buffer_ofs];
     if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
         printf("bad log header\n");
         return false;
@@ -74,34 +97,39 @@ bool AP_LoggerFileReader::update()
         ::printf("line %u pkt 0x%02x t=%u\n", message_count, hdr[2], AP_HAL::millis());
     }
 #endif
-    packet_counts[hdr[2]]++;
+    const uint8_t msg_type = hdr[2];
+    packet_counts[msg_type]++;
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
+    if (msg_type == LOG_FORMAT_MSG) {
         struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
+        if (!fill_buffer(sizeof(f))) {
             return false;
         }
+        memcpy(&f, &buffer[buffer_ofs], sizeof(f));
+        buffer_ofs += sizeof(f);
+        bytes_read += sizeof(f);
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
 
         message_count++;
         return handle_log_format_msg(f);
     }
 
-    const struct log_Format &f = formats[hdr[2]];
+    const struct log_Format &f = formats[msg_type];
     if (f.length == 0) {
         // can't just throw these away as the format specifies the
         // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
+        ::printf("No format defined for type (%d)\n", msg_type);
         exit(1);
     }
 
-    uint8_t msg[f.length];
-
-    memcpy(msg, hdr, 3);
-    if (read_input(&msg[3], f.length-3) != f.length-3) {
+    if (!fill_buffer(f.length)) {
         return false;
     }
+    // the handlers copy what they need out of the message, so it can
+    // be passed to them in place
+    uint8_t *msg = &buffer[buffer_ofs];
+    buffer_ofs += f.length;
+    bytes_read += f.length;
 
     message_count++;
     return handle_msg(f, msg);
@@ -4,6 +4,16 @@
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+// log data is read in blocks of this size and messages parsed from
+// the block, avoiding a read per message
+#ifndef LOGREADER_BUFFER_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
+#define LOGREADER_BUFFER_SIZE 4096
+#else
+#define LOGREADER_BUFFER_SIZE (1024*1024)
+#endif
+#endif
+
 class AP_LoggerFileReader
 {
 public:
@@ -27,7 +37,12 @@ protected:
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
 
 private:
-    ssize_t read_input(void *buf, size_t count);
+    // make sure at least count bytes are buffered, returning false at end of file
+    bool fill_buffer(uint16_t count);
+
+    uint8_t *buffer = nullptr;
+    uint32_t buffer_len = 0;  // bytes of valid data in buffer
+    uint32_t buffer_ofs = 0;  // offset of the next message in buffer
 
     uint64_t bytes_read = 0;
     uint64_t file_size = 0; // Total size of the log file
@@ -31,6 +31,12 @@
 #include <AP_HAL_Linux/Scheduler.h>
 #endif
 
+#if REPLAY_VARIANTS_ENABLED
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #define streq(x, y) (!strcmp(x, y))
 
 static ReplayVehicle replayvehicle;
@@ -129,11 +135,15 @@ void Replay::usage(void)
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
     ::printf("\t--progress  show a progress bar during replay\n");
+#if REPLAY_VARIANTS_ENABLED
+    ::printf("\t--variant NAME=VALUE[,NAME=VALUE...]  replay with these parameters in directory variantN, may be repeated\n");
+#endif
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    VARIANT,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -146,6 +156,9 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
         {"progress",        false,  0, 'P'},
+#if REPLAY_VARIANTS_ENABLED
+        {"variant",         true,   0, param_key::VARIANT},
+#endif
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -185,6 +198,16 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             show_progress = true;
             break;
 
+#if REPLAY_VARIANTS_ENABLED
+        case param_key::VARIANT:
+            if (num_variants >= ARRAY_SIZE(variants)) {
+                ::printf("Too many variants, max %u\n", unsigned(ARRAY_SIZE(variants)));
+                exit(1);
+            }
+            variants[num_variants++] = gopt.optarg;
+            break;
+#endif
+
         case 'h':
         default:
             usage();
@@ -261,6 +284,18 @@ void Replay::setup()
         _parse_command_line(argc, argv);
     }
 
+#if REPLAY_VARIANTS_ENABLED
+    if (num_variants > 0) {
+        if (filename == nullptr) {
+            ::printf("You must supply a log filename\n");
+            exit(1);
+        }
+        // this only returns in the child process for each variant
+        run_variants();
+        add_variant_parameters();
+    }
+#endif
+
     _vehicle.setup();
 
     set_user_parameters();
@@ -338,6 +373,87 @@ void Replay::loop()
     }
 }
 
+#if REPLAY_VARIANTS_ENABLED
+/*
+  fork a replay process for each variant. The log is decoded and
+  replayed by every child in parallel, each writing its logs under
+  its own variantN directory. This has to happen before the vehicle
+  is set up, as the replay state is global and fork() only copies the
+  calling thread. The parent waits for all of the children and exits
+ */
+void Replay::run_variants(void)
+{
+    // the children change directory, so need the full path of the log
+    char *log_path = realpath(filename, nullptr);
+    if (log_path == nullptr) {
+        ::printf("realpath(%s): %m\n", filename);
+        exit(1);
+    }
+    filename = log_path;
+
+    pid_t pids[REPLAY_MAX_VARIANTS];
+    for (uint8_t i=0; i<num_variants; i++) {
+        fflush(stdout);
+        pids[i] = fork();
+        if (pids[i] == -1) {
+            ::printf("fork: %m\n");
+            exit(1);
+        }
+        if (pids[i] == 0) {
+            char dir[16];
+            snprintf(dir, sizeof(dir), "variant%u", unsigned(i));
+            // the directory may be left from an earlier run
+            mkdir(dir, 0755);
+            if (chdir(dir) != 0) {
+                ::printf("chdir(%s): %m\n", dir);
+                exit(1);
+            }
+            variant_index = i;
+            return;
+        }
+    }
+
+    bool failed = false;
+    for (uint8_t i=0; i<num_variants; i++) {
+        int status;
+        if (waitpid(pids[i], &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ::printf("variant%u (%s) failed\n", unsigned(i), variants[i]);
+            failed = true;
+        } else {
+            ::printf("variant%u (%s) done\n", unsigned(i), variants[i]);
+        }
+    }
+    exit(failed ? 1 : 0);
+}
+
+/*
+  add the parameters of this process's variant to the end of the user
+  parameters, so they are set last and override --parm values
+ */
+void Replay::add_variant_parameters(void)
+{
+    struct user_parameter **tail = &user_parameters;
+    while (*tail != nullptr) {
+        tail = &(*tail)->next;
+    }
+    char *params = strdup(variants[variant_index]);
+    char *saveptr = nullptr;
+    for (char *p = strtok_r(params, ",", &saveptr); p != nullptr; p = strtok_r(nullptr, ",", &saveptr)) {
+        const char *eq = strchr(p, '=');
+        if (eq == nullptr) {
+            ::printf("Usage: --variant NAME=VALUE[,NAME=VALUE...]\n");
+            exit(1);
+        }
+        struct user_parameter *u = NEW_NOTHROW user_parameter;
+        strncpy(u->name, p, MIN(size_t(eq-p), sizeof(u->name)-1));
+        u->value = atof(eq+1);
+        *tail = u;
+        tail = &u->next;
+    }
+    free(params);
+}
+#endif // REPLAY_VARIANTS_ENABLED
+
 /*
   setup user -p parameters
  */
@@ -21,6 +21,13 @@
 
 #define AP_PARAM_VEHICLE_NAME replayvehicle
 
+// replay of several parameter variants of a log, each in a forked process
+#ifndef REPLAY_VARIANTS_ENABLED
+#define REPLAY_VARIANTS_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
+#define REPLAY_MAX_VARIANTS 32
+
 struct user_parameter {
     struct user_parameter *next;
     char name[17];
@@ -112,4 +119,16 @@ private:
 
     void Write_Format(const struct LogStructure &s);
     void write_EKF_formats(void);
+
+#if REPLAY_VARIANTS_ENABLED
+    // parameter lists from --variant
+    const char *variants[REPLAY_MAX_VARIANTS];
+    uint8_t num_variants;
+
+    // variant replayed by this process, -1 if not replaying variants
+    int8_t variant_index = -1;
+
+    void run_variants(void);
+    void add_variant_parameters(void);
+#endif
 };
@@ -880,9 +880,19 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
         find_max_quadrant_velocity(backup_vel_inc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
 
+    // exclusion polygons whose bounds are out of reach of the vehicle are skipped
+    Vector2f position_cm;
+    const bool have_position = AP::ahrs().get_relative_position_NE_origin(position_cm);
+    position_cm *= 100.0f;  // m to cm
+
     // iterate through exclusion polygons
     const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
+        const PolygonIndex *poly_index = fence->polyfence().get_exclusion_polygon_index(i);
+        if (have_position && poly_index != nullptr &&
+            polygon_beyond_reach(kP, accel_cmss, desired_vel_cms, poly_index->bounds_distance(position_cm), fence->get_margin(), dt)) {
+            continue;
+        }
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
         Vector2f backup_vel_exc;
@@ -1447,6 +1457,34 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
     backup_vel = desired_back_vel_cms;
 }
 
+/*
+ * Returns true if adjust_velocity_polygon would neither limit the velocity nor back away
+ * for a polygon none of whose edges are nearer than distance_cm
+ */
+bool AC_Avoid::polygon_beyond_reach(float kP, float accel_cmss, const Vector2f &desired_vel_cms, float distance_cm, float margin, float dt) const
+{
+    // back away if any edge could be within the margin
+    const float margin_cm = MAX(margin * 100.0f, 0.0f);
+    if (distance_cm <= margin_cm) {
+        return false;
+    }
+    if (desired_vel_cms.is_zero()) {
+        return true;
+    }
+
+    const float speed = desired_vel_cms.length();
+    switch (_behavior) {
+    case (BEHAVIOR_SLIDE):
+        // every edge allows at least this speed towards it. 1% covers
+        // rounding in the projection of the velocity onto each edge
+        return get_max_speed(kP, accel_cmss, distance_cm - margin_cm, dt) > speed * 1.01f;
+    case (BEHAVIOR_STOP):
+        // every edge is beyond the end of the stopping line
+        return distance_cm > (2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed)) * 1.01f;
+    }
+    return false;
+}
+
 /*
  * Computes distance required to stop, given current speed.
  *
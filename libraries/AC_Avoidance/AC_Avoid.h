@@ -155,6 +155,12 @@ private:
      */
     void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside);
 
+    /*
+     * Returns true if adjust_velocity_polygon would neither limit the velocity nor back away
+     * for a polygon none of whose edges are nearer than distance_cm
+     */
+    bool polygon_beyond_reach(float kP, float accel_cmss, const Vector2f &desired_vel_cms, float distance_cm, float margin, float dt) const;
+
     /*
      * Computes distance required to stop, given current speed.
      */
@@ -6,6 +6,7 @@
 #include "AC_Avoid.h"
 #include "AP_OADijkstra.h"
 #include "AP_OABendyRuler.h"
+#include "AP_OADatabase.h"
 #include <AP_Logger/AP_Logger.h>
 #include <AP_AHRS/AP_AHRS.h>
 
@@ -78,6 +79,24 @@ void AP_OADijkstra::Write_Visgraph_point(const uint8_t version, const uint8_t po
 }
 #endif
 
+#if AP_OADATABASE_ENABLED
+void AP_OADatabase::Write_OADatabase()
+{
+    const struct log_OADatabase pkt{
+        LOG_PACKET_HEADER_INIT(LOG_OA_DATABASE_MSG),
+        time_us     : AP_HAL::micros64(),
+        queue_len   : _queue.items->available(),
+        queue_max   : _queue.high_water,
+        dropped     : _queue.dropped,
+        count       : _database.count,
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    // high water mark covers the time between messages
+    _queue.high_water = 0;
+}
+#endif
+
 #if AP_AVOIDANCE_ENABLED
 void AC_Avoid::Write_SimpleAvoidance(const uint8_t state, const Vector3f& desired_vel, const Vector3f& modified_vel, const bool back_up) const
 {
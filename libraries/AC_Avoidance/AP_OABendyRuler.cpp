@@ -574,6 +574,20 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
 
     // iterate through exclusion polygons and calculate minimum margin
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
+        // skip polygons whose bounds are clear of the path by more than
+        // the minimum margin so far, as they can only give a larger margin
+        const PolygonIndex *poly_index = fence->polyfence().get_exclusion_polygon_index(i);
+        if (margin_updated && poly_index != nullptr) {
+            const Vector2f &poly_min = poly_index->get_min_cm();
+            const Vector2f &poly_max = poly_index->get_max_cm();
+            const float gap_x = MAX(poly_min.x - MAX(start_NE.x, end_NE.x), MIN(start_NE.x, end_NE.x) - poly_max.x);
+            const float gap_y = MAX(poly_min.y - MAX(start_NE.y, end_NE.y), MIN(start_NE.y, end_NE.y) - poly_max.y);
+            const float gap = MAX(gap_x, gap_y);
+            if (is_positive(gap) && (gap * 0.01f - fence_margin >= margin)) {
+                continue;
+            }
+        }
+
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
    
@@ -695,25 +709,8 @@ bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, co
         return false;
     }
 
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
-        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
-        }
-    }
-
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
-    }
-
-    return false;
+    // find smallest margin of nearby obstacles from segment using database's spatial index
+    return oaDb->get_smallest_margin_from_segment(start_NEU, end_NEU, margin);
 }
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
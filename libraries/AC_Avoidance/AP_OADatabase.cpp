@@ -40,6 +40,18 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_GRID_CELL_SIZE
+    #define AP_OADATABASE_GRID_CELL_SIZE 2.0f   // width of spatial index grid cells in meters
+#endif
+
+#ifndef AP_OADATABASE_QUEUE_BATCH
+    #define AP_OADATABASE_QUEUE_BATCH 100       // items moved from the queue into the database per call while the queue is less than half full
+#endif
+
+#define AP_OADATABASE_QUEUE_POP_MAX     8           // items popped from the queue at once
+#define AP_OADATABASE_GRID_CELL_LIMIT   1.0e6f      // grid cell coordinates are limited to +- this many cells
+#define AP_OADATABASE_GRID_NONE         UINT16_MAX  // end of a grid bucket's list of items
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -61,7 +73,7 @@ const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: QUEUE_SIZE
     // @DisplayName: OADatabase queue maximum number of points
-    // @Description: OADatabase queue maximum number of points. This in an input buffer size. Larger means it can handle larger bursts of incoming data points to filter into the database. No impact on cpu, only RAM. Recommend larger for faster datalinks or for sensors that generate a lot of data.
+    // @Description: OADatabase queue maximum number of points. This in an input buffer size. Larger means it can handle larger bursts of incoming data points to filter into the database. No impact on cpu, only RAM. Recommend larger for faster datalinks or for sensors that generate a lot of data. The queue is rounded up to a power of two.
     // @Range: 1 200
     // @User: Advanced
     // @RebootRequired: True
@@ -123,6 +135,7 @@ AP_OADatabase::AP_OADatabase()
 void AP_OADatabase::init()
 {
     init_database();
+    init_grid();
     init_queue();
 
     // initialise scalar using beam width of at least 1deg
@@ -132,6 +145,8 @@ void AP_OADatabase::init()
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _grid.entries;
+        delete[] _grid.buckets;
         return;
     }
 }
@@ -144,6 +159,7 @@ void AP_OADatabase::update()
 
     process_queue();
     database_items_remove_all_expired();
+    Write_OADatabase();
 }
 
 // push a location into the database
@@ -177,9 +193,8 @@ void AP_OADatabase::queue_push(const Vector3f &pos, uint32_t timestamp_ms, float
     }
 
     const OA_DbItem item = {pos, timestamp_ms, MAX(_radius_min, distance * dist_to_radius_scalar), 0, AP_OADatabase::OA_DbItemImportance::Normal};
-    {
-        WITH_SEMAPHORE(_queue.sem);
-        _queue.items->push(item);
+    if (!_queue.items->push(item)) {
+        _queue.dropped++;
     }
 }
 
@@ -190,7 +205,7 @@ void AP_OADatabase::init_queue()
         return;
     }
 
-    _queue.items = NEW_NOTHROW ObjectBuffer<OA_DbItem>(_queue.size);
+    _queue.items = NEW_NOTHROW ObjectBuffer_MPSC<OA_DbItem>(_queue.size);
     if (_queue.items != nullptr && _queue.items->get_size() == 0) {
         // allocation failed
         delete _queue.items;
@@ -208,6 +223,35 @@ void AP_OADatabase::init_database()
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
 }
 
+void AP_OADatabase::init_grid()
+{
+    if (_database.size == 0) {
+        return;
+    }
+
+    // use a power of two number of buckets, at least half the database size, so each bucket holds few items
+    _grid.num_buckets = 8;
+    while (_grid.num_buckets < _database.size / 2) {
+        _grid.num_buckets *= 2;
+    }
+
+    _grid.entries = NEW_NOTHROW GridEntry[_database.size];
+    _grid.buckets = NEW_NOTHROW uint16_t[_grid.num_buckets];
+    if ((_grid.entries == nullptr) || (_grid.buckets == nullptr)) {
+        // allocation failed
+        delete[] _grid.entries;
+        delete[] _grid.buckets;
+        _grid.entries = nullptr;
+        _grid.buckets = nullptr;
+        return;
+    }
+
+    for (uint16_t i=0; i<_grid.num_buckets; i++) {
+        _grid.buckets[i] = AP_OADATABASE_GRID_NONE;
+    }
+    grid_recalc_bounds();
+}
+
 // get bitmask of gcs channels item should be sent to based on its importance
 // returns 0xFF (send to all channels) if should be sent, 0 if it should not be sent
 uint8_t AP_OADatabase::get_send_to_gcs_flags(const OA_DbItemImportance importance)
@@ -242,42 +286,40 @@ bool AP_OADatabase::process_queue()
     }
 
     // processing queue by moving those entries into the database
-    // Using a for with fixed size is better than while(!empty) because the
-    // while could get us stuck here longer than expected if we're getting
-    // a lot of values pushing into it while we're trying to empty it. With
-    // the for we know we will exit at an expected time
-    const uint16_t queue_available = MIN(_queue.items->available(), 100U);
-    if (queue_available == 0) {
+    // Only the items waiting on entry are processed, rather than looping
+    // until empty, because the loop could get us stuck here longer than
+    // expected if we're getting a lot of values pushing into it while we're
+    // trying to empty it. Normally at most AP_OADATABASE_QUEUE_BATCH are
+    // taken, but once the queue is half full the whole backlog is taken so
+    // that bursts from fast sensors are not dropped
+    const uint32_t backlog = _queue.items->available();
+    if (backlog == 0) {
         return false;
     }
-
-    for (uint16_t queue_index=0; queue_index<queue_available; queue_index++) {
-        OA_DbItem item;
-
-        bool pop_success;
-        {
-            WITH_SEMAPHORE(_queue.sem);
-            pop_success = _queue.items->pop(item);
-        }
-        if (!pop_success) {
+    _queue.high_water = MAX(_queue.high_water, backlog);
+    const uint32_t queue_limit = (backlog * 2 >= _queue.items->get_size()) ? backlog : MIN(backlog, uint32_t(AP_OADATABASE_QUEUE_BATCH));
+
+    uint32_t processed = 0;
+    while (processed < queue_limit) {
+        OA_DbItem items[AP_OADATABASE_QUEUE_POP_MAX];
+        const uint32_t count = _queue.items->pop(items, MIN(queue_limit - processed, uint32_t(ARRAY_SIZE(items))));
+        if (count == 0) {
             return false;
         }
-
-        item.send_to_gcs = get_send_to_gcs_flags(item.importance);
-
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
+        processed += count;
+
+        for (uint32_t i=0; i<count; i++) {
+            OA_DbItem &item = items[i];
+            item.send_to_gcs = get_send_to_gcs_flags(item.importance);
+
+            // compare item to nearby items in database. If found a similar item, update the existing, else add it as a new one
+            uint16_t index;
+            if (find_close_item_in_database(item, index)) {
+                database_item_refresh(index, item.timestamp_ms, item.radius);
+            } else {
+                database_item_add(item);
             }
         }
-
-        if (!found) {
-            database_item_add(item);
-        }
     }
     return (_queue.items->available() > 0);
 }
@@ -289,6 +331,7 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    grid_insert(_database.count);
     _database.count++;
 }
 
@@ -302,9 +345,11 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+    grid_remove(index);
 
     _database.count--;
     if (_database.count == 0) {
+        grid_recalc_bounds();
         return;
     }
 
@@ -312,6 +357,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         // copy last object in array over expired object
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        grid_move(_database.count, index);
     }
 }
 
@@ -332,6 +378,7 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
         _database.items[index].timestamp_ms = timestamp_ms;
         _database.items[index].radius = radius;
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        _grid.radius_max = MAX(_grid.radius_max, radius);
     }
 }
 
@@ -348,13 +395,20 @@ void AP_OADatabase::database_items_remove_all_expired()
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
     uint16_t index = 0;
+    bool removed = false;
     while (index < _database.count) {
         if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
             database_item_remove(index);
+            removed = true;
         } else {
             index++;
         }
     }
+
+    // shrink grid bounds to the remaining items
+    if (removed) {
+        grid_recalc_bounds();
+    }
 }
 
 // returns true if a similar object already exists in database. When true, the object timer is also reset
@@ -369,6 +423,226 @@ bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_
     return ((distance_sq < sq(item.radius)) || (distance_sq < sq(_database.items[index].radius)));
 }
 
+// find the lowest index database item close to "item"
+// returns true on success and updates index
+bool AP_OADatabase::find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const
+{
+    // close items must lie within the larger of the two item's radii so only cells within this distance need to be searched
+    const float search_radius = MAX(item.radius, _grid.radius_max);
+    int32_t x_min, y_min, x_max, y_max;
+    grid_cell(item.pos.x - search_radius, item.pos.y - search_radius, x_min, y_min);
+    grid_cell(item.pos.x + search_radius, item.pos.y + search_radius, x_max, y_max);
+    x_min = MAX(x_min, _grid.cell_x_min);
+    x_max = MIN(x_max, _grid.cell_x_max);
+    y_min = MAX(y_min, _grid.cell_y_min);
+    y_max = MIN(y_max, _grid.cell_y_max);
+    if ((x_min > x_max) || (y_min > y_max)) {
+        // no items in range
+        return false;
+    }
+
+    // check all items if that is quicker than searching the cells
+    if ((uint64_t)(x_max - x_min + 1) * (uint64_t)(y_max - y_min + 1) > _database.count) {
+        for (uint16_t i=0; i<_database.count; i++) {
+            if (is_close_to_item_in_database(i, item)) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // search cells, keeping the lowest index so the result does not depend upon the order of the search
+    uint16_t found_index = AP_OADATABASE_GRID_NONE;
+    for (int32_t x = x_min; x <= x_max; x++) {
+        for (int32_t y = y_min; y <= y_max; y++) {
+            for (uint16_t i = _grid.buckets[grid_bucket(x, y)]; i != AP_OADATABASE_GRID_NONE; i = _grid.entries[i].next) {
+                if ((i < found_index) && (_grid.entries[i].cell_x == x) && (_grid.entries[i].cell_y == y) &&
+                    is_close_to_item_in_database(i, item)) {
+                    found_index = i;
+                }
+            }
+        }
+    }
+    if (found_index == AP_OADATABASE_GRID_NONE) {
+        return false;
+    }
+    index = found_index;
+    return true;
+}
+
+// find the smallest margin (distance in meters less the object's radius) between any object and a line segment
+// start_cm and end_cm are the segment's ends as offsets in cm from the EKF origin
+// returns true on success and updates margin, false if the database is empty
+bool AP_OADatabase::get_smallest_margin_from_segment(const Vector3f &start_cm, const Vector3f &end_cm, float &margin) const
+{
+    if (!healthy() || (_database.count == 0)) {
+        return false;
+    }
+
+    // cells spanned by the segment
+    int32_t x_min, y_min, x_max, y_max;
+    grid_cell(MIN(start_cm.x, end_cm.x) * 0.01f, MIN(start_cm.y, end_cm.y) * 0.01f, x_min, y_min);
+    grid_cell(MAX(start_cm.x, end_cm.x) * 0.01f, MAX(start_cm.y, end_cm.y) * 0.01f, x_max, y_max);
+
+    // search rings of cells of increasing size around the segment. Items in ring k are at
+    // least k-1 cells horizontally from the segment so the search can stop once the closest
+    // of them could not have a smaller margin than already found
+    float smallest_margin = FLT_MAX;
+    uint32_t cells_searched = 0;
+    for (int32_t k = 0; ; k++) {
+        if (k > 0) {
+            // stop if the previous ring included all items
+            if ((x_min - (k-1) <= _grid.cell_x_min) && (x_max + (k-1) >= _grid.cell_x_max) &&
+                (y_min - (k-1) <= _grid.cell_y_min) && (y_max + (k-1) >= _grid.cell_y_max)) {
+                break;
+            }
+            // stop if no item in this ring could be closer
+            if (smallest_margin <= (k-1) * AP_OADATABASE_GRID_CELL_SIZE - _grid.radius_max) {
+                break;
+            }
+        }
+
+        // check all items once searching the cells has become more expensive than doing so
+        if (cells_searched > _database.count) {
+            for (uint16_t i=0; i<_database.count; i++) {
+                const OA_DbItem &item = _database.items[i];
+                const float m = Vector3f::closest_distance_between_line_and_point(start_cm, end_cm, item.pos * 100.0f) * 0.01f - item.radius;
+                smallest_margin = MIN(smallest_margin, m);
+            }
+            break;
+        }
+
+        // search cells on the ring (or within it for the first ring) that may hold items
+        const int32_t ring_y_min = y_min - k;
+        const int32_t ring_y_max = y_max + k;
+        for (int32_t y = MAX(ring_y_min, _grid.cell_y_min); y <= MIN(ring_y_max, _grid.cell_y_max); y++) {
+            if ((k == 0) || (y == ring_y_min) || (y == ring_y_max)) {
+                // full row of cells
+                for (int32_t x = MAX(x_min - k, _grid.cell_x_min); x <= MIN(x_max + k, _grid.cell_x_max); x++) {
+                    calc_smallest_margin_in_cell(x, y, start_cm, end_cm, smallest_margin);
+                    cells_searched++;
+                }
+            } else {
+                // cells at either end of row
+                if (grid_cell_in_bounds(x_min - k, y)) {
+                    calc_smallest_margin_in_cell(x_min - k, y, start_cm, end_cm, smallest_margin);
+                    cells_searched++;
+                }
+                if (grid_cell_in_bounds(x_max + k, y)) {
+                    calc_smallest_margin_in_cell(x_max + k, y, start_cm, end_cm, smallest_margin);
+                    cells_searched++;
+                }
+            }
+        }
+    }
+
+    if (smallest_margin < FLT_MAX) {
+        margin = smallest_margin;
+        return true;
+    }
+    return false;
+}
+
+// update smallest_margin with the margin between the segment and each item in a grid cell
+void AP_OADatabase::calc_smallest_margin_in_cell(int32_t cell_x, int32_t cell_y, const Vector3f &start_cm, const Vector3f &end_cm, float &smallest_margin) const
+{
+    for (uint16_t i = _grid.buckets[grid_bucket(cell_x, cell_y)]; i != AP_OADATABASE_GRID_NONE; i = _grid.entries[i].next) {
+        if ((_grid.entries[i].cell_x != cell_x) || (_grid.entries[i].cell_y != cell_y)) {
+            // another cell sharing this bucket
+            continue;
+        }
+        // margin is distance between line segment and obstacle minus obstacle's radius
+        const OA_DbItem &item = _database.items[i];
+        const float m = Vector3f::closest_distance_between_line_and_point(start_cm, end_cm, item.pos * 100.0f) * 0.01f - item.radius;
+        smallest_margin = MIN(smallest_margin, m);
+    }
+}
+
+// get the grid cell holding a horizontal position (in meters from the EKF origin)
+void AP_OADatabase::grid_cell(float x, float y, int32_t &cell_x, int32_t &cell_y) const
+{
+    cell_x = (int32_t)floorf(constrain_float(x / AP_OADATABASE_GRID_CELL_SIZE, -AP_OADATABASE_GRID_CELL_LIMIT, AP_OADATABASE_GRID_CELL_LIMIT));
+    cell_y = (int32_t)floorf(constrain_float(y / AP_OADATABASE_GRID_CELL_SIZE, -AP_OADATABASE_GRID_CELL_LIMIT, AP_OADATABASE_GRID_CELL_LIMIT));
+}
+
+// get the bucket holding a grid cell's items
+uint16_t AP_OADatabase::grid_bucket(int32_t cell_x, int32_t cell_y) const
+{
+    const uint32_t hash = ((uint32_t)cell_x * 73856093U) ^ ((uint32_t)cell_y * 19349663U);
+    return hash & (_grid.num_buckets - 1);
+}
+
+// returns true if a grid cell is within the range of cells holding items
+bool AP_OADatabase::grid_cell_in_bounds(int32_t cell_x, int32_t cell_y) const
+{
+    return (cell_x >= _grid.cell_x_min) && (cell_x <= _grid.cell_x_max) &&
+           (cell_y >= _grid.cell_y_min) && (cell_y <= _grid.cell_y_max);
+}
+
+// add database item "index" to the grid
+void AP_OADatabase::grid_insert(const uint16_t index)
+{
+    const OA_DbItem &item = _database.items[index];
+    GridEntry &entry = _grid.entries[index];
+    grid_cell(item.pos.x, item.pos.y, entry.cell_x, entry.cell_y);
+
+    uint16_t &bucket = _grid.buckets[grid_bucket(entry.cell_x, entry.cell_y)];
+    entry.next = bucket;
+    bucket = index;
+
+    _grid.cell_x_min = MIN(_grid.cell_x_min, entry.cell_x);
+    _grid.cell_x_max = MAX(_grid.cell_x_max, entry.cell_x);
+    _grid.cell_y_min = MIN(_grid.cell_y_min, entry.cell_y);
+    _grid.cell_y_max = MAX(_grid.cell_y_max, entry.cell_y);
+    _grid.radius_max = MAX(_grid.radius_max, item.radius);
+}
+
+// remove database item "index" from the grid
+void AP_OADatabase::grid_remove(const uint16_t index)
+{
+    const GridEntry &entry = _grid.entries[index];
+    uint16_t *link = &_grid.buckets[grid_bucket(entry.cell_x, entry.cell_y)];
+    while (*link != AP_OADATABASE_GRID_NONE) {
+        if (*link == index) {
+            *link = entry.next;
+            return;
+        }
+        link = &_grid.entries[*link].next;
+    }
+}
+
+// update the grid after database item "index_from" has been moved to "index_to"
+void AP_OADatabase::grid_move(const uint16_t index_from, const uint16_t index_to)
+{
+    _grid.entries[index_to] = _grid.entries[index_from];
+    const GridEntry &entry = _grid.entries[index_to];
+    uint16_t *link = &_grid.buckets[grid_bucket(entry.cell_x, entry.cell_y)];
+    while (*link != AP_OADATABASE_GRID_NONE) {
+        if (*link == index_from) {
+            *link = index_to;
+            return;
+        }
+        link = &_grid.entries[*link].next;
+    }
+}
+
+// recalculate the range of cells holding items and largest radius
+void AP_OADatabase::grid_recalc_bounds()
+{
+    _grid.cell_x_min = _grid.cell_y_min = INT32_MAX;
+    _grid.cell_x_max = _grid.cell_y_max = INT32_MIN;
+    _grid.radius_max = 0;
+    for (uint16_t i=0; i<_database.count; i++) {
+        const GridEntry &entry = _grid.entries[i];
+        _grid.cell_x_min = MIN(_grid.cell_x_min, entry.cell_x);
+        _grid.cell_x_max = MAX(_grid.cell_x_max, entry.cell_x);
+        _grid.cell_y_min = MIN(_grid.cell_y_min, entry.cell_y);
+        _grid.cell_y_max = MAX(_grid.cell_y_max, entry.cell_y);
+        _grid.radius_max = MAX(_grid.radius_max, _database.items[i].radius);
+    }
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
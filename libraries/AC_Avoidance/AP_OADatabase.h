@@ -4,7 +4,7 @@
 
 #if AP_OADATABASE_ENABLED
 
-#include <AP_HAL/Semaphores.h>
+#include <AP_HAL/utility/RingBuffer.h>
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
@@ -42,7 +42,7 @@ public:
     void queue_push(const Vector3f &pos, uint32_t timestamp_ms, float distance);
 
     // returns true if database is healthy
-    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr); }
+    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr) && (_grid.entries != nullptr); }
 
     // fetch an item in database. Undefined result when i >= _database.count.
     const OA_DbItem& get_item(uint32_t i) const { return _database.items[i]; }
@@ -50,6 +50,11 @@ public:
     // get number of items in the database
     uint16_t database_count() const { return _database.count; }
 
+    // find the smallest margin (distance in meters less the object's radius) between any object and a line segment
+    // start_cm and end_cm are the segment's ends as offsets in cm from the EKF origin
+    // returns true on success and updates margin, false if the database is empty
+    bool get_smallest_margin_from_segment(const Vector3f &start_cm, const Vector3f &end_cm, float &margin) const;
+
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
@@ -63,6 +68,7 @@ private:
     // initialise
     void init_queue();
     void init_database();
+    void init_grid();
 
     // database item management
     void database_item_add(const OA_DbItem &item);
@@ -77,6 +83,29 @@ private:
     // returns true if database item "index" is close to "item"
     bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
 
+    // find the lowest index database item close to "item"
+    // returns true on success and updates index
+    bool find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const;
+
+    // grid (spatial index) management
+    void grid_cell(float x, float y, int32_t &cell_x, int32_t &cell_y) const;
+    uint16_t grid_bucket(int32_t cell_x, int32_t cell_y) const;
+    void grid_insert(const uint16_t index);
+    void grid_remove(const uint16_t index);
+    void grid_move(const uint16_t index_from, const uint16_t index_to);
+    void grid_recalc_bounds();
+    bool grid_cell_in_bounds(int32_t cell_x, int32_t cell_y) const;
+
+#if HAL_LOGGING_ENABLED
+    // log queue and database usage
+    void Write_OADatabase();
+#else
+    void Write_OADatabase() {}
+#endif
+
+    // update smallest_margin with the margin between the segment and each item in a grid cell
+    void calc_smallest_margin_in_cell(int32_t cell_x, int32_t cell_y, const Vector3f &start_cm, const Vector3f &end_cm, float &smallest_margin) const;
+
     // enum for use with _OUTPUT parameter
     enum class OutputLevel {
         NONE = 0,
@@ -96,9 +125,10 @@ private:
     AP_Float        _min_alt;                               // OADatabase minimum vehicle height check (in meters)
 
     struct {
-        ObjectBuffer<OA_DbItem> *items;                     // thread safe incoming queue of points from proximity sensor to be put into database
+        ObjectBuffer_MPSC<OA_DbItem> *items;                // lock free incoming queue of points from proximity sensors to be put into database
         uint16_t        size;                               // cached value of _queue_size_param.
-        HAL_Semaphore   sem;                                // semaphore for multi-thread use of queue
+        uint32_t        high_water;                         // most items seen waiting in the queue since the last log
+        std::atomic<uint32_t> dropped;                      // number of items lost because the queue was full
     } _queue;
     float dist_to_radius_scalar;                            // scalar to convert the distance and beam width to an object radius
 
@@ -108,6 +138,22 @@ private:
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
     } _database;
 
+    // spatial index of the database. Items are filed by the horizontal grid cell holding their position.
+    // Cells are hashed into a fixed number of buckets, each holding a linked list of the items in its cells
+    struct GridEntry {
+        int32_t         cell_x;                             // grid cell holding the item
+        int32_t         cell_y;
+        uint16_t        next;                               // index of next item in the same bucket
+    };
+    struct {
+        GridEntry       *entries;                           // one entry for each element of _database.items
+        uint16_t        *buckets;                           // index of first item in each bucket
+        uint16_t        num_buckets;                        // number of buckets (always a power of two)
+        int32_t         cell_x_min, cell_x_max;             // range of cells holding items (min > max if empty)
+        int32_t         cell_y_min, cell_y_max;
+        float           radius_max;                         // no item has a larger radius than this (in meters)
+    } _grid;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
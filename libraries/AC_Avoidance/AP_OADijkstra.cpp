@@ -38,6 +38,7 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _node_heap(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
 {
@@ -128,6 +129,8 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
 
     // create visgraph for all fence (with margin) points
     if (!_polyfence_visgraph_ok) {
+        // destination's visgraph depends upon the fence points so must also be recreated
+        _destination_visgraph_ok = false;
         _polyfence_visgraph_ok = create_fence_visgraph(_error_id);
         if (!_polyfence_visgraph_ok) {
             _shortest_path_ok = false;
@@ -696,6 +699,7 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
 
     // clear fence points visibility graph
     _fence_visgraph.clear();
+    _destination_visgraph_ok = false;
 
     // calculate distance from each point to all other points
     for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
@@ -719,6 +723,12 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         }
     }
 
+    // index graph by fence point so each node's neighbours can be found quickly
+    if (!_fence_visgraph.build_index(total_numpoints())) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+
     return true;
 }
 
@@ -768,32 +778,32 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
     // get current node for convenience
     const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
 
+    // only fence points have neighbours in the fence and destination visibility graphs
+    // (the source's neighbours are handled by calc_shortest_path and the search ends at the destination)
+    if (curr_node.id.id_type != AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) {
+        return;
+    }
+
     // for each visibility graph
     const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
     for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
 
-        // skip if empty
+        // use graph's index to consider only items visible from current_node
         const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
-        }
-
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
+        const uint16_t num_items = curr_visgraph.num_items_for_point(curr_node.id.id_num);
+        for (uint16_t i = 0; i < num_items; i++) {
+            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph.item_for_point(curr_node.id.id_num, i);
+            AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
+            // find item's id in node array
+            node_index item_node_idx;
+            if (find_node_from_id(matching_id, item_node_idx)) {
+                // if current node's distance + distance to item is less than item's current distance, update item's distance
+                const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
+                if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
+                    // update item's distance and set "distance_from_idx" to current node's index
+                    _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
+                    _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
+                    node_heap_update(item_node_idx);
                 }
             }
         }
@@ -832,45 +842,100 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
+// find index of node with lowest tentative distance (ignore visited nodes) and remove it from the heap
 // returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
+bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx)
+{
+    // heap only holds nodes which can be reached but have not yet been visited
+    if (_node_heap_numitems == 0) {
+        return false;
+    }
+
+    // closest node is at the top of the heap, replace it with the last node and restore order
+    node_idx = _node_heap[0];
+    _node_heap_numitems--;
+    if (_node_heap_numitems > 0) {
+        node_heap_swap(0, _node_heap_numitems);
+        node_heap_sift_down(0);
+    }
+    _short_path_data[node_idx].heap_idx = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+    return true;
+}
+
+// returns true if node a should be visited before node b
+// nodes are ordered by distance from source plus heuristic, with ties going to the lowest index
+bool AP_OADijkstra::node_heap_before(node_index a, node_index b) const
+{
+    const float dist_a = _short_path_data[a].distance_cm + _short_path_data[a].heuristic_cm;
+    const float dist_b = _short_path_data[b].distance_cm + _short_path_data[b].heuristic_cm;
+    if (dist_a < dist_b) {
+        return true;
+    }
+    if (dist_b < dist_a) {
+        return false;
+    }
+    return a < b;
+}
+
+// add a node to the heap or move it up after its distance has decreased
+// visited nodes are never added back to the heap
+void AP_OADijkstra::node_heap_update(node_index node_idx)
 {
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
+    ShortPathNode &node = _short_path_data[node_idx];
+    if (node.visited) {
+        return;
+    }
+    if (node.heap_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+        // heap was sized in calc_shortest_path to hold every node
+        node.heap_idx = _node_heap_numitems;
+        _node_heap[_node_heap_numitems++] = node_idx;
+    }
+    node_heap_sift_up(node.heap_idx);
+}
 
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
+// move the node at a heap position up the heap until its parent should be visited before it
+void AP_OADijkstra::node_heap_sift_up(node_index heap_idx)
+{
+    while (heap_idx > 0) {
+        const node_index parent = (heap_idx - 1) / 2;
+        if (!node_heap_before(_node_heap[heap_idx], _node_heap[parent])) {
+            break;
         }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
+        node_heap_swap(heap_idx, parent);
+        heap_idx = parent;
+    }
+}
+
+// move the node at a heap position down the heap until it should be visited before both its children
+void AP_OADijkstra::node_heap_sift_down(node_index heap_idx)
+{
+    while (true) {
+        const uint16_t left = 2 * heap_idx + 1;
+        const uint16_t right = left + 1;
+        node_index first = heap_idx;
+        if ((left < _node_heap_numitems) && node_heap_before(_node_heap[left], _node_heap[first])) {
+            first = left;
+        }
+        if ((right < _node_heap_numitems) && node_heap_before(_node_heap[right], _node_heap[first])) {
+            first = right;
         }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
+        if (first == heap_idx) {
+            return;
         }
+        node_heap_swap(heap_idx, first);
+        heap_idx = first;
     }
+}
 
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
-    }
-    return false;
+// swap two elements of the heap keeping each node's heap_idx consistent
+void AP_OADijkstra::node_heap_swap(node_index heap_idx1, node_index heap_idx2)
+{
+    const node_index node_idx1 = _node_heap[heap_idx1];
+    const node_index node_idx2 = _node_heap[heap_idx2];
+    _node_heap[heap_idx1] = node_idx2;
+    _node_heap[heap_idx2] = node_idx1;
+    _short_path_data[node_idx1].heap_idx = heap_idx2;
+    _short_path_data[node_idx2].heap_idx = heap_idx1;
 }
 
 // calculate shortest path from origin to destination
@@ -886,30 +951,48 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // create visgraphs of origin and destination to fence points
+    // create visgraph of origin to fence points
     if (!update_visgraph(_source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, _path_source, true, _path_destination)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
-    if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-        return false;
+
+    // create visgraph of destination to fence points unless it is unchanged since the last calculation
+    if (!_destination_visgraph_ok || (_destination_visgraph_pos != _path_destination)) {
+        _destination_visgraph_ok = update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination) &&
+                                   _destination_visgraph.build_index(total_numpoints());
+        if (!_destination_visgraph_ok) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _destination_visgraph_pos = _path_destination;
     }
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    // expand _short_path_data and _node_heap if necessary
+    if (!_short_path_data.expand_to_hold(2 + total_numpoints()) ||
+        !_node_heap.expand_to_hold(2 + total_numpoints())) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, heap_idx) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, 0, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX};
     _short_path_data_numpoints = 2;
+    _node_heap_numitems = 0;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
+    // add all inclusion and exclusion fence points to short_path_data array
     for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+        // heuristic is simple Euclidean distance from the node to the destination
+        // This should be admissible, therefore optimal path is guaranteed
+        Vector2f node_pos;
+        if (!get_point(i, node_pos)) {
+            // shouldn't happen
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+            return false;
+        }
+        const float heuristic_cm = (node_pos - _path_destination).length();
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, heuristic_cm, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX};
     }
 
     // start algorithm from source point
@@ -921,6 +1004,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
             _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
             _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            node_heap_update(node_idx);
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
@@ -161,6 +161,8 @@ private:
     AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
+    bool _destination_visgraph_ok;          // true if _destination_visgraph is valid for _destination_visgraph_pos and the current fence visgraph
+    Vector2f _destination_visgraph_pos;     // destination position used to create _destination_visgraph (offset in cm from EKF origin)
 
     // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
     // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
@@ -174,10 +176,30 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance from node to destination, used to direct the search towards the destination
+        node_index heap_idx;            // position of node in _node_heap (or 255 if not in heap)
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
 
+    // binary min-heap of indices into _short_path_data for reachable nodes that have not been visited
+    // ordered by distance_cm + heuristic_cm so the closest node can be found without scanning all nodes
+    AP_ExpandingArray<node_index> _node_heap;
+    node_index _node_heap_numitems;         // number of elements in _node_heap array
+
+    // returns true if node a should be visited before node b
+    bool node_heap_before(node_index a, node_index b) const;
+
+    // add a node to the heap or move it up after its distance has decreased
+    void node_heap_update(node_index node_idx);
+
+    // move the node at a heap position up or down the heap until the heap is in order
+    void node_heap_sift_up(node_index heap_idx);
+    void node_heap_sift_down(node_index heap_idx);
+
+    // swap two elements of the heap
+    void node_heap_swap(node_index heap_idx1, node_index heap_idx2);
+
     // update total distance for all nodes visible from current node
     // curr_node_idx is an index into the _short_path_data array
     void update_visible_node_distances(node_index curr_node_idx);
@@ -186,9 +208,9 @@ private:
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
+    // find index of node with lowest tentative distance (ignore visited nodes) and remove it from the heap
     // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
+    bool find_closest_node_idx(node_index &node_idx);
 
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
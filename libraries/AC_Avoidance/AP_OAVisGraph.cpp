@@ -21,7 +21,9 @@
 
 // constructor initialises expanding array to use 20 elements per chunk
 AP_OAVisGraph::AP_OAVisGraph() :
-    _items(20)
+    _items(20),
+    _index_start(20),
+    _index_items(20)
 {
 }
 
@@ -41,6 +43,64 @@ bool AP_OAVisGraph::add_item(const OAItemID &id1, const OAItemID &id2, float dis
     // add item
     _items[_num_items] = {id1, id2, distance_cm};
     _num_items++;
+
+    // index no longer covers all items
+    _index_num_points = 0;
+    return true;
+}
+
+// build an index of items by intermediate point
+// returns true on success, false on failure to allocate memory
+bool AP_OAVisGraph::build_index(uint16_t num_points)
+{
+    _index_num_points = 0;
+
+    // count entries, each item may be listed against both of its ends
+    uint32_t num_entries = 0;
+    for (uint16_t i = 0; i < _num_items; i++) {
+        num_entries += (_items[i].id1.id_type == OATYPE_INTERMEDIATE_POINT) ? 1 : 0;
+        num_entries += (_items[i].id2.id_type == OATYPE_INTERMEDIATE_POINT) ? 1 : 0;
+    }
+    if ((num_points >= UINT16_MAX) || (num_entries > UINT16_MAX)) {
+        return false;
+    }
+    if (!_index_start.expand_to_hold(num_points + 1) || !_index_items.expand_to_hold(num_entries)) {
+        return false;
+    }
+
+    // count items involving each point in _index_start[id_num+1]
+    for (uint16_t n = 0; n <= num_points; n++) {
+        _index_start[n] = 0;
+    }
+    for (uint16_t i = 0; i < _num_items; i++) {
+        const VisGraphItem &item = _items[i];
+        if ((item.id1.id_type == OATYPE_INTERMEDIATE_POINT) && (item.id1.id_num < num_points)) {
+            _index_start[item.id1.id_num + 1]++;
+        }
+        if ((item.id2.id_type == OATYPE_INTERMEDIATE_POINT) && (item.id2.id_num < num_points)) {
+            _index_start[item.id2.id_num + 1]++;
+        }
+    }
+
+    // convert counts to offsets, _index_start[n+1] then holds the first entry of point n
+    // and is advanced as the point's entries are filled in below, leaving it at the first entry of point n+1
+    for (uint16_t n = 1; n <= num_points; n++) {
+        _index_start[n] += _index_start[n-1];
+    }
+    for (uint16_t n = num_points; n > 0; n--) {
+        _index_start[n] = _index_start[n-1];
+    }
+    for (uint16_t i = 0; i < _num_items; i++) {
+        const VisGraphItem &item = _items[i];
+        if ((item.id1.id_type == OATYPE_INTERMEDIATE_POINT) && (item.id1.id_num < num_points)) {
+            _index_items[_index_start[item.id1.id_num + 1]++] = i;
+        }
+        if ((item.id2.id_type == OATYPE_INTERMEDIATE_POINT) && (item.id2.id_num < num_points)) {
+            _index_items[_index_start[item.id2.id_num + 1]++] = i;
+        }
+    }
+
+    _index_num_points = num_points;
     return true;
 }
 
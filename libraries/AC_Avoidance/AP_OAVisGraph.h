@@ -40,8 +40,8 @@ public:
         float distance_cm;  // distance between the items
     };
 
-    // clear all elements from graph
-    void clear() { _num_items = 0; }
+    // clear all elements from graph (and the intermediate point index)
+    void clear() { _num_items = 0; _index_num_points = 0; }
 
     // get number of items in visibility graph table
     uint16_t num_items() const { return _num_items; }
@@ -53,10 +53,32 @@ public:
     // Note: no protection against out-of-bounds accesses so use with num_items()
     const VisGraphItem& operator[](uint16_t i) const { return _items[i]; }
 
+    // build an index of items by intermediate point so the items involving a point
+    // can be retrieved without searching the whole graph. num_points should be one
+    // more than the highest intermediate point id_num in the graph
+    // the index is discarded by clear() and add_item()
+    // returns true on success, false on failure to allocate memory
+    bool build_index(uint16_t num_points);
+
+    // get number of items involving an intermediate point (requires build_index to have been run)
+    uint16_t num_items_for_point(oaid_num id_num) const {
+        return (id_num < _index_num_points) ? _index_start[id_num+1] - _index_start[id_num] : 0;
+    }
+
+    // get the i'th item involving an intermediate point
+    // Note: no protection against out-of-bounds accesses so use with num_items_for_point()
+    const VisGraphItem& item_for_point(oaid_num id_num, uint16_t i) const { return _items[_index_items[_index_start[id_num] + i]]; }
+
 private:
 
     AP_ExpandingArray<VisGraphItem> _items;
     uint16_t _num_items;
+
+    // index of items by intermediate point held in compressed sparse row form
+    // items involving point n are _items[_index_items[k]] for k from _index_start[n] up to (but not including) _index_start[n+1]
+    AP_ExpandingArray<uint16_t> _index_start;
+    AP_ExpandingArray<uint16_t> _index_items;
+    uint16_t _index_num_points;     // number of points in index, zero if index has not been built
 };
 
 #endif  // AP_OAPATHPLANNER_ENABLED
@@ -7,7 +7,8 @@
     LOG_OA_BENDYRULER_MSG, \
     LOG_OA_DIJKSTRA_MSG, \
     LOG_SIMPLE_AVOID_MSG, \
-    LOG_OD_VISGRAPH_MSG
+    LOG_OD_VISGRAPH_MSG, \
+    LOG_OA_DATABASE_MSG
 
 // @LoggerMessage: OABR
 // @Description: Object avoidance (Bendy Ruler) diagnostics
@@ -107,6 +108,22 @@ struct PACKED log_OD_Visgraph {
   int32_t Lon;
 };
 
+// @LoggerMessage: OADB
+// @Description: Object avoidance database queue usage
+// @Field: TimeUS: Time since system startup
+// @Field: QLen: Number of items waiting in the queue
+// @Field: QMax: Most items waiting in the queue since the last message
+// @Field: Drop: Total number of items dropped because the queue was full
+// @Field: Cnt: Number of items in the database
+struct PACKED log_OADatabase {
+  LOG_PACKET_HEADER;
+  uint64_t time_us;
+  uint32_t queue_len;
+  uint32_t queue_max;
+  uint32_t dropped;
+  uint16_t count;
+};
+
 #if AP_AVOIDANCE_ENABLED
 #define LOG_STRUCTURE_FROM_AVOIDANCE \
     { LOG_OA_BENDYRULER_MSG, sizeof(log_OABendyRuler), \
@@ -116,7 +133,9 @@ struct PACKED log_OD_Visgraph {
     { LOG_SIMPLE_AVOID_MSG, sizeof(log_SimpleAvoid), \
       "SA",  "QBffffffB","TimeUS,State,DVelX,DVelY,DVelZ,MVelX,MVelY,MVelZ,Back", "s-nnnnnn-", "F--------", true }, \
      { LOG_OD_VISGRAPH_MSG, sizeof(log_OD_Visgraph), \
-      "OAVG", "QBBLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true},
+      "OAVG", "QBBLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true}, \
+    { LOG_OA_DATABASE_MSG, sizeof(log_OADatabase), \
+      "OADB", "QIIIH", "TimeUS,QLen,QMax,Drop,Cnt", "s----", "F----", true},
 #else
 #define LOG_STRUCTURE_FROM_AVOIDANCE
 #endif // AP_AVOIDANCE_ENABLED
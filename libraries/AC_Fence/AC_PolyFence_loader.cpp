@@ -241,23 +241,28 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     uint16_t num_inclusion_outside = 0;
     distance_outside_fence = -FLT_MAX;
 
-    // check we are inside each inclusion zone:
+    // check we are inside each inclusion zone.  The distances are only
+    // searched as far as they could still change distance_outside_fence;
+    // the limits leave 1% and 1cm of slack so that a distance cut short
+    // at the limit has the same effect as the exact one
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.index.outside(pos)) {
             num_inclusion_outside++;
-            if (valid_distance) {
+            // a positive distance_outside_fence only shrinks to a nearer boundary
+            const float limit_cm = is_positive(distance_outside_fence) ? distance_outside_fence * 101.0f + 1.0f : FLT_MAX;
+            if (boundary.index.closest_distance_point(scaled_pos, distance, limit_cm)) {
+                distance *= 0.01f; // convert back to meters
                 if (is_positive(distance_outside_fence)) {
                     distance_outside_fence = MIN(distance_outside_fence, distance);
                 } else {
                     distance_outside_fence = distance;
                 }
             }
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        } else if (!is_positive(distance_outside_fence) &&
+                   boundary.index.closest_distance_point(scaled_pos, distance, distance_outside_fence * -101.0f + 1.0f)) {
+            distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
         }
     }
 
@@ -265,17 +270,16 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
-            if (valid_distance) {
-                distance_outside_fence = distance;
+        if (!boundary.index.outside(pos)) {
+            if (boundary.index.closest_distance_point(scaled_pos, distance)) {
+                distance_outside_fence = distance * 0.01f;
             } else {
                 distance_outside_fence = 0.0f;
             }
             return true;
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        } else if (!is_positive(distance_outside_fence) &&
+                   boundary.index.closest_distance_point(scaled_pos, distance, distance_outside_fence * -101.0f + 1.0f)) {
+            distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
         }
     }
 
@@ -766,6 +770,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            boundary.index.init(boundary.points, boundary.points_lla, boundary.count);
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -785,6 +790,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            boundary.index.init(boundary.points, boundary.points_lla, boundary.count);
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -898,6 +904,15 @@ Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns the index built over an exclusion polygon when it was loaded
+const PolygonIndex *AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const
+{
+    if (index >= _num_loaded_exclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded_exclusion_boundary[index].index;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
@@ -1661,6 +1676,7 @@ void AC_PolyFence_loader::init() {};
 bool AC_PolyFence_loader::get_item(const uint16_t seq, AC_PolyFenceItem &item) { return false; }
 
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
+const PolygonIndex *AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const { return nullptr; }
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
 
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
@@ -2,6 +2,7 @@
 
 #include "AC_Fence_config.h"
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/PolygonIndex.h>
 
 // CIRCLE_INCLUSION_INT stores the radius an a 32-bit integer in
 // metres.  This was a bug, and CIRCLE_INCLUSION was created to store
@@ -79,6 +80,10 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the index built over an exclusion polygon when it was
+    /// loaded, for its bounds and accelerated point queries
+    const PolygonIndex *get_exclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -302,6 +307,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex index; // bounds and edge buckets of the points
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -312,6 +318,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex index; // bounds and edge buckets of the points
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
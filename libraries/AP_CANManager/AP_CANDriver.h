@@ -22,6 +22,7 @@
 
 class AP_CANManager;
 class CANSensor;
+class ExpandingString;
 
 class AP_CANDriver
 {
@@ -41,4 +42,7 @@ public:
 
     // handler for outgoing frames for auxillary drivers
     virtual bool write_aux_frame(AP_HAL::CANFrame &out_frame, const uint32_t timeout_us) { return false; }
+
+    // append protocol stats to the stats of an interface
+    virtual void get_stats(ExpandingString &str) {}
 };
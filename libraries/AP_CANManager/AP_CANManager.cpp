@@ -424,6 +424,19 @@ void AP_CANManager::log_retrieve(ExpandingString &str) const
     str.append(_log_buf, _log_pos);
 }
 
+// stats of the protocol driver using interface i, for the can stats files
+void AP_CANManager::driver_stats(uint8_t i, ExpandingString &str) const
+{
+    if (i >= HAL_NUM_CAN_IFACES) {
+        return;
+    }
+    const uint8_t drv_num = _interfaces[i]._driver_number;
+    if (drv_num == 0 || drv_num > HAL_MAX_CAN_PROTOCOL_DRIVERS || _drivers[drv_num-1] == nullptr) {
+        return;
+    }
+    _drivers[drv_num-1]->get_stats(str);
+}
+
 #if HAL_GCS_ENABLED
 /*
   handle MAV_CMD_CAN_FORWARD mavlink long command
@@ -94,6 +94,9 @@ public:
 
     void log_retrieve(ExpandingString &str) const;
 
+    // stats of the protocol driver using interface i
+    void driver_stats(uint8_t i, ExpandingString &str) const;
+
     // return driver type index i
     AP_CAN::Protocol get_driver_type(uint8_t i) const
     {
@@ -0,0 +1,206 @@
+#include "AP_Canard_TxQueue.h"
+
+#if HAL_ENABLE_DRONECAN_DRIVERS
+
+#include <AP_Common/ExpandingString.h>
+#include <AP_Math/AP_Math.h>
+
+uint16_t CanardTxQueue::init(uint16_t num_frames)
+{
+    delete[] items;
+    items = nullptr;
+    num_frames = MIN(num_frames, NONE);
+    if (num_frames > 0) {
+        items = NEW_NOTHROW Item[num_frames];
+    }
+    num_items = items != nullptr ? num_frames : 0;
+    num_free = num_items;
+    free_head = num_items > 0 ? 0 : NONE;
+    for (uint16_t i=0; i<num_items; i++) {
+        items[i].next[0] = i+1 < num_items ? i+1 : NONE;
+    }
+    for (uint8_t iface=0; iface<HAL_NUM_CAN_IFACES; iface++) {
+        for (auto &l : lists[iface]) {
+            l.head = l.tail = NONE;
+        }
+        nonempty[iface] = 0;
+    }
+    memset(stats, 0, sizeof(stats));
+    return num_items;
+}
+
+bool CanardTxQueue::push(const AP_HAL::CANFrame &frame, uint64_t deadline_us, uint8_t iface_mask, bool raw_command)
+{
+    iface_mask &= (1U<<HAL_NUM_CAN_IFACES)-1;
+    if (free_head == NONE || iface_mask == 0) {
+        return false;
+    }
+    const uint16_t idx = free_head;
+    Item &item = items[idx];
+    free_head = item.next[0];
+    num_free--;
+
+    item.frame = frame;
+    item.deadline_us = deadline_us;
+    item.queued_us = AP_HAL::micros();
+    item.iface_mask = iface_mask;
+    item.priority = priority(frame.id);
+    item.sent = false;
+
+    const uint8_t list = raw_command ? RAW_LIST : item.priority;
+    for (uint8_t iface=0; iface<HAL_NUM_CAN_IFACES; iface++) {
+        if ((iface_mask & (1U<<iface)) == 0) {
+            continue;
+        }
+        item.next[iface] = NONE;
+        List &l = lists[iface][list];
+        if (l.tail == NONE) {
+            l.head = idx;
+        } else {
+            items[l.tail].next[iface] = idx;
+        }
+        l.tail = idx;
+        if (list != RAW_LIST) {
+            nonempty[iface] |= 1U<<list;
+        }
+    }
+
+    PriorityStats &s = stats[item.priority];
+    s.depth++;
+    s.max_depth = MAX(s.max_depth, s.depth);
+    return true;
+}
+
+int8_t CanardTxQueue::next_list(uint8_t iface, bool raw_commands_only) const
+{
+    const uint16_t raw = lists[iface][RAW_LIST].head;
+    if (raw_commands_only || nonempty[iface] == 0) {
+        return raw == NONE ? -1 : RAW_LIST;
+    }
+    const uint8_t highest = __builtin_ctz(nonempty[iface]);
+    if (raw != NONE && items[raw].priority <= highest) {
+        return RAW_LIST;
+    }
+    return highest;
+}
+
+const AP_HAL::CANFrame *CanardTxQueue::peek(uint8_t iface, bool raw_commands_only, uint64_t &deadline_us) const
+{
+    const int8_t list = next_list(iface, raw_commands_only);
+    if (list < 0) {
+        return nullptr;
+    }
+    const Item &item = items[lists[iface][list].head];
+    deadline_us = item.deadline_us;
+    return &item.frame;
+}
+
+void CanardTxQueue::pop(uint8_t iface, bool raw_commands_only, bool sent)
+{
+    const int8_t list = next_list(iface, raw_commands_only);
+    if (list >= 0) {
+        remove_head(iface, list, sent);
+    }
+}
+
+void CanardTxQueue::remove_head(uint8_t iface, uint8_t list, bool sent)
+{
+    List &l = lists[iface][list];
+    const uint16_t idx = l.head;
+    Item &item = items[idx];
+    l.head = item.next[iface];
+    if (l.head == NONE) {
+        l.tail = NONE;
+        if (list != RAW_LIST) {
+            nonempty[iface] &= ~(1U<<list);
+        }
+    }
+
+    if (sent && !item.sent) {
+        // latency to reaching the first interface
+        item.sent = true;
+        PriorityStats &s = stats[item.priority];
+        const uint32_t latency_us = AP_HAL::micros() - item.queued_us;
+        s.latency_avg_us = s.sent == 0 ? latency_us : s.latency_avg_us + (int32_t(latency_us - s.latency_avg_us) / 8);
+        s.latency_max_us = MAX(s.latency_max_us, latency_us);
+        s.sent++;
+    }
+
+    item.iface_mask &= ~(1U<<iface);
+    if (item.iface_mask == 0) {
+        release(idx);
+    }
+}
+
+void CanardTxQueue::release(uint16_t idx)
+{
+    Item &item = items[idx];
+    PriorityStats &s = stats[item.priority];
+    s.depth--;
+    if (!item.sent) {
+        s.dropped++;
+    }
+    item.next[0] = free_head;
+    free_head = idx;
+    num_free++;
+}
+
+uint16_t CanardTxQueue::drop_stale(uint64_t now_us)
+{
+    const uint16_t free_before = num_free;
+    for (uint8_t iface=0; iface<HAL_NUM_CAN_IFACES; iface++) {
+        for (uint8_t list=0; list<ARRAY_SIZE(lists[iface]); list++) {
+            List &l = lists[iface][list];
+            uint16_t prev = NONE;
+            uint16_t idx = l.head;
+            while (idx != NONE) {
+                Item &item = items[idx];
+                const uint16_t next = item.next[iface];
+                if (now_us < item.deadline_us) {
+                    prev = idx;
+                    idx = next;
+                    continue;
+                }
+                if (prev == NONE) {
+                    l.head = next;
+                } else {
+                    items[prev].next[iface] = next;
+                }
+                if (l.tail == idx) {
+                    l.tail = prev;
+                }
+                item.iface_mask &= ~(1U<<iface);
+                if (item.iface_mask == 0) {
+                    release(idx);
+                }
+                idx = next;
+            }
+            if (l.head == NONE && list != RAW_LIST) {
+                nonempty[iface] &= ~(1U<<list);
+            }
+        }
+    }
+    return num_free - free_before;
+}
+
+void CanardTxQueue::get_stats(ExpandingString &str) const
+{
+    str.printf("tx_queue_free:  %u/%u\n", unsigned(num_free), unsigned(num_items));
+    str.printf("prio depth max_depth sent dropped lat_avg_us lat_max_us\n");
+    for (uint8_t i=0; i<NUM_PRIORITIES; i++) {
+        const PriorityStats &s = stats[i];
+        if (s.max_depth == 0) {
+            continue;
+        }
+        str.printf("%4u %5u %9u %lu %lu %lu %lu\n",
+                   unsigned(i),
+                   unsigned(s.depth),
+                   unsigned(s.max_depth),
+                   (unsigned long)s.sent,
+                   (unsigned long)s.dropped,
+                   (unsigned long)s.latency_avg_us,
+                   (unsigned long)s.latency_max_us);
+    }
+}
+
+#endif // HAL_ENABLE_DRONECAN_DRIVERS
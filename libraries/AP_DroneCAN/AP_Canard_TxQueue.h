@@ -0,0 +1,106 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_ENABLE_DRONECAN_DRIVERS
+
+class ExpandingString;
+
+/*
+  transmit queue for CanardInterface, replacing the walk of libcanard's
+  singly linked tx_queue on every send.
+
+  Frames live in a fixed pool allocated at init, separate from the
+  libcanard memory arena. Each interface has a FIFO list per DroneCAN
+  priority threading through the same frames, plus a list of its own
+  for ESC raw commands, and a bitmask of which priority lists are
+  non-empty. The next frame to send on an interface is then found in
+  constant time, whatever else is queued behind it, and raw commands
+  can be sent on their own without skipping over other traffic. A frame is freed once
+  every interface it was queued for has sent or dropped it.
+ */
+class CanardTxQueue {
+public:
+    CanardTxQueue() {}
+    ~CanardTxQueue() { delete[] items; }
+    CLASS_NO_COPY(CanardTxQueue);
+
+    // DroneCAN priorities are the top 5 bits of the 29 bit ID, 0 highest
+    static constexpr uint8_t NUM_PRIORITIES = 32;
+
+    static uint8_t priority(uint32_t id) { return (id >> 24) & 0x1F; }
+
+    // bytes of memory used by each frame that can be queued
+    static size_t frame_size(void) { return sizeof(Item); }
+
+    // allocate space for num_frames frames, returning the number allocated
+    uint16_t init(uint16_t num_frames);
+
+    // number of frames that can be queued
+    uint16_t space() const { return num_free; }
+
+    // queue a frame to send on the interfaces in iface_mask
+    bool push(const AP_HAL::CANFrame &frame, uint64_t deadline_us, uint8_t iface_mask, bool raw_command);
+
+    // next frame to send on an interface, nullptr if there is none
+    const AP_HAL::CANFrame *peek(uint8_t iface, bool raw_commands_only, uint64_t &deadline_us) const;
+
+    // remove the frame returned by peek from an interface's queue,
+    // recording whether it was sent
+    void pop(uint8_t iface, bool raw_commands_only, bool sent);
+
+    // drop frames past their deadline from every interface's queue,
+    // returning the number of frames freed
+    uint16_t drop_stale(uint64_t now_us);
+
+    // per priority depth, counters and latency
+    void get_stats(ExpandingString &str) const;
+
+private:
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr uint8_t RAW_LIST = NUM_PRIORITIES;
+
+    struct Item {
+        AP_HAL::CANFrame frame;
+        uint64_t deadline_us;
+        uint32_t queued_us;
+        uint16_t next[HAL_NUM_CAN_IFACES];
+        uint8_t iface_mask;     // interfaces it is still queued on
+        uint8_t priority;
+        bool sent;
+    };
+
+    struct List {
+        uint16_t head;
+        uint16_t tail;
+    };
+
+    // list holding the next frame for an interface, -1 if all are empty
+    int8_t next_list(uint8_t iface, bool raw_commands_only) const;
+
+    // take the first frame off a list, freeing it if no other
+    // interface still has it queued
+    void remove_head(uint8_t iface, uint8_t list, bool sent);
+
+    // free a frame no interface has queued
+    void release(uint16_t idx);
+
+    Item *items = nullptr;
+    uint16_t num_items;
+    uint16_t num_free;
+    uint16_t free_head = NONE;
+
+    List lists[HAL_NUM_CAN_IFACES][NUM_PRIORITIES+1];
+    uint32_t nonempty[HAL_NUM_CAN_IFACES];
+
+    struct PriorityStats {
+        uint16_t depth;
+        uint16_t max_depth;
+        uint32_t sent;
+        uint32_t dropped;
+        uint32_t latency_avg_us;
+        uint32_t latency_max_us;
+    } stats[NUM_PRIORITIES];
+};
+
+#endif // HAL_ENABLE_DRONECAN_DRIVERS
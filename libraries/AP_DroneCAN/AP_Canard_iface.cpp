@@ -5,6 +5,7 @@
 #include <canard/handler_list.h>
 #include <canard/transfer_object.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Common/ExpandingString.h>
 #include <dronecan_msgs.h>
 extern const AP_HAL::HAL& hal;
 #define LOG_TAG "DroneCANIface"
@@ -15,6 +16,19 @@ extern const AP_HAL::HAL& hal;
 
 #define CANARD_MSG_TYPE_FROM_ID(x)                         ((uint16_t)(((x) >> 8U)  & 0xFFFFU))
 
+/*
+  frames the transmit queue can hold, allocated on top of the
+  CAN_Dx_UC_POOL arena. Each takes CanardTxQueue::frame_size() bytes,
+  40 with classic CAN and 96 with CAN FD
+ */
+#ifndef AP_DRONECAN_TX_QUEUE_FRAMES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_DRONECAN_TX_QUEUE_FRAMES 128
+#else
+#define AP_DRONECAN_TX_QUEUE_FRAMES 64
+#endif
+#endif
+
 DEFINE_HANDLER_LIST_HEADS();
 DEFINE_HANDLER_LIST_SEMAPHORES();
 
@@ -63,6 +77,19 @@ Interface(iface_index) {
 }
 
 void CanardInterface::init(void* mem_arena, size_t mem_arena_size, uint8_t node_id) {
+    // the tx queue has memory of its own, leaving libcanard the whole
+    // arena for transfers being received and sent
+    uint16_t queue_frames = AP_DRONECAN_TX_QUEUE_FRAMES;
+#if AP_TEST_DRONECAN_DRIVERS
+    if (this == &test_iface) {
+        // processTestRx takes frames straight from libcanard
+        queue_frames = 0;
+    }
+#endif
+    if (tx_queue.init(queue_frames) != queue_frames) {
+        // out of memory
+        return;
+    }
     canardInit(&canard, mem_arena, mem_arena_size, onTransferReception, shouldAcceptTransfer, this);
     canardSetLocalNodeID(&canard, node_id);
     initialized = true;
@@ -98,6 +125,9 @@ bool CanardInterface::broadcast(const Canard::Transfer &bcast_transfer) {
     };
     // do canard broadcast
     int16_t ret = canardBroadcastObj(&canard, &tx_transfer);
+    if (ret > 0 && !queue_tx_frames(ret)) {
+        ret = -CANARD_ERROR_OUT_OF_MEMORY;
+    }
 #if AP_TEST_DRONECAN_DRIVERS
     if (this == &test_iface) {
         test_iface_sem.give();
@@ -135,6 +165,9 @@ bool CanardInterface::request(uint8_t destination_node_id, const Canard::Transfe
     };
     // do canard request
     int16_t ret = canardRequestOrRespondObj(&canard, destination_node_id, &tx_transfer);
+    if (ret > 0 && !queue_tx_frames(ret)) {
+        ret = -CANARD_ERROR_OUT_OF_MEMORY;
+    }
     if (ret <= 0) {
         protocol_stats.tx_errors++;
     } else {
@@ -167,6 +200,9 @@ bool CanardInterface::respond(uint8_t destination_node_id, const Canard::Transfe
     };
     // do canard respond
     int16_t ret = canardRequestOrRespondObj(&canard, destination_node_id, &tx_transfer);
+    if (ret > 0 && !queue_tx_frames(ret)) {
+        ret = -CANARD_ERROR_OUT_OF_MEMORY;
+    }
     if (ret <= 0) {
         protocol_stats.tx_errors++;
     } else {
@@ -204,6 +240,41 @@ void CanardInterface::processTestRx() {
 }
 #endif
 
+/*
+  move the frames of the transfer libcanard has just encoded into the
+  transmit queue. A transfer is queued whole or not at all, as the
+  receiver can't use part of one
+ */
+bool CanardInterface::queue_tx_frames(int16_t num_frames)
+{
+#if AP_TEST_DRONECAN_DRIVERS
+    if (this == &test_iface) {
+        return true;
+    }
+#endif
+    bool fits = tx_queue.space() >= num_frames;
+    if (!fits) {
+        tx_queue.drop_stale(AP_HAL::micros64());
+        fits = tx_queue.space() >= num_frames;
+    }
+    for (const CanardCANFrame* txf = canardPeekTxQueue(&canard); txf != NULL; txf = canardPeekTxQueue(&canard)) {
+        if (fits) {
+            AP_HAL::CANFrame txmsg {};
+            txmsg.dlc = AP_HAL::CANFrame::dataLengthToDlc(txf->data_len);
+            memcpy(txmsg.data, txf->data, txf->data_len);
+            txmsg.id = (txf->id | AP_HAL::CANFrame::FlagEFF);
+#if HAL_CANFD_SUPPORTED
+            txmsg.canfd = txf->canfd;
+#endif
+            const bool raw_command = CANARD_MSG_TYPE_FROM_ID(txf->id) == UAVCAN_EQUIPMENT_ESC_RAWCOMMAND_ID ||
+                                     CANARD_MSG_TYPE_FROM_ID(txf->id) == COM_HOBBYWING_ESC_RAWCOMMAND_ID;
+            tx_queue.push(txmsg, txf->deadline_usec, txf->iface_mask, raw_command);
+        }
+        canardPopTxQueue(&canard);
+    }
+    return fits;
+}
+
 void CanardInterface::processTx(bool raw_commands_only = false) {
     WITH_SEMAPHORE(_sem_tx);
 
@@ -211,10 +282,6 @@ void CanardInterface::processTx(bool raw_commands_only = false) {
         if (ifaces[iface] == NULL) {
             continue;
         }
-        auto txq = canard.tx_queue;
-        if (txq == nullptr) {
-            return;
-        }
         // volatile as the value can change at any time during can interrupt
         // we need to ensure that this is not optimized
         volatile const auto *stats = ifaces[iface]->get_statistics();
@@ -229,60 +296,40 @@ void CanardInterface::processTx(bool raw_commands_only = false) {
             */
             iface_down = false;
         } 
-        // scan through list of pending transfers
+        // send the highest priority frames until the interface is full
         while (true) {
-            auto txf = &txq->frame;
-            if (raw_commands_only &&
-                CANARD_MSG_TYPE_FROM_ID(txf->id) != UAVCAN_EQUIPMENT_ESC_RAWCOMMAND_ID &&
-                CANARD_MSG_TYPE_FROM_ID(txf->id) != COM_HOBBYWING_ESC_RAWCOMMAND_ID) {
-                // look at next transfer
-                txq = txq->next;
-                if (txq == nullptr) {
-                    break;
-                }
+            uint64_t deadline_us;
+            const AP_HAL::CANFrame *txmsg = tx_queue.peek(iface, raw_commands_only, deadline_us);
+            if (txmsg == nullptr) {
+                break;
+            }
+            if (AP_HAL::micros64() >= deadline_us) {
+                // stale, drop it
+                tx_queue.pop(iface, raw_commands_only, false);
                 continue;
             }
-            AP_HAL::CANFrame txmsg {};
-            txmsg.dlc = AP_HAL::CANFrame::dataLengthToDlc(txf->data_len);
-            memcpy(txmsg.data, txf->data, txf->data_len);
-            txmsg.id = (txf->id | AP_HAL::CANFrame::FlagEFF);
-#if HAL_CANFD_SUPPORTED
-            txmsg.canfd = txf->canfd;
-#endif
             bool write = true;
             bool read = false;
-            ifaces[iface]->select(read, write, &txmsg, 0);
-            if (!write) {
-                // if there is no space then we need to start from the
-                // top of the queue, so wait for the next loop
-                if (!iface_down) {
-                    break;
-                } else {
-                    txf->iface_mask &= ~(1U<<iface);
-                }
-            } else if ((txf->iface_mask & (1U<<iface)) && (AP_HAL::micros64() < txf->deadline_usec)) {
-                // try sending to interfaces, clearing the mask if we succeed
-                if (ifaces[iface]->send(txmsg, txf->deadline_usec, 0) > 0) {
-                    txf->iface_mask &= ~(1U<<iface);
-                } else {
-                    // if we fail to send then we try sending on next interface
-                    if (!iface_down) {
-                        break;
-                    } else {
-                        txf->iface_mask &= ~(1U<<iface);
-                    }
-                }
-            }
-            // look at next transfer
-            txq = txq->next;
-            if (txq == nullptr) {
+            ifaces[iface]->select(read, write, txmsg, 0);
+            if (write && ifaces[iface]->send(*txmsg, deadline_us, 0) > 0) {
+                tx_queue.pop(iface, raw_commands_only, true);
+            } else if (!iface_down) {
+                // no space, so wait for the next loop to try again
                 break;
+            } else {
+                tx_queue.pop(iface, raw_commands_only, false);
             }
         }
     }
 
 }
 
+void CanardInterface::get_tx_stats(ExpandingString &str)
+{
+    WITH_SEMAPHORE(_sem_tx);
+    tx_queue.get_stats(str);
+}
+
 void CanardInterface::update_rx_protocol_stats(int16_t res)
 {
     switch (-res) {
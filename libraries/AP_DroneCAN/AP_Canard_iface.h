@@ -3,6 +3,7 @@
 #if HAL_ENABLE_DRONECAN_DRIVERS
 #include <canard/interface.h>
 #include <dronecan_msgs.h>
+#include "AP_Canard_TxQueue.h"
 
 class AP_DroneCAN;
 class CANSensor;
@@ -63,9 +64,16 @@ public:
 
     void update_rx_protocol_stats(int16_t res);
 
+    // transmit queue depth and latency for each priority
+    void get_tx_stats(ExpandingString &str);
+
     uint8_t get_node_id() const override { return canard.node_id; }
 private:
+    // move frames encoded by libcanard into tx_queue
+    bool queue_tx_frames(int16_t num_frames);
+
     CanardInstance canard;
+    CanardTxQueue tx_queue;
     AP_HAL::CANIface* ifaces[HAL_NUM_CAN_IFACES];
 #if AP_TEST_DRONECAN_DRIVERS
     static CanardInterface* canard_ifaces[3];
@@ -2010,4 +2010,9 @@ bool AP_DroneCAN::write_aux_frame(AP_HAL::CANFrame &out_frame, const uint32_t ti
     return canard_iface.write_aux_frame(out_frame, timeout_us);
 }
 
+void AP_DroneCAN::get_stats(ExpandingString &str)
+{
+    canard_iface.get_tx_stats(str);
+}
+
 #endif // HAL_NUM_CAN_IFACES
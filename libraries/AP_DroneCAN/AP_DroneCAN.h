@@ -98,6 +98,9 @@ public:
 
     // handler for outgoing frames for auxillary drivers
     bool write_aux_frame(AP_HAL::CANFrame &out_frame, const uint32_t timeout_us) override;
+
+    // transmit queue stats
+    void get_stats(ExpandingString &str) override;
     
     uint8_t get_driver_index() const { return _driver_index; }
 
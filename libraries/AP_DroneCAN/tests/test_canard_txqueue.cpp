@@ -0,0 +1,148 @@
+/*
+  test the DroneCAN transmit queue against a simple reference model
+  to build, use:
+    ./waf configure --board sitl --debug
+    ./waf --target tests/test_canard_txqueue
+ */
+#include <AP_gtest.h>
+
+#include <AP_DroneCAN/AP_Canard_TxQueue.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_ENABLE_DRONECAN_DRIVERS && HAL_NUM_CAN_IFACES
+
+#include <vector>
+
+static uint32_t test_rand(uint32_t &seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+// a queued frame, as the reference model keeps it
+struct ModelFrame {
+    uint32_t id;
+    uint64_t deadline_us;
+    uint32_t seq;
+    uint8_t iface_mask;
+    bool raw_command;
+};
+
+/*
+  the frame the queue should send next on an interface: raw commands
+  in the order they were queued, otherwise the first queued of the
+  highest priority, with a raw command winning a tie
+ */
+static int model_next(const std::vector<ModelFrame> &model, uint8_t iface, bool raw_commands_only)
+{
+    int raw = -1;
+    int best = -1;
+    for (uint16_t i=0; i<model.size(); i++) {
+        const ModelFrame &m = model[i];
+        if ((m.iface_mask & (1U<<iface)) == 0) {
+            continue;
+        }
+        if (m.raw_command) {
+            if (raw < 0) {
+                raw = i;
+            }
+        } else if (best < 0 || CanardTxQueue::priority(m.id) < CanardTxQueue::priority(model[best].id)) {
+            best = i;
+        }
+    }
+    if (raw_commands_only || best < 0) {
+        return raw;
+    }
+    if (raw >= 0 && CanardTxQueue::priority(model[raw].id) <= CanardTxQueue::priority(model[best].id)) {
+        return raw;
+    }
+    return best;
+}
+
+TEST(CanardTxQueue, init)
+{
+    CanardTxQueue q;
+    EXPECT_EQ(q.init(25), 25U);
+    EXPECT_EQ(q.space(), 25U);
+
+    uint64_t deadline_us;
+    EXPECT_EQ(q.peek(0, false, deadline_us), nullptr);
+    EXPECT_EQ(q.init(0), 0U);
+    EXPECT_EQ(q.space(), 0U);
+    AP_HAL::CANFrame frame {};
+    EXPECT_FALSE(q.push(frame, 0, 1, false));
+}
+
+TEST(CanardTxQueue, reference_model)
+{
+    CanardTxQueue q;
+    const uint16_t num_frames = q.init(64);
+    ASSERT_EQ(num_frames, 64U);
+    const uint8_t all_ifaces = (1U<<HAL_NUM_CAN_IFACES)-1;
+
+    std::vector<ModelFrame> model;
+    uint32_t seed = 17;
+    uint32_t seq = 0;
+    uint64_t now_us = 0;
+
+    for (uint32_t step=0; step<200000; step++) {
+        now_us += test_rand(seed) % 50;
+        const uint32_t op = test_rand(seed) % 10;
+        if (op < 4) {
+            // queue a frame
+            const ModelFrame m {
+                .id = ((test_rand(seed) % 32) << 24) | (test_rand(seed) % 1000),
+                .deadline_us = now_us + test_rand(seed) % 2000,
+                .seq = seq++,
+                .iface_mask = uint8_t(1 + test_rand(seed) % all_ifaces),
+                .raw_command = test_rand(seed) % 4 == 0,
+            };
+            AP_HAL::CANFrame frame {};
+            frame.id = m.id;
+            memcpy(frame.data, &m.seq, sizeof(m.seq));
+            const bool queued = q.push(frame, m.deadline_us, m.iface_mask, m.raw_command);
+            ASSERT_EQ(queued, model.size() < num_frames);
+            if (queued) {
+                model.push_back(m);
+            }
+        } else if (op < 9) {
+            // send the next frame on an interface
+            const uint8_t iface = test_rand(seed) % HAL_NUM_CAN_IFACES;
+            const bool raw_commands_only = test_rand(seed) % 3 == 0;
+            const int expected = model_next(model, iface, raw_commands_only);
+            uint64_t deadline_us;
+            const AP_HAL::CANFrame *frame = q.peek(iface, raw_commands_only, deadline_us);
+            ASSERT_EQ(frame == nullptr, expected < 0);
+            if (frame == nullptr) {
+                continue;
+            }
+            uint32_t frame_seq;
+            memcpy(&frame_seq, frame->data, sizeof(frame_seq));
+            ASSERT_EQ(frame_seq, model[expected].seq);
+            ASSERT_EQ(deadline_us, model[expected].deadline_us);
+            q.pop(iface, raw_commands_only, test_rand(seed) % 2 == 0);
+            model[expected].iface_mask &= ~(1U<<iface);
+            if (model[expected].iface_mask == 0) {
+                model.erase(model.begin() + expected);
+            }
+        } else {
+            // drop frames past their deadline
+            uint16_t dropped = 0;
+            for (auto it = model.begin(); it != model.end(); ) {
+                if (now_us >= it->deadline_us) {
+                    it = model.erase(it);
+                    dropped++;
+                } else {
+                    it++;
+                }
+            }
+            ASSERT_EQ(q.drop_stale(now_us), dropped);
+        }
+        ASSERT_EQ(q.space() + model.size(), num_frames);
+    }
+}
+
+#endif  // HAL_ENABLE_DRONECAN_DRIVERS && HAL_NUM_CAN_IFACES
+
+AP_GTEST_MAIN()
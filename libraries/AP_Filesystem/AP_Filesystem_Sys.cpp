@@ -37,6 +37,9 @@ static const SysFileList sysfs_file_list[] = {
     {"threads.txt"},
     {"tasks.txt"},
     {"dma.txt"},
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    {"semaphores.txt"},
+#endif
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
@@ -109,6 +112,11 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "dma.txt") == 0) {
         hal.util->dma_info(*r.str);
     }
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    if (strcmp(fname, "semaphores.txt") == 0) {
+        hal.util->semaphore_info(*r.str);
+    }
+#endif
     if (strcmp(fname, "memory.txt") == 0) {
         hal.util->mem_info(*r.str);
     }
@@ -136,6 +144,9 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
         if (hal.can[can_stats_num] != nullptr) {
             hal.can[can_stats_num]->get_stats(*r.str);
         }
+#if HAL_CANMANAGER_ENABLED
+        AP::can().driver_stats(can_stats_num, *r.str);
+#endif
     }
 #endif
     if (strcmp(fname, "persistent.parm") == 0) {
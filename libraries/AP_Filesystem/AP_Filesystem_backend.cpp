@@ -18,6 +18,27 @@
 
 extern const AP_HAL::HAL& hal;
 
+/*
+  write a list of buffers in turn, for backends without a native
+  vectored write. Returns the number of bytes written, stopping at the
+  first short write, or -1 if nothing could be written
+*/
+int32_t AP_Filesystem_Backend::writev(int fd, const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    int32_t total = 0;
+    for (uint8_t i = 0; i < iovcnt; i++) {
+        const int32_t ret = write(fd, iov[i].data, iov[i].len);
+        if (ret <= 0) {
+            return total > 0 ? total : ret;
+        }
+        total += ret;
+        if (uint32_t(ret) < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 /*
   Load a file's contents into memory. Returned object must be `delete`d to free
   the data. The data is guaranteed to be null-terminated such that it can be
@@ -298,6 +298,11 @@
 #define HAL_ENABLE_THREAD_STATISTICS 0
 #endif
 
+// semaphore contention stats in @SYS/semaphores.txt, Linux only
+#ifndef HAL_LINUX_SEMAPHORE_STATS_ENABLED
+#define HAL_LINUX_SEMAPHORE_STATS_ENABLED 0
+#endif
+
 #ifndef AP_STATS_ENABLED
 #define AP_STATS_ENABLED 1
 #endif
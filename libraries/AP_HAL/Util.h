@@ -173,6 +173,11 @@ public:
     // request information on dma contention
     virtual void dma_info(ExpandingString &str) {}
 
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    // request information on semaphore contention
+    virtual void semaphore_info(ExpandingString &str) {}
+#endif
+
     // request information on memory allocation
     virtual void mem_info(ExpandingString &str) {}
 
@@ -0,0 +1,76 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/DSP_RFFT.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_DSP_RFFT_ENABLED
+
+static const uint16_t sample_rate = 1000;
+
+// a pair of tones and some noise, as the gyro would see it
+static void fill_samples(FloatBuffer& samples, uint16_t window_size)
+{
+    for (uint16_t i = 0; i < window_size; i++) {
+        const float t = float(i) / sample_rate;
+        const float s = sinf(2 * M_PI * 83 * t) + 0.3f * sinf(2 * M_PI * 166 * t) + 0.01f * (i % 7);
+        samples.push(s);
+    }
+}
+
+static void BM_DSPHanning(benchmark::State& state)
+{
+    const uint16_t window_size = state.range(0);
+    DSP_RFFT dsp;
+    auto* fft = (DSP_RFFT::FFTWindowStateRFFT*)dsp.fft_init(window_size, sample_rate, 0);
+    FloatBuffer samples(window_size);
+    fill_samples(samples, window_size);
+
+    while (state.KeepRunning()) {
+        // advance of zero keeps the window full
+        dsp.step_hanning(fft, samples, 0);
+        gbenchmark_escape(fft->_rfft_data);
+    }
+    delete fft;
+}
+
+static void BM_DSPRealFFT(benchmark::State& state)
+{
+    const uint16_t window_size = state.range(0);
+    DSP_RFFT dsp;
+    auto* fft = (DSP_RFFT::FFTWindowStateRFFT*)dsp.fft_init(window_size, sample_rate, 0);
+    FloatBuffer samples(window_size);
+    fill_samples(samples, window_size);
+
+    while (state.KeepRunning()) {
+        dsp.step_hanning(fft, samples, 0);
+        dsp.step_fft(fft);
+        gbenchmark_escape(fft->_freq_bins);
+    }
+    delete fft;
+}
+
+static void BM_DSPAnalyse(benchmark::State& state)
+{
+    const uint16_t window_size = state.range(0);
+    DSP_RFFT dsp;
+    auto* fft = dsp.fft_init(window_size, sample_rate, 0);
+    FloatBuffer samples(window_size);
+    fill_samples(samples, window_size);
+
+    while (state.KeepRunning()) {
+        dsp.fft_start(fft, samples, 0);
+        uint16_t bin = dsp.fft_analyse(fft, 1, window_size / 2, 0.5f);
+        gbenchmark_escape(&bin);
+    }
+    delete fft;
+}
+
+BENCHMARK(BM_DSPHanning)->RangeMultiplier(2)->Range(32, 512);
+BENCHMARK(BM_DSPRealFFT)->RangeMultiplier(2)->Range(32, 512);
+BENCHMARK(BM_DSPAnalyse)->RangeMultiplier(2)->Range(32, 512);
+
+#endif // HAL_DSP_RFFT_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,107 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+TEST(ObjectBuffer_MPSC, single_thread)
+{
+    ObjectBuffer_MPSC<uint32_t> buf(5);
+    // size is rounded up to a power of two
+    EXPECT_EQ(buf.get_size(), 8U);
+
+    uint32_t out[16];
+    EXPECT_EQ(buf.pop(out, 16), 0U);
+
+    // fill and empty several times so positions wrap around the slots
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    for (uint8_t lap=0; lap<10; lap++) {
+        while (buf.push(next_push)) {
+            next_push++;
+        }
+        EXPECT_EQ(buf.available(), 8U);
+        EXPECT_EQ(next_push - next_pop, 8U);
+
+        // pop in uneven batches
+        uint32_t n;
+        while ((n = buf.pop(out, 3)) != 0) {
+            for (uint32_t i=0; i<n; i++) {
+                EXPECT_EQ(out[i], next_pop++);
+            }
+        }
+        EXPECT_EQ(buf.available(), 0U);
+        EXPECT_EQ(next_pop, next_push);
+    }
+
+    // an empty buffer accepts nothing
+    ObjectBuffer_MPSC<uint32_t> empty;
+    EXPECT_EQ(empty.get_size(), 0U);
+    EXPECT_FALSE(empty.push(1));
+    EXPECT_EQ(empty.pop(out, 1), 0U);
+}
+
+/*
+  several threads pushing while one pops, retrying when the buffer is
+  full. Every object must be popped exactly once, in the order each
+  thread pushed them
+ */
+TEST(ObjectBuffer_MPSC, multiple_producers)
+{
+    static const uint8_t num_producers = 4;
+    static const uint32_t num_pushes = 20000;
+    ObjectBuffer_MPSC<uint32_t> buf(64);
+
+    std::atomic<uint8_t> producers_running{num_producers};
+    std::thread producers[num_producers];
+    for (uint8_t p=0; p<num_producers; p++) {
+        producers[p] = std::thread([&buf, &producers_running, p]() {
+            for (uint32_t i=0; i<num_pushes; i++) {
+                // producer in the top byte, sequence below
+                while (!buf.push((uint32_t(p) << 24) | i)) {
+                    std::this_thread::yield();
+                }
+            }
+            producers_running--;
+        });
+    }
+
+    uint32_t popped[num_producers] {};
+    int32_t last[num_producers];
+    for (uint8_t p=0; p<num_producers; p++) {
+        last[p] = -1;
+    }
+    bool in_order = true;
+    while (true) {
+        // read before popping, so once all producers are done an
+        // empty pop means every object has been seen
+        const bool done = producers_running == 0;
+        uint32_t out[8];
+        const uint32_t n = buf.pop(out, ARRAY_SIZE(out));
+        if (n == 0) {
+            if (done) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        for (uint32_t i=0; i<n; i++) {
+            const uint8_t p = out[i] >> 24;
+            const int32_t seq = out[i] & 0xFFFFFF;
+            ASSERT_LT(p, num_producers);
+            in_order &= seq > last[p];
+            last[p] = seq;
+            popped[p]++;
+        }
+    }
+    for (uint8_t p=0; p<num_producers; p++) {
+        producers[p].join();
+        EXPECT_EQ(popped[p], num_pushes);
+    }
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(buf.available(), 0U);
+}
+
+AP_GTEST_MAIN()
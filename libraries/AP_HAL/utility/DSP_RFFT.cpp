@@ -0,0 +1,413 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#pragma GCC optimize("O2")
+#endif
+
+#include "DSP_RFFT.h"
+
+#if HAL_DSP_RFFT_ENABLED
+
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define DSP_RFFT_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DSP_RFFT_NEON
+#endif
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  A real input FFT of length N is computed as a complex FFT of length
+  N/2 on the samples packed as z[k] = x[2k] + i*x[2k+1], followed by
+  a split step that recovers the N/2+1 unique bins of the real
+  spectrum. This halves the work of the complex FFT the SITL HAL used
+  to do on zero-imaginary data. Output is laid out as on ChibiOS:
+  _rfft_data holds interleaved re,im for bins 0..N/2 and _freq_bins
+  holds the squared magnitude of each of those bins.
+ */
+
+#if defined(DSP_RFFT_SSE) || defined(DSP_RFFT_NEON)
+/*
+  four complex values held as separate real and imaginary vectors
+ */
+#if defined(DSP_RFFT_SSE)
+typedef __m128 vfloat;
+#else
+typedef float32x4_t vfloat;
+#endif
+
+static inline void load_cmplx4(const float* p, vfloat& re, vfloat& im)
+{
+#if defined(DSP_RFFT_SSE)
+    const __m128 lo = _mm_loadu_ps(p);
+    const __m128 hi = _mm_loadu_ps(p + 4);
+    re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+#else
+    const float32x4x2_t v = vld2q_f32(p);
+    re = v.val[0];
+    im = v.val[1];
+#endif
+}
+
+static inline void store_cmplx4(float* p, vfloat re, vfloat im)
+{
+#if defined(DSP_RFFT_SSE)
+    _mm_storeu_ps(p, _mm_unpacklo_ps(re, im));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(re, im));
+#else
+    float32x4x2_t v;
+    v.val[0] = re;
+    v.val[1] = im;
+    vst2q_f32(p, v);
+#endif
+}
+#endif // DSP_RFFT_SSE || DSP_RFFT_NEON
+
+// initialize the FFT state machine
+AP_HAL::DSP::FFTWindowState* DSP_RFFT::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+{
+    // the real FFT needs a power of two window of at least 8 samples
+    if (window_size < 8 || (window_size & (window_size - 1)) != 0) {
+        return nullptr;
+    }
+    FFTWindowStateRFFT* fft = NEW_NOTHROW FFTWindowStateRFFT(window_size, sample_rate, sliding_window_size);
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr
+        || fft->_stage_twiddle == nullptr || fft->_split_twiddle == nullptr || fft->_bit_reverse == nullptr) {
+        delete fft;
+        return nullptr;
+    }
+    return fft;
+}
+
+// start an FFT analysis
+void DSP_RFFT::fft_start(AP_HAL::DSP::FFTWindowState* state, FloatBuffer& samples, uint16_t advance)
+{
+    step_hanning((FFTWindowStateRFFT*)state, samples, advance);
+}
+
+// perform remaining steps of an FFT analysis
+uint16_t DSP_RFFT::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    FFTWindowStateRFFT* fft = (FFTWindowStateRFFT*)state;
+    step_fft(fft);
+    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(fft, start_bin, end_bin);
+}
+
+// create an instance of the FFT state machine
+DSP_RFFT::FFTWindowStateRFFT::FFTWindowStateRFFT(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+    : AP_HAL::DSP::FFTWindowState::FFTWindowState(window_size, sample_rate, sliding_window_size)
+{
+    if (_freq_bins == nullptr || _hanning_window == nullptr || _rfft_data == nullptr || _derivative_freq_bins == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for DSP");
+        return;
+    }
+
+    // the complex FFT is half the window length
+    const uint16_t n = _bin_count;
+
+    // the twiddles of the stage with half-width h are exp(-2*pi*i*j/(2h)) for j < h,
+    // stored from complex index h-1, so each stage reads its twiddles contiguously
+    _stage_twiddle = NEW_NOTHROW float[2 * n];
+    _split_twiddle = NEW_NOTHROW float[n + 2];
+    _bit_reverse = NEW_NOTHROW uint16_t[n];
+    if (_stage_twiddle == nullptr || _split_twiddle == nullptr || _bit_reverse == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for DSP");
+        return;
+    }
+
+    for (uint16_t h = 1; h < n; h <<= 1) {
+        for (uint16_t j = 0; j < h; j++) {
+            const double a = -M_PI * j / h;
+            _stage_twiddle[2 * (h - 1 + j)] = cos(a);
+            _stage_twiddle[2 * (h - 1 + j) + 1] = sin(a);
+        }
+    }
+
+    // split twiddles are exp(-2*pi*i*k/N) for 0 <= k <= N/4
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        const double a = -M_PI * k / n;
+        _split_twiddle[2 * k] = cos(a);
+        _split_twiddle[2 * k + 1] = sin(a);
+    }
+
+    uint16_t bits = 0;
+    while ((1U << bits) < n) {
+        bits++;
+    }
+    for (uint16_t k = 0; k < n; k++) {
+        uint16_t kr = 0;
+        for (uint16_t b = 0; b < bits; b++) {
+            kr |= ((k >> b) & 1U) << (bits - 1 - b);
+        }
+        _bit_reverse[k] = kr;
+    }
+}
+
+DSP_RFFT::FFTWindowStateRFFT::~FFTWindowStateRFFT()
+{
+    delete[] _stage_twiddle;
+    delete[] _split_twiddle;
+    delete[] _bit_reverse;
+}
+
+// step 1: filter the incoming samples through a Hanning window
+void DSP_RFFT::step_hanning(FFTWindowStateRFFT* fft, FloatBuffer& samples, uint16_t advance)
+{
+    uint32_t read_window = samples.peek(&fft->_freq_bins[0], fft->_window_size);
+    if (read_window != fft->_window_size) {
+        return;
+    }
+    samples.advance(advance);
+    // the windowed real samples are already the packed input of the half length complex FFT
+    mult_f32(&fft->_freq_bins[0], &fft->_hanning_window[0], &fft->_rfft_data[0], fft->_window_size);
+}
+
+// step 2: perform a real FFT on the windowed data
+void DSP_RFFT::step_fft(FFTWindowStateRFFT* fft)
+{
+    calculate_cfft(fft, fft->_rfft_data);
+    split_rfft(fft, fft->_rfft_data);
+    // DC and Nyquist are included, the Nyquist bin is read by step_cmplx_mag()
+    cmplx_mag_squared(fft->_rfft_data, fft->_freq_bins, fft->_num_stored_freqs);
+}
+
+// radix-2 decimation in time complex FFT using the precomputed tables
+void DSP_RFFT::calculate_cfft(FFTWindowStateRFFT* fft, float* data) const
+{
+    const uint16_t n = fft->_bin_count;
+
+    for (uint16_t k = 0; k < n; k++) {
+        const uint16_t kr = fft->_bit_reverse[k];
+        if (kr > k) {
+            const float re = data[2 * k];
+            const float im = data[2 * k + 1];
+            data[2 * k] = data[2 * kr];
+            data[2 * k + 1] = data[2 * kr + 1];
+            data[2 * kr] = re;
+            data[2 * kr + 1] = im;
+        }
+    }
+
+    // first stage has unit twiddles
+    for (uint16_t i = 0; i < 2 * n; i += 4) {
+        const float ar = data[i], ai = data[i + 1];
+        const float br = data[i + 2], bi = data[i + 3];
+        data[i] = ar + br;
+        data[i + 1] = ai + bi;
+        data[i + 2] = ar - br;
+        data[i + 3] = ai - bi;
+    }
+
+    for (uint16_t h = 2; h < n; h <<= 1) {
+        const float* w = &fft->_stage_twiddle[2 * (h - 1)];
+        for (uint16_t i = 0; i < n; i += 2 * h) {
+            float* a = &data[2 * i];
+            float* b = &data[2 * (i + h)];
+            uint16_t j = 0;
+#if defined(DSP_RFFT_SSE) || defined(DSP_RFFT_NEON)
+            for (; j + 4 <= h; j += 4) {
+                vfloat ar, ai, br, bi, wr, wi;
+                load_cmplx4(&a[2 * j], ar, ai);
+                load_cmplx4(&b[2 * j], br, bi);
+                load_cmplx4(&w[2 * j], wr, wi);
+#if defined(DSP_RFFT_SSE)
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+                store_cmplx4(&a[2 * j], _mm_add_ps(ar, tr), _mm_add_ps(ai, ti));
+                store_cmplx4(&b[2 * j], _mm_sub_ps(ar, tr), _mm_sub_ps(ai, ti));
+#else
+                const float32x4_t tr = vmlsq_f32(vmulq_f32(br, wr), bi, wi);
+                const float32x4_t ti = vmlaq_f32(vmulq_f32(br, wi), bi, wr);
+                store_cmplx4(&a[2 * j], vaddq_f32(ar, tr), vaddq_f32(ai, ti));
+                store_cmplx4(&b[2 * j], vsubq_f32(ar, tr), vsubq_f32(ai, ti));
+#endif
+            }
+#endif
+            for (; j < h; j++) {
+                const float wr = w[2 * j], wi = w[2 * j + 1];
+                const float br = b[2 * j], bi = b[2 * j + 1];
+                const float tr = br * wr - bi * wi;
+                const float ti = br * wi + bi * wr;
+                const float ar = a[2 * j], ai = a[2 * j + 1];
+                a[2 * j] = ar + tr;
+                a[2 * j + 1] = ai + ti;
+                b[2 * j] = ar - tr;
+                b[2 * j + 1] = ai - ti;
+            }
+        }
+    }
+}
+
+/*
+  recover the real spectrum X from the half length complex FFT Z:
+    X[k] = Fe[k] + W^k Fo[k]
+    Fe[k] = (Z[k] + conj(Z[n-k])) / 2
+    Fo[k] = -i (Z[k] - conj(Z[n-k])) / 2
+  bins k and n-k are computed together, since X[n-k] = conj(Fe[k] - W^k Fo[k]),
+  which allows the data to be updated in place
+ */
+void DSP_RFFT::split_rfft(FFTWindowStateRFFT* fft, float* data) const
+{
+    const uint16_t n = fft->_bin_count;
+    const float* w = fft->_split_twiddle;
+
+    // DC and Nyquist are real only
+    const float z0r = data[0];
+    const float z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = 0.0f;
+    data[2 * n] = z0r - z0i;
+    data[2 * n + 1] = 0.0f;
+
+    for (uint16_t k = 1; k <= n / 2; k++) {
+        const uint16_t m = n - k;
+        const float ar = data[2 * k], ai = data[2 * k + 1];
+        const float br = data[2 * m], bi = data[2 * m + 1];
+        const float fer = 0.5f * (ar + br);
+        const float fei = 0.5f * (ai - bi);
+        const float for_ = 0.5f * (ai + bi);
+        const float foi = 0.5f * (br - ar);
+        const float wr = w[2 * k], wi = w[2 * k + 1];
+        const float tr = wr * for_ - wi * foi;
+        const float ti = wr * foi + wi * for_;
+        data[2 * k] = fer + tr;
+        data[2 * k + 1] = fei + ti;
+        data[2 * m] = fer - tr;
+        data[2 * m + 1] = ti - fei;
+    }
+}
+
+void DSP_RFFT::cmplx_mag_squared(const float* vin, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+#if defined(DSP_RFFT_SSE)
+    for (; i + 4 <= len; i += 4) {
+        __m128 re, im;
+        load_cmplx4(&vin[2 * i], re, im);
+        _mm_storeu_ps(&vout[i], _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+#elif defined(DSP_RFFT_NEON)
+    for (; i + 4 <= len; i += 4) {
+        float32x4_t re, im;
+        load_cmplx4(&vin[2 * i], re, im);
+        vst1q_f32(&vout[i], vmlaq_f32(vmulq_f32(re, re), im, im));
+    }
+#endif
+    for (; i < len; i++) {
+        vout[i] = sq(vin[2 * i], vin[2 * i + 1]);
+    }
+}
+
+void DSP_RFFT::mult_f32(const float* v1, const float* v2, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+#if defined(DSP_RFFT_SSE)
+    for (; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(&vout[i], _mm_mul_ps(_mm_loadu_ps(&v1[i]), _mm_loadu_ps(&v2[i])));
+    }
+#elif defined(DSP_RFFT_NEON)
+    for (; i + 4 <= len; i += 4) {
+        vst1q_f32(&vout[i], vmulq_f32(vld1q_f32(&v1[i]), vld1q_f32(&v2[i])));
+    }
+#endif
+    for (; i < len; i++) {
+        vout[i] = v1[i] * v2[i];
+    }
+}
+
+// the first index of the maximum is returned, so this stays scalar
+void DSP_RFFT::vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const
+{
+    *max_value = vin[0];
+    *max_index = 0;
+    for (uint16_t i = 1; i < len; i++) {
+        if (vin[i] > *max_value) {
+            *max_value = vin[i];
+            *max_index = i;
+        }
+    }
+}
+
+void DSP_RFFT::vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+#if defined(DSP_RFFT_SSE)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(&vout[i], _mm_mul_ps(_mm_loadu_ps(&vin[i]), s));
+    }
+#elif defined(DSP_RFFT_NEON)
+    for (; i + 4 <= len; i += 4) {
+        vst1q_f32(&vout[i], vmulq_n_f32(vld1q_f32(&vin[i]), scale));
+    }
+#endif
+    for (; i < len; i++) {
+        vout[i] = vin[i] * scale;
+    }
+}
+
+void DSP_RFFT::vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+#if defined(DSP_RFFT_SSE)
+    for (; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(&vout[i], _mm_add_ps(_mm_loadu_ps(&vin1[i]), _mm_loadu_ps(&vin2[i])));
+    }
+#elif defined(DSP_RFFT_NEON)
+    for (; i + 4 <= len; i += 4) {
+        vst1q_f32(&vout[i], vaddq_f32(vld1q_f32(&vin1[i]), vld1q_f32(&vin2[i])));
+    }
+#endif
+    for (; i < len; i++) {
+        vout[i] = vin1[i] + vin2[i];
+    }
+}
+
+float DSP_RFFT::vector_mean_float(const float* vin, uint16_t len) const
+{
+    float mean_value = 0.0f;
+    uint16_t i = 0;
+#if defined(DSP_RFFT_SSE)
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= len; i += 4) {
+        sum = _mm_add_ps(sum, _mm_loadu_ps(&vin[i]));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    mean_value = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(DSP_RFFT_NEON)
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (; i + 4 <= len; i += 4) {
+        sum = vaddq_f32(sum, vld1q_f32(&vin[i]));
+    }
+    const float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    mean_value = vget_lane_f32(pair, 0) + vget_lane_f32(pair, 1);
+#endif
+    for (; i < len; i++) {
+        mean_value += vin[i];
+    }
+    mean_value /= len;
+    return mean_value;
+}
+
+#endif // HAL_DSP_RFFT_ENABLED
@@ -0,0 +1,78 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  real input FFT implementation of AP_HAL::DSP shared by the Linux and
+  SITL HALs, using SSE or NEON where available
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#ifndef HAL_DSP_RFFT_ENABLED
+#define HAL_DSP_RFFT_ENABLED (HAL_WITH_DSP && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
+#if HAL_DSP_RFFT_ENABLED
+
+class DSP_RFFT : public AP_HAL::DSP {
+public:
+    // initialise an FFT instance
+    FFTWindowState* fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size) override;
+    // start an FFT analysis with an ObjectBuffer
+    void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) override;
+    // perform remaining steps of an FFT analysis
+    uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
+
+    // FFT state with precomputed twiddle and bit reversal tables
+    class FFTWindowStateRFFT : public AP_HAL::DSP::FFTWindowState {
+        friend class DSP_RFFT;
+
+    public:
+        FFTWindowStateRFFT(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
+        virtual ~FFTWindowStateRFFT();
+
+    private:
+        // twiddles for each stage of the half length complex FFT, interleaved re,im
+        float* _stage_twiddle = nullptr;
+        // twiddles used to split the half length FFT into the real FFT, interleaved re,im
+        float* _split_twiddle = nullptr;
+        // bit reversed index of each complex sample of the half length FFT
+        uint16_t* _bit_reverse = nullptr;
+    };
+
+    // the individual steps are public so that they can be benchmarked
+
+    // step 1: filter the incoming samples through a Hanning window
+    void step_hanning(FFTWindowStateRFFT* fft, FloatBuffer& samples, uint16_t advance);
+    // step 2: perform a real FFT on the windowed data
+    void step_fft(FFTWindowStateRFFT* fft);
+
+protected:
+    void vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const override;
+    void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
+    float vector_mean_float(const float* vin, uint16_t len) const override;
+    void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
+
+private:
+    void mult_f32(const float* v1, const float* v2, float* vout, uint16_t len) const;
+    // squared magnitude of len interleaved complex values
+    void cmplx_mag_squared(const float* vin, float* vout, uint16_t len) const;
+    // in-place complex FFT of length fft->_bin_count on interleaved data
+    void calculate_cfft(FFTWindowStateRFFT* fft, float* data) const;
+    // convert the half length complex FFT into the spectrum of the real input
+    void split_rfft(FFTWindowStateRFFT* fft, float* data) const;
+};
+
+#endif // HAL_DSP_RFFT_ENABLED
@@ -461,6 +461,126 @@ private:
     HAL_Semaphore sem;
 };
 
+/*
+  Lock free ring buffer for objects of fixed size, with any number of
+  threads pushing and a single thread popping.
+
+  Each slot carries a sequence number recording whether it is free for
+  the push claiming that position, or holds the object for the pop at
+  that position. Producers claim positions with a compare and swap on
+  the tail, so a push never waits on a lock, and a slot only becomes
+  readable once its object is fully written. The size is rounded up to
+  a power of two and must be set before the buffer is shared.
+ */
+template <class T>
+class ObjectBuffer_MPSC {
+public:
+    ObjectBuffer_MPSC(uint32_t _size = 0) {
+        set_size(_size);
+    }
+    ~ObjectBuffer_MPSC(void) {
+        delete[] slots;
+    }
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const {
+        return slots != nullptr ? mask + 1 : 0;
+    }
+
+    // set size of ringbuffer, discarding its contents. Not thread safe
+    bool set_size(uint32_t size) {
+        delete[] slots;
+        slots = nullptr;
+        mask = 0;
+        head.store(0);
+        tail.store(0);
+        if (size == 0) {
+            return true;
+        }
+        uint32_t n = 1;
+        while (n < size) {
+            n <<= 1;
+        }
+        slots = NEW_NOTHROW Slot[n];
+        if (slots == nullptr) {
+            return false;
+        }
+        mask = n - 1;
+        for (uint32_t i=0; i<n; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // return number of objects waiting to be popped. Objects whose
+    // push is still in progress are counted
+    uint32_t available(void) const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+
+    // push one object onto the back of the queue, returning false if it is full.
+    // Safe to call from any number of threads at once
+    bool push(const T &object) {
+        if (slots == nullptr) {
+            return false;
+        }
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[pos & mask];
+            const int32_t diff = int32_t(slot->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                // slot is free, try to claim it. On failure pos holds the new tail
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // slot still holds the object pushed a lap ago
+                return false;
+            } else {
+                // another thread claimed this position
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->object = object;
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pop up to n objects off the front of the queue, returning the
+    // number popped. Only one thread may pop
+    uint32_t pop(T *objects, uint32_t n) WARN_IF_UNUSED {
+        if (slots == nullptr) {
+            return 0;
+        }
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        uint32_t count = 0;
+        while (count < n) {
+            Slot &slot = slots[pos & mask];
+            if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+                // empty, or the next push has not finished writing
+                break;
+            }
+            objects[count++] = slot.object;
+            // free the slot for the push one lap ahead
+            slot.seq.store(pos + mask + 1, std::memory_order_release);
+            pos++;
+        }
+        head.store(pos, std::memory_order_relaxed);
+        return count;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T object;
+    };
+    Slot *slots = nullptr;
+    uint32_t mask;
+    std::atomic<uint32_t> head{0}; // next position to pop
+    std::atomic<uint32_t> tail{0}; // next position to push
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
@@ -37,6 +37,10 @@
 #include <sys/time.h>
 #include <net/if.h>
 #include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <time.h>
 #include <cstring>
 #include "Scheduler.h"
 #include <AP_CANManager/AP_CANManager.h>
@@ -124,8 +128,19 @@ int CANIface::_openSocket(const std::string& iface_name)
     // Configure
     {
         const int on = 1;
-        // Timestamping
-        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+        // Timestamping, of the kernel's receive time and of the
+        // controller's where it can provide them
+        {
+            auto hwts = hwtstamp_config();
+            hwts.rx_filter = HWTSTAMP_FILTER_ALL;
+            ifr.ifr_data = reinterpret_cast<char*>(&hwts);
+            // not an error if the controller doesn't support it
+            (void)ioctl(s, SIOCSHWTSTAMP, &ifr);
+        }
+        const int ts_flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                             SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) < 0 &&
+            setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
             return -1;
         }
         // Socket loopback
@@ -228,6 +243,7 @@ bool CANIface::configureFilters(const CanFilterConfig* const filter_configs,
     if (filter_configs == nullptr || mode_ != FilteredMode) {
         return false;
     }
+    WITH_SEMAPHORE(sem);
     _hw_filters_container.clear();
     _hw_filters_container.resize(num_configs);
 
@@ -248,12 +264,60 @@ bool CANIface::configureFilters(const CanFilterConfig* const filter_configs,
             _hw_filters_container[i].can_mask |= CAN_RTR_FLAG;
         }
     }
+    _installKernelFilters();
 
     return true;
 }
 
+/*
+  have the kernel drop the frames that don't pass the filters, rather
+  than reading them all to drop them here. Without filters the kernel
+  is set back to passing all frames
+ */
+void CANIface::_installKernelFilters()
+{
+    _kernel_filters = false;
+    // frames already in the socket were counted against the old
+    // filters and may never be echoed under the new ones, so don't
+    // let them hold up transmission
+    _frames_in_socket_tx_queue = 0;
+    if (_fd < 0) {
+        // installed once the socket is open
+        return;
+    }
+    if (_hw_filters_container.empty()) {
+        const can_filter pass_all {};
+        (void)setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER, &pass_all, sizeof(pass_all));
+        return;
+    }
+    _kernel_filters = setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER,
+                                 _hw_filters_container.data(),
+                                 _hw_filters_container.size() * sizeof(can_filter)) == 0;
+    if (!_kernel_filters) {
+        Debug("Iface %d kernel filters failed, filtering here", _fd);
+    }
+}
+
+/*
+  true if the kernel will echo a frame we send back to us. Kernel
+  filters apply to our own frames too, so those that don't pass them
+  are never echoed
+ */
+bool CANIface::_isEchoed(const can_frame& frame) const
+{
+    if (!_kernel_filters) {
+        return true;
+    }
+    for (auto& f : _hw_filters_container) {
+        if (((frame.can_id ^ f.can_id) & f.can_mask) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
- * SocketCAN emulates the CAN filters in software, so the number of filters is virtually unlimited.
+ * SocketCAN implements the CAN filters in the kernel, so the number of filters is virtually unlimited.
  * This method returns a constant value.
  */
 static constexpr unsigned NumFilters = CAN_FILTER_NUMBER;
@@ -268,132 +332,234 @@ uint32_t CANIface::getErrorCount() const
 
 void CANIface::_pollWrite()
 {
+    WITH_SEMAPHORE(sem);
     while (_hasReadyTx()) {
-        WITH_SEMAPHORE(sem);
-        const CanTxItem tx = _tx_queue.top();
-        uint64_t curr_time = AP_HAL::micros64();
-        if (tx.deadline >= curr_time) {
-            // hal.console->printf("%x TDEAD: %lu CURRT: %lu DEL: %lu\n",tx.frame.id,  tx.deadline, curr_time, tx.deadline-curr_time);
-            const int res = _write(tx.frame);
-            if (res == 1) {                   // Transmitted successfully
-                _incrementNumFramesInSocketTxQueue();
-                if (tx.loopback) {
-                    _pending_loopback_ids.insert(tx.frame.id);
+        // take the frames that fit in the socket's queue, in priority
+        // order, to send with one call. Frames the kernel won't echo
+        // back don't take up room as they are never confirmed
+        CanTxItem items[CAN_TX_BATCH];
+        can_frame frames[CAN_TX_BATCH];
+        uint8_t num_items = 0;
+        unsigned in_socket = _frames_in_socket_tx_queue;
+        const uint64_t curr_time = AP_HAL::micros64();
+        while (num_items < CAN_TX_BATCH && !_tx_queue.empty() &&
+               in_socket < _max_frames_in_socket_tx_queue) {
+            const CanTxItem& tx = _tx_queue.top();
+            if (tx.deadline >= curr_time) {
+                items[num_items] = tx;
+                frames[num_items] = makeSocketCanFrame(tx.frame);
+                if (_isEchoed(frames[num_items])) {
+                    in_socket++;
+                }
+                num_items++;
+            } else {
+                stats.tx_timedout++;
+            }
+            (void)_tx_queue.pop();
+        }
+        if (num_items == 0) {
+            break;
+        }
+
+        const int res = _write(frames, num_items);
+        // a rejected frame is removed from the queue, like a sent one
+        const uint8_t num_done = res < 0 ? 1 : res;
+        if (res < 0) {                        // Transmission error
+            stats.tx_rejected++;
+        } else {
+            for (uint8_t i = 0; i < num_done; i++) {
+                if (_isEchoed(frames[i])) {
+                    _incrementNumFramesInSocketTxQueue();
+                    if (items[i].loopback) {
+                        _pending_loopback_ids.insert(items[i].frame.id);
+                    }
+                } else if (items[i].loopback) {
+                    // the kernel won't echo it, so loop it back now
+                    CanRxItem rx;
+                    rx.frame = items[i].frame;
+                    rx.timestamp_us = curr_time;
+                    rx.flags = Loopback;
+                    _rx_queue.push(rx);
                 }
                 stats.tx_success++;
                 stats.last_transmit_us = curr_time;
-            } else if (res == 0) {            // Not transmitted, nor is it an error
-                stats.tx_overflow++;
-                break;                        // Leaving the loop, the frame remains enqueued for the next retry
-            } else {                          // Transmission error
-                stats.tx_rejected++;
             }
-        } else {
-            // hal.console->printf("TDEAD: %lu CURRT: %lu DEL: %lu\n", tx.deadline, curr_time, curr_time-tx.deadline);
-            stats.tx_timedout++;
         }
 
-        // Removing the frame from the queue even if transmission failed
-        (void)_tx_queue.pop();
+        // frames not sent remain enqueued for the next retry
+        for (uint8_t i = num_done; i < num_items; i++) {
+            _tx_queue.push(items[i]);
+        }
+        if (res == 0) {                       // Not transmitted, nor is it an error
+            stats.tx_overflow++;
+            break;
+        }
     }
 }
 
 bool CANIface::_pollRead()
 {
+    // _read() checks the filters, which configureFilters() may be changing
+    WITH_SEMAPHORE(sem);
+    bool received = false;
     uint8_t iterations_count = 0;
     while (iterations_count < CAN_MAX_POLL_ITERATIONS_COUNT)
     {
         iterations_count++;
-        CanRxItem rx;
-        rx.timestamp_us = AP_HAL::micros64();  // Monotonic timestamp is not required to be precise (unlike UTC)
-        bool loopback = false;
-        const int res = _read(rx.frame, rx.timestamp_us, loopback);
-        if (res == 1) {
+        CanRxItem items[CAN_RX_BATCH];
+        bool loopback[CAN_RX_BATCH];
+        uint8_t num_items;
+        const int res = _read(items, loopback, num_items);
+        if (res < 0) {
+            stats.rx_errors++;
+            break;
+        }
+        for (uint8_t i = 0; i < num_items; i++) {
             bool accept = true;
-            if (loopback) {           // We receive loopback for all CAN frames
+            if (loopback[i]) {        // We receive loopback for all CAN frames
                 _confirmSentFrame();
-                rx.flags |= Loopback;
-                accept = _wasInPendingLoopbackSet(rx.frame);
+                items[i].flags |= Loopback;
+                accept = _wasInPendingLoopbackSet(items[i].frame);
                 stats.tx_confirmed++;
             }
             if (accept) {
-                WITH_SEMAPHORE(sem);
-                _rx_queue.push(rx);
+                _rx_queue.push(items[i]);
                 stats.rx_received++;
-                return true;
+                received = true;
             }
-        } else if (res == 0) {
-            break;
-        } else {
-            stats.rx_errors++;
+        }
+        if (res < CAN_RX_BATCH) {
+            // the socket has been emptied
             break;
         }
     }
-    return false;
+    return received;
 }
 
-int CANIface::_write(const AP_HAL::CANFrame& frame) const
+/*
+  send frames with one call, returning the number sent. Returns 0 if
+  the first frame can't be sent at the moment, or negative if it was
+  rejected
+ */
+int CANIface::_write(const can_frame* frames, const uint8_t num_frames) const
 {
     if (_fd < 0) {
         return -1;
     }
     errno = 0;
 
-    const can_frame sockcan_frame = makeSocketCanFrame(frame);
+    iovec iov[CAN_TX_BATCH];
+    mmsghdr msgs[CAN_TX_BATCH] {};
+    for (uint8_t i = 0; i < num_frames; i++) {
+        iov[i].iov_base = const_cast<can_frame*>(&frames[i]);
+        iov[i].iov_len  = sizeof(can_frame);
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
-    const int res = write(_fd, &sockcan_frame, sizeof(sockcan_frame));
+    const int res = sendmmsg(_fd, msgs, num_frames, MSG_DONTWAIT);
     if (res <= 0) {
         if (errno == ENOBUFS || errno == EAGAIN) {  // Writing is not possible atm, not an error
             return 0;
         }
-        return res;
+        return res < 0 ? res : -1;
     }
-    if (res != sizeof(sockcan_frame)) {
-        return -1;
-    }
-    return 1;
+    return res;
 }
 
-
-int CANIface::_read(AP_HAL::CANFrame& frame, uint64_t& timestamp_us, bool& loopback) const
+/*
+  read the frames waiting on the socket with one call, filling items
+  with those that pass the filters. Returns the number of frames
+  read, or negative on error
+ */
+int CANIface::_read(CanRxItem* items, bool* loopback, uint8_t& num_items)
 {
+    num_items = 0;
     if (_fd < 0) {
         return -1;
     }
-    auto iov = iovec();
-    auto sockcan_frame = can_frame();
-    iov.iov_base = &sockcan_frame;
-    iov.iov_len  = sizeof(sockcan_frame);
+    can_frame frames[CAN_RX_BATCH];
+    iovec iov[CAN_RX_BATCH];
     union {
-        uint8_t data[CMSG_SPACE(sizeof(::timeval))];
+        uint8_t data[CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(::timeval))];
         struct cmsghdr align;
-    } control;
-
-    auto msg = msghdr();
-    msg.msg_iov    = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = control.data;
-    msg.msg_controllen = sizeof(control.data);
-
-    const int res = recvmsg(_fd, &msg, MSG_DONTWAIT);
+    } control[CAN_RX_BATCH];
+    mmsghdr msgs[CAN_RX_BATCH] {};
+    for (uint8_t i = 0; i < CAN_RX_BATCH; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len  = sizeof(can_frame);
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].data;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].data);
+    }
+
+    const int res = recvmmsg(_fd, msgs, CAN_RX_BATCH, MSG_DONTWAIT, nullptr);
     if (res <= 0) {
         return (res < 0 && errno == EWOULDBLOCK) ? 0 : res;
     }
-    /*
-     * Flags
-     */
-    loopback = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
 
-    if (!loopback && !_checkHWFilters(sockcan_frame)) {
-        return 0;
+    const uint64_t now_us = AP_HAL::micros64();
+    struct timespec realtime_now;
+    clock_gettime(CLOCK_REALTIME, &realtime_now);
+    const uint64_t realtime_now_us = realtime_now.tv_sec * 1000000ULL + realtime_now.tv_nsec / 1000U;
+
+    for (uint8_t i = 0; i < res; i++) {
+        const msghdr& msg = msgs[i].msg_hdr;
+        /*
+         * Flags
+         */
+        loopback[num_items] = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
+
+        if (!loopback[num_items] && !_kernel_filters && !_checkHWFilters(frames[i])) {
+            continue;
+        }
+
+        CanRxItem& rx = items[num_items++];
+        rx.frame = makeUavcanFrame(frames[i]);
+        /*
+         * Timestamp
+         */
+        rx.timestamp_us = _getRxTimestamp(msg, now_us, realtime_now_us);
     }
+    return res;
+}
 
-    frame = makeUavcanFrame(sockcan_frame);
-    /*
-     * Timestamp
-     */
-    timestamp_us = AP_HAL::micros64();
-    return 1;
+/*
+  time a frame was received in the AP_HAL::micros64() time domain. The
+  controller's timestamp is preferred, then the kernel's, then now as
+  the frames were read
+ */
+uint64_t CANIface::_getRxTimestamp(const msghdr& msg, const uint64_t now_us, const uint64_t realtime_now_us)
+{
+    uint64_t realtime_us = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            if (ts.ts[2].tv_sec != 0 || ts.ts[2].tv_nsec != 0) {
+                stats.num_rx_hw_timestamps++;
+                const uint64_t hw_us = ts.ts[2].tv_sec * 1000000ULL + ts.ts[2].tv_nsec / 1000U;
+                return _hw_timestamp_correction.correct_offboard_timestamp_usec(hw_us, now_us);
+            }
+            realtime_us = ts.ts[0].tv_sec * 1000000ULL + ts.ts[0].tv_nsec / 1000U;
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+            ::timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            realtime_us = tv.tv_sec * 1000000ULL + tv.tv_usec;
+        }
+    }
+    // the kernel's timestamps are in wall clock time, which may have
+    // been stepped since
+    if (realtime_us != 0 && realtime_us <= realtime_now_us &&
+        realtime_now_us - realtime_us < MIN(now_us, 1000000ULL)) {
+        return now_us - (realtime_now_us - realtime_us);
+    }
+    return now_us;
 }
 
 // Might block forever, only to be used for testing
@@ -481,6 +647,7 @@ bool CANIface::init(const uint32_t bitrate, const OperatingMode mode)
     if (_fd > 0) {
         _bitrate = bitrate;
         _initialized = true;
+        _installKernelFilters();
     } else {
         _initialized = false;
     }
@@ -553,7 +720,8 @@ void CANIface::get_stats(ExpandingString &str)
                "num_tx_poll_req:  %u\n"
                "num_poll_waits:   %u\n"
                "num_poll_tx_events: %u\n"
-               "num_poll_rx_events: %u\n",
+               "num_poll_rx_events: %u\n"
+               "num_rx_hw_timestamps: %u\n",
                stats.tx_requests,
                stats.tx_rejected,
                stats.tx_overflow,
@@ -567,7 +735,8 @@ void CANIface::get_stats(ExpandingString &str)
                stats.num_tx_poll_req,
                stats.num_poll_waits,
                stats.num_poll_tx_events,
-               stats.num_poll_rx_events);
+               stats.num_poll_rx_events,
+               stats.num_rx_hw_timestamps);
 }
 
 #endif
@@ -31,8 +31,10 @@
 #if HAL_NUM_CAN_IFACES
 
 #include <AP_HAL/CANIface.h>
+#include <AP_RTC/JitterCorrection.h>
 
 #include <linux/can.h>
+#include <sys/socket.h>
 
 #include <string>
 #include <queue>
@@ -53,6 +55,9 @@ enum class SocketCanError
 #define CAN_MAX_POLL_ITERATIONS_COUNT 100
 #define CAN_MAX_INIT_TRIES_COUNT 100
 #define CAN_FILTER_NUMBER 8
+// frames moved by each recvmmsg() and sendmmsg()
+#define CAN_RX_BATCH 16
+#define CAN_TX_BATCH 8
 
 class CANIface: public AP_HAL::CANIface {
 public:
@@ -120,9 +125,11 @@ private:
 
     bool _pollRead();
 
-    int _write(const AP_HAL::CANFrame& frame) const;
+    int _write(const can_frame* frames, uint8_t num_frames) const;
 
-    int _read(AP_HAL::CANFrame& frame, uint64_t& ts_usec, bool& loopback) const;
+    int _read(CanRxItem* items, bool* loopback, uint8_t& num_items);
+
+    uint64_t _getRxTimestamp(const msghdr& msg, uint64_t now_us, uint64_t realtime_now_us);
 
     void _incrementNumFramesInSocketTxQueue();
 
@@ -132,6 +139,10 @@ private:
 
     bool _checkHWFilters(const can_frame& frame) const;
 
+    void _installKernelFilters();
+
+    bool _isEchoed(const can_frame& frame) const;
+
     bool _hasReadyTx();
 
     bool _hasReadyRx();
@@ -162,6 +173,11 @@ private:
     std::queue<CanRxItem> _rx_queue;
     std::unordered_multiset<uint32_t> _pending_loopback_ids;
     std::vector<can_filter> _hw_filters_container;
+    // true when the kernel applies _hw_filters_container, which
+    // also stops it echoing our frames that don't pass them
+    bool _kernel_filters;
+    // hardware timestamps are in the controller's time domain
+    JitterCorrection _hw_timestamp_correction{100, 100};
 
     struct bus_stats : public AP_HAL::CANIface::bus_stats_t {
         uint32_t tx_confirmed;
@@ -171,6 +187,7 @@ private:
         uint32_t num_poll_waits;
         uint32_t num_poll_tx_events;
         uint32_t num_poll_rx_events;
+        uint32_t num_rx_hw_timestamps;
     } stats;
 
 protected:
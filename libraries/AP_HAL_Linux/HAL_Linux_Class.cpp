@@ -8,6 +8,7 @@
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/DSP_RFFT.h>
 #include <AP_HAL/utility/RCOutput_Tap.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
@@ -231,7 +232,7 @@ static Empty::OpticalFlow opticalFlow;
 #endif
 
 #if HAL_WITH_DSP
-static Empty::DSP dspDriver;
+static DSP_RFFT dspDriver;
 #endif
 static Empty::Flash flashDriver;
 static Empty::WSPIDeviceManager wspi_mgr_instance;
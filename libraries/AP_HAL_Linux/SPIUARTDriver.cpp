@@ -139,6 +139,50 @@ int SPIUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
     return n;
 }
 
+/*
+  SPI transfers go through _write_fd() and _read_fd() one segment at a
+  time, as the SPI device can't do vectored transfers
+ */
+ssize_t SPIUARTDriver::_writev_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    if (_external) {
+        return UARTDriver::_writev_fd(iov, iovcnt);
+    }
+
+    ssize_t total = 0;
+    for (uint8_t i = 0; i < iovcnt; i++) {
+        const int ret = _write_fd(iov[i].data, iov[i].len);
+        if (ret <= 0) {
+            break;
+        }
+        total += ret;
+        if ((uint32_t)ret < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t SPIUARTDriver::_readv_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    if (_external) {
+        return UARTDriver::_readv_fd(iov, iovcnt);
+    }
+
+    ssize_t total = 0;
+    for (uint8_t i = 0; i < iovcnt; i++) {
+        const int ret = _read_fd(iov[i].data, iov[i].len);
+        if (ret <= 0) {
+            break;
+        }
+        total += ret;
+        if ((uint32_t)ret < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 void SPIUARTDriver::_timer_tick(void)
 {
     if (_external) {
@@ -18,6 +18,8 @@ public:
 protected:
     int _write_fd(const uint8_t *buf, uint16_t n) override;
     int _read_fd(uint8_t *buf, uint16_t n) override;
+    ssize_t _writev_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt) override;
+    ssize_t _readv_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt) override;
 
     AP_HAL::OwnPtr<AP_HAL::SPIDevice> _dev;
 
@@ -5,6 +5,7 @@
 #include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/epoll.h>
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -294,6 +295,28 @@ void Scheduler::_uart_task()
     _run_uarts();
 }
 
+bool Scheduler::register_uart_pollable(Pollable *p)
+{
+    if (!_uart_poller) {
+        return false;
+    }
+    return _uart_poller.register_pollable(p, EPOLLIN);
+}
+
+void Scheduler::unregister_uart_pollable(const Pollable *p)
+{
+    _uart_poller.unregister_pollable(p);
+}
+
+void Scheduler::uart_tx_kick()
+{
+    // one wakeup per burst of writes, the UART thread clears the flag
+    // before it looks at the transmit buffers
+    if (_uart_poller && !_uart_kick_pending.exchange(true)) {
+        _uart_poller.wakeup();
+    }
+}
+
 void Scheduler::_io_task()
 {
     // process any pending storage writes
@@ -359,6 +382,60 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+/*
+  like PeriodicThread::_run(), but sleeping in the UART poller so that
+  received data and transmit kicks are serviced without waiting for
+  the next period. The periodic tick still runs for UARTs that can't
+  be polled, such as SPI UARTs and the console
+ */
+bool Scheduler::UARTThread::_run()
+{
+    _sched._wait_all_threads();
+
+    if (_period_usec == 0) {
+        return false;
+    }
+
+    uint64_t next_run_usec = AP_HAL::micros64() + _period_usec;
+
+    while (!_should_exit) {
+        uint64_t now_usec = AP_HAL::micros64();
+        if (next_run_usec > now_usec) {
+            const uint64_t dt = next_run_usec - now_usec;
+            if (_sched._uart_poller) {
+                _sched._uart_poller.poll((dt + 999) / 1000);
+            } else {
+                _sched.microsleep(dt);
+            }
+            now_usec = AP_HAL::micros64();
+        }
+        if (now_usec >= next_run_usec) {
+            next_run_usec += _period_usec;
+            if (next_run_usec <= now_usec) {
+                // we've lost sync - restart
+                next_run_usec = now_usec + _period_usec;
+            }
+        }
+
+        _sched._uart_kick_pending = false;
+        _task();
+    }
+
+    _started = false;
+    _should_exit = false;
+
+    return true;
+}
+
+bool Scheduler::UARTThread::stop()
+{
+    if (!PeriodicThread::stop()) {
+        return false;
+    }
+    _sched._uart_poller.wakeup();
+    return true;
+}
+
 void Scheduler::teardown()
 {
     _timer_thread.stop();
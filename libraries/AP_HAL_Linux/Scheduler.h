@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <pthread.h>
 
 #include "AP_HAL_Linux.h"
 
+#include "Poller.h"
 #include "Semaphores.h"
 #include "Thread.h"
 
@@ -60,6 +62,17 @@ public:
      */
     void set_cpu_affinity(const cpu_set_t &cpu_affinity) { _cpu_affinity = cpu_affinity; }
 
+    /*
+      UART receive descriptors registered here are read by the UART
+      thread as soon as they become readable, rather than on its next
+      periodic tick
+     */
+    bool register_uart_pollable(Pollable *p);
+    void unregister_uart_pollable(const Pollable *p);
+
+    // wake the UART thread to push out bytes queued for transmit
+    void uart_tx_kick();
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -74,6 +87,20 @@ private:
         Scheduler &_sched;
     };
 
+    /*
+      the UART thread waits on _uart_poller between its periodic ticks,
+      so reads and transmit kicks are handled as they happen
+     */
+    class UARTThread : public SchedulerThread {
+    public:
+        using SchedulerThread::SchedulerThread;
+
+        bool stop() override;
+
+    protected:
+        bool _run() override;
+    };
+
     void     init_realtime();
 
     void     init_cpu_affinity();
@@ -101,7 +128,7 @@ private:
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
     SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    UARTThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
 
     void _timer_task();
     void _io_task();
@@ -117,6 +144,9 @@ private:
 
     Semaphore _io_semaphore;
     cpu_set_t _cpu_affinity;
+
+    Poller _uart_poller;
+    std::atomic<bool> _uart_kick_pending;
 };
 
 }
@@ -2,10 +2,36 @@
 
 #include "Semaphores.h"
 
+#include <AP_Common/ExpandingString.h>
+#include <AP_Math/AP_Math.h>
+#include <errno.h>
+
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
 
+// pthread_mutex_clocklock() lets a timed take wait against the
+// monotonic clock, which set_hw_rtc() can't step
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 30)
+#define HAVE_PTHREAD_MUTEX_CLOCKLOCK 1
+#endif
+#endif
+#ifndef HAVE_PTHREAD_MUTEX_CLOCKLOCK
+#define HAVE_PTHREAD_MUTEX_CLOCKLOCK 0
+#endif
+
+// where clocklock can't be used, wait against the realtime clock in
+// slices of at most this long, checking the deadline with micros64()
+// after each
+#define SEMAPHORE_TIMEDLOCK_SLICE_US 10000U
+
+#if HAVE_PTHREAD_MUTEX_CLOCKLOCK
+// set once clocklock has been refused, as it will be for every
+// semaphore on this system
+static bool clocklock_unsupported;
+#endif
+
 // construct a semaphore
 Semaphore::Semaphore()
 {
@@ -16,33 +42,187 @@ Semaphore::Semaphore()
     pthread_mutex_init(&_lock, &attr);
 }
 
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+Semaphore::~Semaphore()
+{
+    // don't leave semaphore_info() a dangling pointer
+    pthread_mutex_lock(&_list_lock);
+    for (Semaphore **p = &_contended_list; *p != nullptr; p = &(*p)->_next_contended) {
+        if (*p == this) {
+            *p = _next_contended;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_list_lock);
+}
+#endif
+
 bool Semaphore::give()
 {
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    if (_depth > 0 && --_depth == 0 && _track_hold) {
+        const uint32_t hold_us = AP_HAL::micros64() - _taken_us;
+        _stats.hold_us += hold_us;
+        _stats.max_hold_us = MAX(_stats.max_hold_us, hold_us);
+    }
+#endif
     return pthread_mutex_unlock(&_lock) == 0;
 }
 
 bool Semaphore::take(uint32_t timeout_ms)
 {
-    if (timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
-        return pthread_mutex_lock(&_lock) == 0;
-    }
     if (take_nonblocking()) {
         return true;
     }
-    uint64_t start = AP_HAL::micros64();
-    do {
-        hal.scheduler->delay_microseconds(200);
-        if (take_nonblocking()) {
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    const uint64_t wait_start_us = AP_HAL::micros64();
+#endif
+    bool ret;
+    if (timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
+        ret = pthread_mutex_lock(&_lock) == 0;
+    } else {
+        // sleep in the kernel until the owner gives the lock or the
+        // timeout expires, rather than polling for it
+        ret = timedlock(timeout_ms);
+    }
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    contended(wait_start_us, !ret, __builtin_return_address(0));
+    if (ret) {
+        taken();
+    }
+#endif
+    return ret;
+}
+
+/*
+  wait up to timeout_ms for the lock, measured on the monotonic clock
+ */
+bool Semaphore::timedlock(uint32_t timeout_ms)
+{
+    const uint64_t deadline_us = AP_HAL::micros64() + timeout_ms * 1000ULL;
+#if HAVE_PTHREAD_MUTEX_CLOCKLOCK
+    if (!clocklock_unsupported) {
+        struct timespec ts;
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+            return false;
+        }
+        ts.tv_sec += timeout_ms/1000U;
+        ts.tv_nsec += (timeout_ms % 1000U) * 1000000UL;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        const int err = pthread_mutex_clocklock(&_lock, CLOCK_MONOTONIC, &ts);
+        if (err == 0) {
             return true;
         }
-    } while ((AP_HAL::micros64() - start) < timeout_ms*1000);
-    return false;
+        if (err == ETIMEDOUT) {
+            return false;
+        }
+        if (err == EINVAL || err == ENOTSUP) {
+            // glibc before 2.35, or a kernel without FUTEX_LOCK_PI2,
+            // can't wait on a priority inheritance mutex against the
+            // monotonic clock
+            clocklock_unsupported = true;
+        }
+    }
+#endif
+    while (true) {
+        const uint64_t now_us = AP_HAL::micros64();
+        if (now_us >= deadline_us) {
+            return false;
+        }
+        const uint32_t slice_us = MIN(deadline_us - now_us, uint64_t(SEMAPHORE_TIMEDLOCK_SLICE_US));
+        struct timespec ts;
+        if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+            return false;
+        }
+        ts.tv_nsec += slice_us * 1000UL;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        const int err = pthread_mutex_timedlock(&_lock, &ts);
+        if (err == 0) {
+            return true;
+        }
+        if (err != ETIMEDOUT) {
+            return false;
+        }
+    }
 }
 
 bool Semaphore::take_nonblocking()
 {
-    return pthread_mutex_trylock(&_lock) == 0;
+    if (pthread_mutex_trylock(&_lock) != 0) {
+        return false;
+    }
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    taken();
+#endif
+    return true;
+}
+
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+Semaphore *Semaphore::_contended_list;
+pthread_mutex_t Semaphore::_list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void Semaphore::taken()
+{
+    _stats.takes++;
+    if (_depth++ == 0 && _track_hold) {
+        _taken_us = AP_HAL::micros64();
+    }
+}
+
+void Semaphore::contended(uint64_t wait_start_us, bool timed_out, const void *caller)
+{
+    const uint32_t wait_us = AP_HAL::micros64() - wait_start_us;
+
+    // contention is the slow path already, so share one lock for the
+    // counters of threads that may not hold this semaphore
+    pthread_mutex_lock(&_list_lock);
+    if (_first_caller == nullptr) {
+        _first_caller = caller;
+        _next_contended = _contended_list;
+        _contended_list = this;
+    }
+    _stats.contended++;
+    if (timed_out) {
+        _stats.timeouts++;
+    }
+    _stats.wait_us += wait_us;
+    _stats.max_wait_us = MAX(_stats.max_wait_us, wait_us);
+    pthread_mutex_unlock(&_list_lock);
+}
+
+/*
+  list semaphores that have been contended, with the return address
+  of their first contended take. Counters are totals since boot, as
+  the owner updates some of them under its own lock
+ */
+void Semaphore::semaphore_info(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("SemV1\n");
+
+    pthread_mutex_lock(&_list_lock);
+    for (Semaphore *sem = _contended_list; sem != nullptr; sem = sem->_next_contended) {
+        auto &st = sem->_stats;
+        if (st.contended == 0) {
+            continue;
+        }
+        str.printf("SEM=%p CALLER=%p TAKE=%8u CONT=%8u (%4.1f%%) TMO=%4u WAIT=%6u/%6uus HOLD=%6u/%6uus\n",
+                   sem, sem->_first_caller,
+                   unsigned(st.takes), unsigned(st.contended),
+                   100.0f * st.contended / MAX(st.takes + st.timeouts, 1U),
+                   unsigned(st.timeouts),
+                   unsigned(st.wait_us / st.contended), unsigned(st.max_wait_us),
+                   unsigned(st.takes > 0 ? st.hold_us / st.takes : 0), unsigned(st.max_hold_us));
+    }
+    pthread_mutex_unlock(&_list_lock);
 }
+#endif // HAL_LINUX_SEMAPHORE_STATS_ENABLED
 
 /*
   binary semaphore using pthread condition variables
@@ -53,6 +233,10 @@ BinarySemaphore::BinarySemaphore(bool initial_state) :
 {
     pthread_cond_init(&cond, NULL);
     pending = initial_state;
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    // the lock is released while waiting on the condition
+    mtx._track_hold = false;
+#endif
 }
 
 bool BinarySemaphore::wait(uint32_t timeout_us)
@@ -6,17 +6,59 @@
 #include <AP_HAL/Semaphores.h>
 #include <pthread.h>
 
+class ExpandingString;
+
 namespace Linux {
 
 class Semaphore : public AP_HAL::Semaphore {
 public:
     friend class BinarySemaphore;
     Semaphore();
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    ~Semaphore();
+#endif
     bool give() override;
     bool take(uint32_t timeout_ms) override;
     bool take_nonblocking() override;
+
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    // report contention and hold times of semaphores that have been contended
+    static void semaphore_info(ExpandingString &str);
+#endif
+
 protected:
     pthread_mutex_t _lock;
+
+private:
+    bool timedlock(uint32_t timeout_ms);
+
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    // called with the lock held after each successful take
+    void taken();
+    // called when a take had to wait for another thread
+    void contended(uint64_t wait_start_us, bool timed_out, const void *caller);
+
+    struct {
+        uint32_t takes;
+        uint32_t contended;
+        uint32_t timeouts;
+        uint64_t wait_us;
+        uint32_t max_wait_us;
+        uint64_t hold_us;
+        uint32_t max_hold_us;
+    } _stats;
+    // owner state, only touched with the lock held
+    uint64_t _taken_us;
+    uint16_t _depth;
+    // hold times are meaningless when the lock is released by a condition wait
+    bool _track_hold = true;
+
+    // return address of the first contended take, to find the lock with addr2line
+    const void *_first_caller;
+    Semaphore *_next_contended;
+    static Semaphore *_contended_list;
+    static pthread_mutex_t _list_lock;
+#endif
 };
 
 
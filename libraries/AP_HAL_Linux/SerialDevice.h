@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <AP_HAL/utility/RingBuffer.h>
+
 #include "AP_HAL_Linux.h"
 
 class SerialDevice {
@@ -13,6 +15,49 @@ public:
     virtual bool close() = 0;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) = 0;
     virtual ssize_t read(uint8_t *buf, uint16_t n) = 0;
+
+    /*
+     * Vectored variants of write() and read(). Devices that can do this in
+     * a single system call override them, the default handles one buffer
+     * at a time and stops at the first short transfer.
+     */
+    virtual ssize_t writev(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+    {
+        ssize_t total = 0;
+        for (uint8_t i = 0; i < iovcnt; i++) {
+            const ssize_t ret = write(iov[i].data, iov[i].len);
+            if (ret < 0) {
+                return total > 0 ? total : ret;
+            }
+            total += ret;
+            if ((uint32_t)ret < iov[i].len) {
+                break;
+            }
+        }
+        return total;
+    }
+    virtual ssize_t readv(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+    {
+        ssize_t total = 0;
+        for (uint8_t i = 0; i < iovcnt; i++) {
+            const ssize_t ret = read(iov[i].data, iov[i].len);
+            if (ret < 0) {
+                return total > 0 ? total : ret;
+            }
+            total += ret;
+            if ((uint32_t)ret < iov[i].len) {
+                break;
+            }
+        }
+        return total;
+    }
+
+    /*
+     * File descriptor that becomes readable when data arrives, or -1 if
+     * the device has to be polled. This may change after a read, e.g. when
+     * a TCP connection is accepted.
+     */
+    virtual int get_fd() const { return -1; }
     virtual void set_blocking(bool blocking) = 0;
     virtual void set_speed(uint32_t speed) = 0;
     virtual AP_HAL::UARTDriver::flow_control get_flow_control(void) { return AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE; }
@@ -18,6 +18,8 @@ public:
     virtual void set_speed(uint32_t speed) override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    // the listener is readable on a new connection, which read() accepts
+    int get_fd() const override { return sock != nullptr ? sock->get_read_fd() : listener.get_read_fd(); }
 
 private:
     SocketAPM_native listener{false};
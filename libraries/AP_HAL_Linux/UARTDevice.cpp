@@ -5,11 +5,13 @@
 #include <poll.h>
 #include <stdio.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <asm/ioctls.h>
 #include <asm/termbits.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 
 UARTDevice::UARTDevice(const char *device_path):
     _device_path(device_path)
@@ -69,6 +71,32 @@ ssize_t UARTDevice::write(const uint8_t *buf, uint16_t n)
     return ret;
 }
 
+/*
+  the ring buffer segments are moved with one system call. The
+  descriptor is non-blocking so a full output queue returns EAGAIN
+ */
+ssize_t UARTDevice::writev(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    struct iovec vec[2];
+    iovcnt = MIN(iovcnt, ARRAY_SIZE(vec));
+    for (uint8_t i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = iov[i].data;
+        vec[i].iov_len = iov[i].len;
+    }
+    return ::writev(_fd, vec, iovcnt);
+}
+
+ssize_t UARTDevice::readv(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    struct iovec vec[2];
+    iovcnt = MIN(iovcnt, ARRAY_SIZE(vec));
+    for (uint8_t i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = iov[i].data;
+        vec[i].iov_len = iov[i].len;
+    }
+    return ::readv(_fd, vec, iovcnt);
+}
+
 void UARTDevice::set_blocking(bool blocking)
 {
     int flags = fcntl(_fd, F_GETFL, 0);
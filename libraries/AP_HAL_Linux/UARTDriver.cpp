@@ -20,6 +20,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UDPDevice.h"
@@ -78,6 +79,9 @@ void UARTDriver::_begin(uint32_t b, uint16_t rxS, uint16_t txS)
 
     while (_in_timer) hal.scheduler->delay(1);
 
+    // the UART thread registers the descriptor again once initialised
+    _poll_stop();
+
     _device->set_speed(b);
 
     bool clear_buffers = false;
@@ -213,6 +217,7 @@ void UARTDriver::_end()
         hal.scheduler->delay(1);
     }
 
+    _poll_stop();
     _device->close();
     _deallocate_buffers();
 }
@@ -295,6 +300,10 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
 
     size_t ret = _writebuf.write(buffer, size);
     _write_mutex.give();
+
+    if (ret > 0) {
+        Scheduler::from(hal.scheduler)->uart_tx_kick();
+    }
     return ret;
 }
 
@@ -325,6 +334,23 @@ int UARTDriver::_read_fd(uint8_t *buf, uint16_t n)
     return _device->read(buf, n);
 }
 
+ssize_t UARTDriver::_writev_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    if (!_connected) {
+        _connected = _device->open();
+    }
+    if (!_connected) {
+        return 0;
+    }
+
+    return _device->writev(iov, iovcnt);
+}
+
+ssize_t UARTDriver::_readv_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    return _device->readv(iov, iovcnt);
+}
+
 
 /*
   try to push out one lump of pending bytes
@@ -354,19 +380,12 @@ bool UARTDriver::_write_pending_bytes(void)
             if (ret > 0)
                 _writebuf.advance(ret);
         } else {
+            // both segments of the ring buffer in one call
             ByteBuffer::IoVec vec[2];
             const auto n_vec = _writebuf.peekiovec(vec, n);
-            for (int i = 0; i < n_vec; i++) {
-                ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
-                if (ret < 0) {
-                    break;
-                }
+            ret = _writev_fd(vec, n_vec);
+            if (ret > 0) {
                 _writebuf.advance(ret);
-
-                /* We wrote less than we asked for, stop */
-                if ((unsigned)ret != vec[i].len) {
-                    break;
-                }
             }
         }
     }
@@ -375,9 +394,34 @@ bool UARTDriver::_write_pending_bytes(void)
 }
 
 /*
-  push any pending bytes to/from the serial port. This is called at
-  1kHz in the timer thread. Doing it this way reduces the system call
-  overhead in the main task enormously.
+  read as much as fits in the read buffer
+  return true if any bytes were read
+ */
+bool UARTDriver::_read_pending_bytes(void)
+{
+    ByteBuffer::IoVec vec[2];
+    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
+    if (n_vec == 0) {
+        return false;
+    }
+
+    const ssize_t ret = _readv_fd(vec, n_vec);
+    if (ret <= 0) {
+        return false;
+    }
+    _readbuf.commit((unsigned)ret);
+
+    // update receive timestamp
+    _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
+    _receive_timestamp_idx ^= 1;
+
+    return true;
+}
+
+/*
+  push any pending bytes to/from the serial port. This is called from
+  the UART thread on each periodic tick and after any poller event.
+  Reads of a registered device are done in _poll_read() instead.
  */
 void UARTDriver::_timer_tick(void)
 {
@@ -390,26 +434,60 @@ void UARTDriver::_timer_tick(void)
         num_send--;
     }
 
-    // try to fill the read buffer
-    int ret;
-    ByteBuffer::IoVec vec[2];
+    if (!_rx_polled) {
+        // try to fill the read buffer
+        _read_pending_bytes();
+        _poll_start();
+    }
 
-    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
-    for (int i = 0; i < n_vec; i++) {
-        ret = _read_fd(vec[i].data, vec[i].len);
-        if (ret < 0) {
-            break;
-        }
-        _readbuf.commit((unsigned)ret);
-
-        // update receive timestamp
-        _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
-        _receive_timestamp_idx ^= 1;
-        
-        /* stop reading as we read less than we asked for */
-        if ((unsigned)ret < vec[i].len) {
-            break;
-        }
+    _in_timer = false;
+}
+
+/*
+  register the device for receive readiness. Only called from the UART
+  thread, and only while there is room to read into
+ */
+void UARTDriver::_poll_start()
+{
+    if (_rx_polled || !_connected || _readbuf.space() == 0) {
+        return;
+    }
+    const int fd = _device->get_fd();
+    if (fd < 0) {
+        return;
+    }
+    _rx_pollable.set_fd(fd);
+    _rx_polled = Scheduler::from(hal.scheduler)->register_uart_pollable(&_rx_pollable);
+}
+
+void UARTDriver::_poll_stop()
+{
+    if (!_rx_polled) {
+        return;
+    }
+    Scheduler::from(hal.scheduler)->unregister_uart_pollable(&_rx_pollable);
+    _rx_polled = false;
+}
+
+/*
+  the device is readable, called from the UART thread
+ */
+void UARTDriver::_poll_read()
+{
+    if (!_initialised || !_rx_polled) {
+        return;
+    }
+
+    _in_timer = true;
+
+    if (!_read_pending_bytes() || _device->get_fd() != _rx_pollable.get_fd()) {
+        /*
+          readable but nothing was read: the read buffer is full, the
+          other end has gone, or a TCP connection was accepted on a new
+          descriptor. Level triggered polling would spin, so fall back to
+          the periodic tick, which registers again once it can read
+         */
+        _poll_stop();
     }
 
     _in_timer = false;
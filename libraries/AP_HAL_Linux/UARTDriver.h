@@ -4,6 +4,7 @@
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 #include "Semaphores.h"
 
@@ -25,6 +26,7 @@ public:
     void set_device_path(const char *path);
 
     bool _write_pending_bytes(void);
+    bool _read_pending_bytes(void);
     virtual void _timer_tick(void) override;
 
     virtual enum flow_control get_flow_control(void) override
@@ -78,6 +80,32 @@ private:
     uint64_t _receive_timestamp[2];
     uint8_t _receive_timestamp_idx;
 
+    /*
+      reads the device from the UART thread as soon as it is readable.
+      The descriptor belongs to the SerialDevice, so it is not closed here
+     */
+    class RxPollable : public Pollable {
+    public:
+        RxPollable(UARTDriver &uart) : _uart(uart) { }
+        ~RxPollable() { _fd = -1; }
+
+        void set_fd(int fd) { _fd = fd; }
+
+        void on_can_read() override { _uart._poll_read(); }
+        void on_error() override { _uart._poll_stop(); }
+        void on_hang_up() override { _uart._poll_stop(); }
+
+    private:
+        UARTDriver &_uart;
+    };
+    RxPollable _rx_pollable{*this};
+    // true while _rx_pollable is registered with the UART poller
+    bool _rx_polled;
+
+    void _poll_start();
+    void _poll_stop();
+    void _poll_read();
+
 protected:
     const char *device_path;
     volatile bool _initialised;
@@ -89,6 +117,9 @@ protected:
 
     virtual int _write_fd(const uint8_t *buf, uint16_t n);
     virtual int _read_fd(uint8_t *buf, uint16_t n);
+    // vectored variants, a single system call where the device supports it
+    virtual ssize_t _writev_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt);
+    virtual ssize_t _readv_fd(const ByteBuffer::IoVec *iov, uint8_t iovcnt);
 
     Linux::Semaphore _write_mutex;
 
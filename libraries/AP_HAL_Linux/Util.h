@@ -68,6 +68,13 @@ public:
 
     uint32_t available_memory(void) override;
 
+#if HAL_LINUX_SEMAPHORE_STATS_ENABLED
+    // request information on semaphore contention
+    void semaphore_info(ExpandingString &str) override {
+        Semaphore::semaphore_info(str);
+    }
+#endif
+
     bool get_system_id(char buf[50]) override;
     bool get_system_id_unformatted(uint8_t buf[], uint8_t &len) override;
 
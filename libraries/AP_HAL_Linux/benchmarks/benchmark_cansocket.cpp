@@ -0,0 +1,142 @@
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_NUM_CAN_IFACES && HAL_LINUX_USE_VIRTUAL_CAN
+
+#include <AP_HAL_Linux/CANSocketIface.h>
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/can/raw.h>
+#include <cstring>
+
+/*
+  these need a virtual CAN interface standing in for the bus:
+    sudo ip link add dev vcan0 type vcan
+    sudo ip link set up vcan0
+ */
+
+// polls of an empty interface before giving up on a lost frame
+#define MAX_EMPTY_POLLS 100000
+
+static Linux::CANIface *get_iface()
+{
+    static Linux::CANIface iface(0);
+    static const bool ok = iface.init(1000000, AP_HAL::CANIface::NormalMode);
+    if (!ok) {
+        fprintf(stderr, "error: couldn't open vcan0\n");
+        return nullptr;
+    }
+    return &iface;
+}
+
+// raw socket playing the other nodes on the bus
+static int get_bus_socket()
+{
+    static int fd = -1;
+    if (fd != -1) {
+        return fd;
+    }
+    const int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0) {
+        return -1;
+    }
+    auto ifr = ifreq();
+    strncpy(ifr.ifr_name, "vcan0", IFNAMSIZ-1);
+    auto addr = sockaddr_can();
+    addr.can_family = AF_CAN;
+    if (ioctl(s, SIOCGIFINDEX, &ifr) < 0) {
+        close(s);
+        return -1;
+    }
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(s);
+        return -1;
+    }
+    fd = s;
+    return fd;
+}
+
+// receive num_frames frames, returning false if any were lost
+static bool receive_frames(Linux::CANIface *iface, int num_frames)
+{
+    AP_HAL::CANFrame frame;
+    uint64_t timestamp_us;
+    AP_HAL::CANIface::CanIOFlags flags;
+    uint32_t empty_polls = 0;
+    while (num_frames > 0) {
+        if (iface->receive(frame, timestamp_us, flags) == 1) {
+            num_frames--;
+            empty_polls = 0;
+        } else if (++empty_polls > MAX_EMPTY_POLLS) {
+            fprintf(stderr, "error: frames lost\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+// frames sent by other nodes, received in bursts
+static void BM_CANSocketReceive(benchmark::State& state)
+{
+    Linux::CANIface *iface = get_iface();
+    const int bus = get_bus_socket();
+    if (iface == nullptr || bus == -1) {
+        return;
+    }
+    iface->clear_rx();
+
+    can_frame frame {};
+    frame.can_id = 0x1001234 | CAN_EFF_FLAG;
+    frame.can_dlc = 8;
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < state.range_x(); i++) {
+            if (write(bus, &frame, sizeof(frame)) != sizeof(frame)) {
+                fprintf(stderr, "error: couldn't write to vcan0\n");
+                return;
+            }
+        }
+        if (!receive_frames(iface, state.range_x())) {
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+BENCHMARK(BM_CANSocketReceive)->Arg(1)->Arg(16)->Arg(64);
+
+// frames sent in bursts and confirmed by their loopback
+static void BM_CANSocketSend(benchmark::State& state)
+{
+    Linux::CANIface *iface = get_iface();
+    if (iface == nullptr) {
+        return;
+    }
+    iface->clear_rx();
+
+    const uint8_t data[8] {};
+    const AP_HAL::CANFrame frame(0x1001234 | AP_HAL::CANFrame::FlagEFF, data, sizeof(data));
+
+    while (state.KeepRunning()) {
+        const uint64_t deadline = AP_HAL::micros64() + 1000000U;
+        for (int i = 0; i < state.range_x(); i++) {
+            iface->send(frame, deadline, AP_HAL::CANIface::Loopback);
+        }
+        iface->flush_tx();
+        if (!receive_frames(iface, state.range_x())) {
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+BENCHMARK(BM_CANSocketSend)->Arg(1)->Arg(16)->Arg(64);
+
+#endif  // HAL_NUM_CAN_IFACES && HAL_LINUX_USE_VIRTUAL_CAN
+
+BENCHMARK_MAIN();
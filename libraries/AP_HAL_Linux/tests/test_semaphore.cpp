@@ -0,0 +1,70 @@
+#include <AP_gtest.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL_Linux/Semaphores.h>
+
+using namespace Linux;
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+// holds a semaphore from another thread for hold_ms
+struct Holder {
+    Semaphore &sem;
+    uint32_t hold_ms;
+    volatile bool taken;
+};
+
+static void *hold_semaphore(void *arg)
+{
+    Holder &h = *(Holder *)arg;
+    h.sem.take_blocking();
+    h.taken = true;
+    usleep(h.hold_ms * 1000U);
+    h.sem.give();
+    return nullptr;
+}
+
+static void start_holder(pthread_t &thr, Holder &h)
+{
+    ASSERT_EQ(pthread_create(&thr, nullptr, hold_semaphore, &h), 0);
+    while (!h.taken) {
+        usleep(1000);
+    }
+}
+
+TEST(LinuxSemaphore, timeout_waits)
+{
+    Semaphore sem;
+    Holder h { sem, 300, false };
+    pthread_t thr;
+    start_holder(thr, h);
+
+    const uint64_t start_us = AP_HAL::micros64();
+    EXPECT_FALSE(sem.take(50));
+    const uint64_t waited_us = AP_HAL::micros64() - start_us;
+    EXPECT_GE(waited_us, 50000U);
+    EXPECT_LT(waited_us, 250000U);
+
+    pthread_join(thr, nullptr);
+}
+
+TEST(LinuxSemaphore, take_when_given)
+{
+    Semaphore sem;
+    Holder h { sem, 50, false };
+    pthread_t thr;
+    start_holder(thr, h);
+
+    const uint64_t start_us = AP_HAL::micros64();
+    EXPECT_TRUE(sem.take(1000));
+    const uint64_t waited_us = AP_HAL::micros64() - start_us;
+    EXPECT_LT(waited_us, 1000000U);
+    EXPECT_TRUE(sem.give());
+
+    pthread_join(thr, nullptr);
+}
+
+AP_GTEST_MAIN()
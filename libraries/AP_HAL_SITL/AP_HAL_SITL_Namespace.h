@@ -18,6 +18,5 @@ class Semaphore;
 class BinarySemaphore;
 class GPIO;
 class DigitalSource;
-class DSP;
 class CANIface;
 }  // namespace HALSITL
@@ -130,7 +130,7 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
             sim_update();
             update_voltage_current(input, 0);
         } else {
-            usleep(1000);
+            Scheduler::from(hal.scheduler)->wait_for_clock(wait_time_usec);
         }
     }
 }
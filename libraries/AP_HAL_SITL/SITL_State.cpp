@@ -173,7 +173,7 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
                 }
             }
 #endif
-            usleep(1000);
+            Scheduler::from(hal.scheduler)->wait_for_clock(wait_time_usec);
         }
     }
     // check the outbound TCP queue size.  If it is too long then
@@ -300,13 +300,46 @@ void Scheduler::_run_io_procs()
  */
 void Scheduler::stop_clock(uint64_t time_usec)
 {
+    pthread_mutex_lock(&_clock_mutex);
     _stopped_clock_usec = time_usec;
+    if (time_usec >= _clock_wake_usec) {
+        // waiters that are still early will re-register their deadline
+        _clock_wake_usec = UINT64_MAX;
+        pthread_cond_broadcast(&_clock_cond);
+    }
+    pthread_mutex_unlock(&_clock_mutex);
     if (_sitlState->_sitl != nullptr && time_usec - _last_io_run > 10000) {
         _last_io_run = time_usec;
         _run_io_procs();
     }
 }
 
+/*
+  wait for the simulated clock to reach wait_time_usec. Only the main
+  thread moves the clock forward, so other threads sleep here until
+  stop_clock() passes their deadline rather than polling for it
+*/
+void Scheduler::wait_for_clock(uint64_t wait_time_usec)
+{
+    pthread_mutex_lock(&_clock_mutex);
+    while (AP_HAL::micros64() < wait_time_usec && !_should_exit) {
+        if (wait_time_usec < _clock_wake_usec) {
+            _clock_wake_usec = wait_time_usec;
+        }
+        // the timeout only matters if the main thread stops stepping
+        // the clock, for example while exiting
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 100 * 1000000UL;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&_clock_cond, &_clock_mutex, &ts);
+    }
+    pthread_mutex_unlock(&_clock_mutex);
+}
+
 /*
   trampoline for thread create
 */
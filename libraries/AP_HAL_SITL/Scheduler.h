@@ -49,6 +49,10 @@ public:
 
     uint64_t stopped_clock_usec() const { return _stopped_clock_usec; }
 
+    // block a thread other than the main thread until the simulated
+    // clock reaches wait_time_usec
+    void wait_for_clock(uint64_t wait_time_usec);
+
     static void _run_io_procs();
     static bool _should_exit;
 
@@ -99,6 +103,12 @@ private:
     uint64_t _last_io_run;
     pthread_t _main_ctx;
 
+    // threads waiting for simulated time are woken by stop_clock()
+    // once the clock reaches the earliest deadline being waited for
+    pthread_mutex_t _clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t _clock_cond = PTHREAD_COND_INITIALIZER;
+    uint64_t _clock_wake_usec = UINT64_MAX;
+
     static HAL_Semaphore _thread_sem;
     struct thread_attr {
         struct thread_attr *next;
@@ -33,6 +33,7 @@ class AP_InertialSensor_Backend;
 class AuxiliaryBus;
 class AP_AHRS;
 class FastRateBuffer;
+class BatchStream;
 
 /*
   forward declare AP_Logger class. We can't include logger.h
@@ -347,7 +348,17 @@ public:
         // a function called by the main thread at the main loop rate:
         void periodic();
 
-        bool doing_sensor_rate_logging() const { return _doing_sensor_rate_logging; }
+        // true if samples of an IMU are taken at the sensor rate rather than the backend rate
+        bool doing_sensor_rate_logging(uint8_t _instance, IMU_SENSOR_TYPE _type) const {
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+            if (stream != nullptr) {
+                // streaming takes every sample the sensor gives, wherever the driver provides them
+                const uint8_t sensor_rate_mask = _type == IMU_SENSOR_TYPE_GYRO ? _imu._gyro_sensor_rate_sampling_enabled : _imu._accel_sensor_rate_sampling_enabled;
+                return (sensor_rate_mask & (1U<<_instance)) != 0;
+            }
+#endif
+            return _doing_sensor_rate_logging;
+        }
         bool doing_post_filter_logging() const {
             return (_doing_post_filter_logging && (post_filter || !_doing_sensor_rate_logging))
                 || (_doing_pre_post_filter_logging && post_filter);
@@ -386,6 +397,7 @@ public:
             BATCH_OPT_SENSOR_RATE = (1<<0),
             BATCH_OPT_POST_FILTER = (1<<1),
             BATCH_OPT_PRE_POST_FILTER = (1<<2),
+            BATCH_OPT_STREAM = (1<<3),
         };
 
         void rotate_to_next_sensor();
@@ -398,6 +410,15 @@ public:
         bool Write_ISBH(const float sample_rate_hz) const;
         bool Write_ISBD() const;
 
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+        void init_stream();
+        void update_stream();
+        void Write_ISBS(uint8_t _instance, IMU_SENSOR_TYPE _type, float sample_rate_hz) const;
+
+        // continuous capture of every sample, replacing the batches when enabled
+        BatchStream *stream;
+#endif
+
         bool has_option(batch_opt_t option) const { return _batch_options_mask & uint16_t(option); }
 
         uint64_t measurement_started_us;
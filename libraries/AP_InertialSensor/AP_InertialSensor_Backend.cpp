@@ -494,7 +494,7 @@ void AP_InertialSensor_Backend::log_gyro_raw(uint8_t instance, const uint64_t sa
         }
     } else {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-        if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+        if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO)) {
             _imu.batchsampler.sample(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO, sample_us,
                                      !_imu.batchsampler.doing_post_filter_logging() ? raw_gyro : filtered_gyro);
         }
@@ -697,7 +697,7 @@ void AP_InertialSensor_Backend::_notify_new_delta_velocity(uint8_t instance, con
 void AP_InertialSensor_Backend::_notify_new_accel_sensor_rate_sample(uint8_t instance, const Vector3f &_accel)
 {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-    if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL)) {
         return;
     }
 
@@ -712,7 +712,7 @@ void AP_InertialSensor_Backend::_notify_new_accel_sensor_rate_sample(uint8_t ins
 void AP_InertialSensor_Backend::_notify_new_gyro_sensor_rate_sample(uint8_t instance, const Vector3f &_gyro)
 {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-    if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO)) {
         return;
     }
 
@@ -736,7 +736,7 @@ void AP_InertialSensor_Backend::log_accel_raw(uint8_t instance, const uint64_t s
         Write_ACC(instance, sample_us, accel);
     } else {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-        if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+        if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL)) {
             _imu.batchsampler.sample(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL, sample_us, accel);
         }
 #endif
@@ -4,6 +4,7 @@
 
 #include "AP_InertialSensor.h"
 #include "AP_InertialSensor_Backend.h"
+#include "BatchStream.h"
 
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
@@ -139,6 +140,24 @@ bool AP_InertialSensor::BatchSampler::Write_ISBD() const
 
     return AP::logger().WriteBlock_first_succeed(&pkt, sizeof(pkt));
 }
+
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+// Write the counters of a continuously streamed sensor to log:
+void AP_InertialSensor::BatchSampler::Write_ISBS(uint8_t _instance, IMU_SENSOR_TYPE _type, float sample_rate_hz) const
+{
+    const uint8_t channel = BatchStream::channel(_instance, _type);
+    const struct log_ISBS pkt{
+        LOG_PACKET_HEADER_INIT(LOG_ISBS_MSG),
+        time_us        : AP_HAL::micros64(),
+        instance       : _instance,
+        sensor_type    : (uint8_t)_type,
+        sample_rate_hz : sample_rate_hz,
+        samples        : stream->get_samples(channel),
+        dropped        : stream->get_dropped(channel),
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+}
+#endif  // AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
 #endif
 
 #if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
@@ -70,6 +70,12 @@
 #define AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED (AP_INERTIALSENSOR_ENABLED && HAL_LOGGING_ENABLED)
 #endif
 
+// continuous capture of every IMU sample to a file, for boards with
+// the storage bandwidth and memory for it
+#ifndef AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+#define AP_INERTIALSENSOR_BATCHSTREAM_ENABLED (AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
 #ifndef AP_INERTIALSENSOR_KILL_IMU_ENABLED
 #define AP_INERTIALSENSOR_KILL_IMU_ENABLED 1
 #endif
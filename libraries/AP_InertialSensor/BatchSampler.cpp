@@ -3,6 +3,7 @@
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
 #include <GCS_MAVLink/GCS.h>
 #include <AP_Logger/AP_Logger.h>
+#include "BatchStream.h"
 
 // Class level parameters
 const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
@@ -25,7 +26,7 @@ const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
     // @Param: BAT_OPT
     // @DisplayName: Batch Logging Options Mask
     // @Description: Options for the BatchSampler.
-    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter
+    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter, 3: Stream every sample continuously to a file in the log directory (Linux and SITL only, takes effect on the next reboot). Options 0-2 are ignored and every sample is taken at the full sensor rate where the driver provides it
     // @User: Advanced
     AP_GROUPINFO("BAT_OPT",  3, AP_InertialSensor::BatchSampler, _batch_options_mask, 0),
 
@@ -52,6 +53,12 @@ void AP_InertialSensor::BatchSampler::init()
     if (_sensor_mask == 0) {
         return;
     }
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+    if (has_option(BATCH_OPT_STREAM)) {
+        init_stream();
+        return;
+    }
+#endif
     if (_required_count <= 0) {
         return;
     }
@@ -87,6 +94,12 @@ void AP_InertialSensor::BatchSampler::periodic()
     if (_sensor_mask == 0) {
         return;
     }
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+    if (stream != nullptr) {
+        update_stream();
+        return;
+    }
+#endif
 #if HAL_LOGGING_ENABLED
     push_data_to_log();
 #endif
@@ -271,8 +284,80 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
 }
 #endif  // HAL_LOGGING_ENABLED
 
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+void AP_InertialSensor::BatchSampler::init_stream()
+{
+    // gyro and accel channels of each selected IMU
+    uint16_t channel_mask = 0;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (_sensor_mask & (1U<<i)) {
+            channel_mask |= 3U << BatchStream::channel(i, IMU_SENSOR_TYPE_ACCEL);
+        }
+    }
+    stream = NEW_NOTHROW BatchStream();
+    if (stream == nullptr || !stream->init(channel_mask)) {
+        delete stream;
+        stream = nullptr;
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate IMU batch stream");
+        return;
+    }
+    initialised = true;
+}
+
+/*
+  start and stop the stream with logging, and record the rate of each
+  channel and how many samples have been dropped once a second
+ */
+void AP_InertialSensor::BatchSampler::update_stream()
+{
+    AP_Logger *logger = AP_Logger::get_singleton();
+    const bool active = logger != nullptr && logger->should_log(MASK_LOG_ANY);
+    stream->set_active(active);
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_sent_ms < 1000) {
+        return;
+    }
+    last_sent_ms = now_ms;
+
+    const uint8_t count = MIN(_imu._accel_count, _imu._gyro_count);
+    for (uint8_t i=0; i<count; i++) {
+        if ((_sensor_mask & (1U<<i)) == 0) {
+            continue;
+        }
+        float sample_rate = _imu._accel_raw_sample_rates[i];
+        if (doing_sensor_rate_logging(i, IMU_SENSOR_TYPE_ACCEL)) {
+            sample_rate *= _imu._accel_over_sampling[i];
+        }
+        stream->set_info(BatchStream::channel(i, IMU_SENSOR_TYPE_ACCEL), sample_rate, _imu._accel_raw_sampling_multiplier[i]);
+        if (active) {
+            Write_ISBS(i, IMU_SENSOR_TYPE_ACCEL, sample_rate);
+        }
+
+        sample_rate = _imu._gyro_raw_sample_rates[i];
+        if (doing_sensor_rate_logging(i, IMU_SENSOR_TYPE_GYRO)) {
+            sample_rate *= _imu._gyro_over_sampling[i];
+        }
+        stream->set_info(BatchStream::channel(i, IMU_SENSOR_TYPE_GYRO), sample_rate, _imu._gyro_raw_sampling_multiplier[i]);
+        if (active) {
+            Write_ISBS(i, IMU_SENSOR_TYPE_GYRO, sample_rate);
+        }
+    }
+}
+#endif  // AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+
 void AP_InertialSensor::BatchSampler::sample(uint8_t _instance, AP_InertialSensor::IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
 {
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+    if (stream != nullptr) {
+        const uint16_t mul = _type == IMU_SENSOR_TYPE_GYRO ? _imu._gyro_raw_sampling_multiplier[_instance] : _imu._accel_raw_sampling_multiplier[_instance];
+        stream->sample(BatchStream::channel(_instance, _type), sample_us,
+                       constrain_float(mul*_sample.x, INT16_MIN, INT16_MAX),
+                       constrain_float(mul*_sample.y, INT16_MIN, INT16_MAX),
+                       constrain_float(mul*_sample.z, INT16_MIN, INT16_MAX));
+        return;
+    }
+#endif
 #if HAL_LOGGING_ENABLED
     if (!should_log(_instance, _type)) {
         return;
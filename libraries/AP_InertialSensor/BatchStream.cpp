@@ -0,0 +1,255 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchStream.h"
+
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <GCS_MAVLink/GCS.h>
+
+extern const AP_HAL::HAL& hal;
+
+BatchStream::~BatchStream()
+{
+    for (auto &c : channels) {
+        delete c.buffer;
+    }
+}
+
+bool BatchStream::init(uint16_t channel_mask)
+{
+    bool have_buffer = false;
+    for (uint8_t i=0; i<ARRAY_SIZE(channels); i++) {
+        if ((channel_mask & (1U<<i)) == 0) {
+            continue;
+        }
+        channels[i].buffer = NEW_NOTHROW ByteBuffer(AP_INERTIALSENSOR_BATCHSTREAM_BUFFER_SIZE);
+        if (channels[i].buffer != nullptr && channels[i].buffer->get_size() == 0) {
+            delete channels[i].buffer;
+            channels[i].buffer = nullptr;
+        }
+        have_buffer |= channels[i].buffer != nullptr;
+    }
+    if (!have_buffer) {
+        return false;
+    }
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&BatchStream::io_timer, void));
+    return true;
+}
+
+void BatchStream::set_info(uint8_t channel, float sample_rate_hz, uint16_t multiplier)
+{
+    channels[channel].sample_rate_hz = sample_rate_hz;
+    channels[channel].multiplier = multiplier;
+}
+
+void BatchStream::sample(uint8_t channel, uint64_t sample_us, int16_t x, int16_t y, int16_t z)
+{
+    Channel &c = channels[channel];
+    if (!_active || c.buffer == nullptr) {
+        return;
+    }
+    if (c.count == 0) {
+        c.first_us = sample_us;
+    }
+    c.samples[0][c.count] = x;
+    c.samples[1][c.count] = y;
+    c.samples[2][c.count] = z;
+    c.samples_total++;
+    if (++c.count < BLOCK_SAMPLES) {
+        return;
+    }
+    c.count = 0;
+
+    uint8_t block[BLOCK_MAX];
+    const uint16_t len = encode_block(channel, c.seqno++, c.first_us, c.samples, block);
+    if (c.buffer->space() < len) {
+        // the IO thread has fallen behind
+        c.dropped += BLOCK_SAMPLES;
+        return;
+    }
+    c.buffer->write(block, len);
+}
+
+/*
+  encode each axis as its first sample and the differences between
+  the rest, zigzag encoded so that small differences of either sign
+  need few bits, then packed least significant bit first
+ */
+uint16_t BatchStream::encode_block(uint8_t channel, uint32_t seqno, uint64_t sample_us,
+                                   const int16_t samples[3][BLOCK_SAMPLES], uint8_t *out)
+{
+    BlockHeader hdr {};
+    hdr.magic = BLOCK_MAGIC;
+    hdr.channel = channel;
+    hdr.seqno = seqno;
+    hdr.sample_us = sample_us;
+
+    uint8_t *p = out + sizeof(hdr);
+    for (uint8_t axis=0; axis<3; axis++) {
+        const int16_t *s = samples[axis];
+        hdr.first[axis] = s[0];
+
+        uint32_t diffs[BLOCK_SAMPLES-1];
+        uint32_t all_bits = 0;
+        for (uint8_t i=1; i<BLOCK_SAMPLES; i++) {
+            const int32_t d = int32_t(s[i]) - int32_t(s[i-1]);
+            diffs[i-1] = (uint32_t(d) << 1) ^ uint32_t(d >> 31);
+            all_bits |= diffs[i-1];
+        }
+        const uint8_t bits = all_bits == 0 ? 0 : 32 - __builtin_clz(all_bits);
+        hdr.bits[axis] = bits;
+
+        uint32_t acc = 0;
+        uint8_t acc_bits = 0;
+        for (uint8_t i=0; i<BLOCK_SAMPLES-1; i++) {
+            acc |= diffs[i] << acc_bits;
+            acc_bits += bits;
+            while (acc_bits >= 8) {
+                *p++ = acc & 0xFF;
+                acc >>= 8;
+                acc_bits -= 8;
+            }
+        }
+        if (acc_bits > 0) {
+            *p++ = acc & 0xFF;
+        }
+    }
+
+    memcpy(out, &hdr, sizeof(hdr));
+    return p - out;
+}
+
+/********************************************************
+  All the functions below this point run in the IO thread
+ ********************************************************/
+
+/*
+  open the first unused ISBnnn.DAT in the log directory
+ */
+bool BatchStream::open_file()
+{
+    const char *log_dir = hal.util->get_custom_log_directory();
+    if (log_dir == nullptr) {
+        log_dir = HAL_BOARD_LOG_DIRECTORY;
+    }
+    struct stat st;
+    if (AP::FS().stat(log_dir, &st) == -1 && AP::FS().mkdir(log_dir) == -1 && errno != EEXIST) {
+        return false;
+    }
+
+    char fname[128];
+    for (uint16_t n=1; n<1000; n++) {
+        hal.util->snprintf(fname, sizeof(fname), "%s/ISB%03u.DAT", log_dir, (unsigned)n);
+        if (AP::FS().stat(fname, &st) == 0) {
+            continue;
+        }
+        fd = AP::FS().open(fname, O_WRONLY|O_CREAT|O_TRUNC);
+        if (fd == -1) {
+            return false;
+        }
+        const FileHeader hdr {
+            { 'I', 'S', 'B', 'S' },
+            1,
+            BLOCK_SAMPLES,
+        };
+        if (AP::FS().write(fd, &hdr, sizeof(hdr)) != int32_t(sizeof(hdr))) {
+            return false;
+        }
+        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "INS: streaming IMU samples to %s", fname);
+        return true;
+    }
+    return false;
+}
+
+// record the rate, multiplier and counters of each channel
+bool BatchStream::write_info()
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(channels); i++) {
+        const Channel &c = channels[i];
+        if (c.buffer == nullptr) {
+            continue;
+        }
+        const InfoRecord info {
+            INFO_MAGIC,
+            i,
+            c.multiplier,
+            c.sample_rate_hz,
+            AP_HAL::micros64(),
+            c.samples_total,
+            c.dropped,
+        };
+        if (AP::FS().write(fd, &info, sizeof(info)) != int32_t(sizeof(info))) {
+            return false;
+        }
+    }
+    return AP::FS().fsync(fd) == 0;
+}
+
+void BatchStream::write_failed()
+{
+    GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "INS: IMU sample stream write failed");
+    if (fd != -1) {
+        AP::FS().close(fd);
+        fd = -1;
+    }
+    // samples are counted as dropped from now on
+    io_failed = true;
+}
+
+void BatchStream::io_timer()
+{
+    if (io_failed || !_active) {
+        return;
+    }
+    if (fd == -1 && !open_file()) {
+        write_failed();
+        return;
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_info_ms >= 1000) {
+        last_info_ms = now_ms;
+        if (!write_info()) {
+            write_failed();
+            return;
+        }
+    }
+
+    for (auto &c : channels) {
+        if (c.buffer == nullptr) {
+            continue;
+        }
+        // only whole blocks are ever available, as each is committed
+        // to the buffer in a single write. All of them are written
+        // before moving on so blocks of different channels never interleave
+        uint32_t n = c.buffer->available();
+        while (n > 0) {
+            ByteBuffer::IoVec vec[2];
+            const uint8_t n_vec = c.buffer->peekiovec(vec, n);
+            const int32_t written = AP::FS().writev(fd, vec, n_vec);
+            if (written <= 0) {
+                write_failed();
+                return;
+            }
+            c.buffer->advance(written);
+            n -= written;
+        }
+    }
+}
+
+#endif  // AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
@@ -0,0 +1,144 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "AP_InertialSensor_config.h"
+
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+/*
+  BatchStream continuously captures every sample from the gyros and
+  accels of the selected IMUs, writing them to a file of their own
+  rather than through log messages.
+
+  The gyro and the accel of each IMU are separate channels. The thread
+  delivering a channel's samples gathers them into blocks. Each axis
+  of a block is encoded as its first sample followed by the
+  differences between samples, packed in as few bits as the largest
+  difference needs. The encoded block is pushed into the channel's
+  ring buffer, or dropped and counted if the buffer is full. The IO
+  thread moves whole blocks from the ring buffers to the file. Once a
+  second it also writes a record of each channel's sample rate,
+  multiplier and counters.
+ */
+
+// bytes of ring buffer for each channel
+#ifndef AP_INERTIALSENSOR_BATCHSTREAM_BUFFER_SIZE
+#define AP_INERTIALSENSOR_BATCHSTREAM_BUFFER_SIZE 65536
+#endif
+
+#define AP_INERTIALSENSOR_BATCHSTREAM_CHANNELS (INS_MAX_INSTANCES*2)
+
+class BatchStream
+{
+public:
+    BatchStream() {}
+    ~BatchStream();
+
+    CLASS_NO_COPY(BatchStream);
+
+    // samples in each block
+    static constexpr uint8_t BLOCK_SAMPLES = 32;
+
+    static constexpr uint16_t BLOCK_MAGIC = 0x42A5;
+    static constexpr uint16_t INFO_MAGIC = 0x49A5;
+
+    // the file starts with this
+    struct PACKED FileHeader {
+        char magic[4];          // "ISBS"
+        uint8_t version;
+        uint8_t block_samples;  // BLOCK_SAMPLES
+    };
+
+    // followed by the bit packed differences of the x, y then z axis,
+    // each padded to a whole byte
+    struct PACKED BlockHeader {
+        uint16_t magic;         // BLOCK_MAGIC
+        uint8_t channel;
+        uint8_t bits[3];        // bits used for each difference of each axis
+        uint32_t seqno;         // block number in the channel, gaps show dropped blocks
+        uint64_t sample_us;     // time of the first sample
+        int16_t first[3];       // first sample of each axis
+    };
+
+    struct PACKED InfoRecord {
+        uint16_t magic;         // INFO_MAGIC
+        uint8_t channel;
+        uint16_t multiplier;    // samples are the measurement times this
+        float sample_rate_hz;
+        uint64_t time_us;
+        uint32_t samples;       // samples captured
+        uint32_t dropped;       // samples lost because the ring buffer was full
+    };
+
+    // zigzag encoded differences between int16 samples need up to 17 bits
+    static constexpr uint16_t BLOCK_MAX = sizeof(BlockHeader) + 3*(((BLOCK_SAMPLES-1)*17+7)/8);
+
+    // channel holding the gyro (type 1) or accel (type 0) samples of an IMU
+    static uint8_t channel(uint8_t instance, uint8_t type) { return instance*2 + type; }
+
+    // allocate ring buffers for the channels with bits set in
+    // channel_mask and start writing from the IO thread. Returns false
+    // if no buffer could be allocated
+    bool init(uint16_t channel_mask);
+
+    // capture only while this is set, opening the file when first set
+    void set_active(bool active) { _active = active; }
+
+    // add a sample scaled to int16. Only one thread may add samples to each channel
+    void sample(uint8_t channel, uint64_t sample_us, int16_t x, int16_t y, int16_t z) __RAMFUNC__;
+
+    // set the sample rate and multiplier recorded for a channel
+    void set_info(uint8_t channel, float sample_rate_hz, uint16_t multiplier);
+
+    // counters for a channel
+    uint32_t get_samples(uint8_t channel) const { return channels[channel].samples_total; }
+    uint32_t get_dropped(uint8_t channel) const { return channels[channel].dropped; }
+
+    // encode a block of samples into out, returning the number of
+    // bytes used, at most BLOCK_MAX
+    static uint16_t encode_block(uint8_t channel, uint32_t seqno, uint64_t sample_us,
+                                 const int16_t samples[3][BLOCK_SAMPLES], uint8_t *out);
+
+private:
+
+    // IO thread
+    void io_timer();
+    bool open_file();
+    bool write_info();
+    void write_failed();
+
+    struct Channel {
+        ByteBuffer *buffer;                    // encoded blocks waiting to be written
+        int16_t samples[3][BLOCK_SAMPLES];     // block being gathered
+        uint64_t first_us;                     // time of the block's first sample
+        uint8_t count;                         // samples in the block so far
+        uint32_t seqno;
+        uint32_t samples_total;
+        uint32_t dropped;
+        float sample_rate_hz;
+        uint16_t multiplier;
+    } channels[AP_INERTIALSENSOR_BATCHSTREAM_CHANNELS];
+
+    bool _active;
+    int fd = -1;
+    bool io_failed;
+    uint32_t last_info_ms;
+};
+
+#endif  // AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
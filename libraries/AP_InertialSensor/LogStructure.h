@@ -8,6 +8,7 @@
     LOG_IMU_MSG, \
     LOG_ISBH_MSG, \
     LOG_ISBD_MSG, \
+    LOG_ISBS_MSG, \
     LOG_VIBE_MSG
 
 // @LoggerMessage: ACC
@@ -95,6 +96,24 @@ struct PACKED log_ISBD {
 };
 static_assert(sizeof(log_ISBD) < 256, "log_ISBD is over-size");
 
+// @LoggerMessage: ISBS
+// @Description: Continuous IMU sample stream statistics
+// @Field: TimeUS: Time since system startup
+// @Field: I: IMU instance
+// @Field: type: sensor type (0 accel, 1 gyro)
+// @Field: smp_rate: rate samples are captured at
+// @Field: N: number of samples captured
+// @Field: Drop: number of samples dropped because the file could not be written fast enough
+struct PACKED log_ISBS {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t instance;
+    uint8_t sensor_type;
+    float sample_rate_hz;
+    uint32_t samples;
+    uint32_t dropped;
+};
+
 // @LoggerMessage: VIBE
 // @Description: Processed (acceleration) vibration information
 // @Field: TimeUS: Time since system startup
@@ -123,4 +142,6 @@ struct PACKED log_Vibe {
     { LOG_ISBH_MSG, sizeof(log_ISBH), \
       "ISBH", "QHBBHHQf", "TimeUS,N,type,instance,mul,smp_cnt,SampleUS,smp_rate", "s-----sz", "F-----F-" },  \
     { LOG_ISBD_MSG, sizeof(log_ISBD), \
-      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" },
+      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" }, \
+    { LOG_ISBS_MSG, sizeof(log_ISBS), \
+      "ISBS", "QBBfII", "TimeUS,I,type,smp_rate,N,Drop", "s#-z--", "F-----" , true },
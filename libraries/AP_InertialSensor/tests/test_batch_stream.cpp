@@ -0,0 +1,105 @@
+#include <AP_gtest.h>
+
+#include <AP_InertialSensor/BatchStream.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+
+static const uint8_t N = BatchStream::BLOCK_SAMPLES;
+
+// decode a block as a tool reading the stream file would
+static uint16_t decode_block(const uint8_t *in, BatchStream::BlockHeader &hdr, int16_t samples[3][N])
+{
+    memcpy(&hdr, in, sizeof(hdr));
+    const uint8_t *p = in + sizeof(hdr);
+    for (uint8_t axis=0; axis<3; axis++) {
+        const uint8_t bits = hdr.bits[axis];
+        samples[axis][0] = hdr.first[axis];
+        uint32_t acc = 0;
+        uint8_t acc_bits = 0;
+        for (uint8_t i=1; i<N; i++) {
+            while (acc_bits < bits) {
+                acc |= uint32_t(*p++) << acc_bits;
+                acc_bits += 8;
+            }
+            const uint32_t zz = bits == 0 ? 0 : acc & ((1U << bits) - 1);
+            acc = bits == 0 ? acc : acc >> bits;
+            acc_bits -= bits;
+            const int32_t d = int32_t(zz >> 1) ^ -int32_t(zz & 1);
+            samples[axis][i] = samples[axis][i-1] + d;
+        }
+    }
+    return p - in;
+}
+
+static uint32_t test_rand(uint32_t &seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+static void check_round_trip(const int16_t samples[3][N], uint16_t &len)
+{
+    uint8_t block[BatchStream::BLOCK_MAX];
+    len = BatchStream::encode_block(3, 1234, 5678, samples, block);
+    ASSERT_LE(len, BatchStream::BLOCK_MAX);
+
+    BatchStream::BlockHeader hdr;
+    int16_t decoded[3][N];
+    EXPECT_EQ(decode_block(block, hdr, decoded), len);
+    EXPECT_EQ(hdr.magic, BatchStream::BLOCK_MAGIC);
+    EXPECT_EQ(hdr.channel, 3);
+    EXPECT_EQ(hdr.seqno, 1234U);
+    EXPECT_EQ(hdr.sample_us, 5678U);
+    EXPECT_EQ(memcmp(samples, decoded, sizeof(decoded)), 0);
+}
+
+TEST(BatchStream, round_trip)
+{
+    int16_t samples[3][N];
+    uint16_t len;
+
+    // constant samples need no bits for the differences
+    for (uint8_t axis=0; axis<3; axis++) {
+        for (uint8_t i=0; i<N; i++) {
+            samples[axis][i] = -1000 + axis;
+        }
+    }
+    check_round_trip(samples, len);
+    EXPECT_EQ(len, sizeof(BatchStream::BlockHeader));
+
+    // vibration around a steady value packs smaller than the raw samples
+    uint32_t seed = 1;
+    for (uint8_t axis=0; axis<3; axis++) {
+        for (uint8_t i=0; i<N; i++) {
+            samples[axis][i] = 2000 * (axis+1) + int16_t(test_rand(seed) % 200) - 100;
+        }
+    }
+    check_round_trip(samples, len);
+    EXPECT_LT(len, sizeof(samples));
+
+    // full scale swings need the widest differences
+    for (uint8_t axis=0; axis<3; axis++) {
+        for (uint8_t i=0; i<N; i++) {
+            samples[axis][i] = (i + axis) % 2 ? INT16_MAX : INT16_MIN;
+        }
+    }
+    check_round_trip(samples, len);
+    EXPECT_EQ(len, BatchStream::BLOCK_MAX);
+
+    // random samples of random ranges
+    for (uint16_t trial=0; trial<1000; trial++) {
+        const uint32_t range = 1U << (test_rand(seed) % 17);
+        for (uint8_t axis=0; axis<3; axis++) {
+            for (uint8_t i=0; i<N; i++) {
+                samples[axis][i] = int32_t(test_rand(seed) % range) - int32_t(range / 2);
+            }
+        }
+        check_round_trip(samples, len);
+    }
+}
+
+#endif  // AP_INERTIALSENSOR_BATCHSTREAM_ENABLED
+
+AP_GTEST_MAIN()
@@ -960,14 +960,16 @@ void AP_Logger_File::io_timer(void)
     }
 #endif
     _last_write_time = tnow;
-    if (nbytes > _writebuf_chunk) {
+    if (nbytes > _writebuf_chunk * HAL_LOGGER_WRITE_MAX_CHUNKS) {
         // be kind to the filesystem layer
-        nbytes = _writebuf_chunk;
+        nbytes = _writebuf_chunk * HAL_LOGGER_WRITE_MAX_CHUNKS;
     }
 
+#if !HAL_LOGGER_FILE_WRITEV_ENABLED
     uint32_t size;
     const uint8_t *head = _writebuf.readptr(size);
     nbytes = MIN(nbytes, size);
+#endif
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
     // try to align writes on a 512 byte boundary to avoid filesystem reads
@@ -992,7 +994,22 @@ void AP_Logger_File::io_timer(void)
         nbytes = bytes_until_fsync; // write exactly enough to sync
     }
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
+    // stand in for a slow SD card, for testing how the writer copes
+    SITL::SIM *sitl = AP::sitl();
+    if (sitl != nullptr && sitl->log_write_stall_ms > 0) {
+        hal.scheduler->delay(sitl->log_write_stall_ms);
+    }
+#endif
+
+#if HAL_LOGGER_FILE_WRITEV_ENABLED
+    // write straight from the buffer, across its end if need be
+    ByteBuffer::IoVec vec[2];
+    const uint8_t n_vec = _writebuf.peekiovec(vec, nbytes);
+    ssize_t nwritten = AP::FS().writev(_write_fd, vec, n_vec);
+#else
     ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
+#endif
     last_io_operation = "";
     if (nwritten <= 0) {
         if (errno == ENOSPC) {
@@ -21,6 +21,23 @@
 #endif
 #endif
 
+// use vectored writes, so data wrapping around the end of the write
+// buffer goes out in a single call and several chunks can be written
+// in one pass of the IO timer
+#ifndef HAL_LOGGER_FILE_WRITEV_ENABLED
+#define HAL_LOGGER_FILE_WRITEV_ENABLED (AP_FILESYSTEM_POSIX_ENABLED && AP_FILESYSTEM_POSIX_HAVE_WRITEV)
+#endif
+
+// maximum number of chunks written in one pass of the IO timer. More
+// than one lets the writer catch up quickly after the disk stalls
+#ifndef HAL_LOGGER_WRITE_MAX_CHUNKS
+#if HAL_LOGGER_FILE_WRITEV_ENABLED
+#define HAL_LOGGER_WRITE_MAX_CHUNKS 8
+#else
+#define HAL_LOGGER_WRITE_MAX_CHUNKS 1
+#endif
+#endif
+
 class AP_Logger_File : public AP_Logger_Backend
 {
 public:
@@ -316,6 +316,9 @@ struct PACKED log_MAV {
     uint8_t flags;
     uint16_t stream_slowdown_ms;
     uint16_t times_full;
+    uint16_t slip_avg_ms;
+    uint16_t slip_max_ms;
+    uint16_t slip_max_interval_ms;
 };
 
 struct PACKED log_RSSI {
@@ -778,6 +781,9 @@ struct PACKED log_VER {
 // @FieldBitmaskEnum: flags: GCS_MAVLINK::Flags
 // @Field: ss: stream slowdown is the number of ms being added to each message to fit within bandwidth
 // @Field: tf: times buffer was full when a message was going to be sent
+// @Field: sl: average time deferred messages were sent later than their requested interval
+// @Field: slm: longest time a deferred message was sent later than its requested interval
+// @Field: sli: requested interval of the deferred message which was sent latest
 
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
@@ -1231,7 +1237,7 @@ LOG_STRUCTURE_FROM_FENCE \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
-      "MAV", "QBHHHBHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf", "s#----s-", "F-000-C-" },   \
+      "MAV", "QBHHHBHHHHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf,sl,slm,sli", "s#----s-sss", "F-000-C-CCC" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -0,0 +1,135 @@
+/*
+ * Measure sustained throughput of the logger and the number of
+ * messages dropped at a fixed message rate. On SITL the run is
+ * repeated with the SIM_LOG_STALL slow disk stand-in.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Scheduler/AP_Scheduler.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <SITL/SITL.h>
+#include <stdio.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// roughly the size of an IMU batch sample message
+struct PACKED log_BNCH {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t seq;
+    int16_t  x[32];
+    int16_t  y[32];
+    int16_t  z[32];
+};
+static_assert(sizeof(log_BNCH) < 256, "log_BNCH is oversize");
+
+#define LOG_BNCH_MSG 1
+
+static const struct LogStructure log_structure[] = {
+    LOG_COMMON_STRUCTURES,
+    { LOG_BNCH_MSG, sizeof(log_BNCH),
+      "BNCH", "QIaaa", "TimeUS,Seq,X,Y,Z", "s----", "F----" },
+};
+
+// offered load and length of each run
+#define BENCH_RATE_BYTES_PER_S (2U*1024U*1024U)
+#define BENCH_RUN_MS 10000U
+
+class AP_LoggerTest_WriteBench : public AP_HAL::HAL::Callbacks {
+public:
+    void setup() override;
+    void loop() override;
+
+private:
+
+    AP_Int32 log_bitmask;
+    AP_Logger logger;
+    AP_Scheduler scheduler;
+
+    void run(uint16_t stall_ms);
+};
+
+void AP_LoggerTest_WriteBench::run(uint16_t stall_ms)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    SITL::SIM *sitl = AP::sitl();
+    if (sitl != nullptr) {
+        sitl->log_write_stall_ms.set(stall_ms);
+    }
+#endif
+
+    // the first write opens a new log, give it time to get started
+    logger.Write_Message("Bench start");
+    hal.scheduler->delay(100);
+
+    const uint32_t dropped_start = logger.num_dropped();
+    const uint32_t msgs_per_ms = MAX(1U, BENCH_RATE_BYTES_PER_S / (1000U * sizeof(log_BNCH)));
+    uint32_t seq = 0;
+    uint32_t bytes = 0;
+
+    struct log_BNCH pkt {};
+    pkt.head1 = HEAD_BYTE1;
+    pkt.head2 = HEAD_BYTE2;
+    pkt.msgid = LOG_BNCH_MSG;
+
+    const uint32_t start_ms = AP_HAL::millis();
+    while (AP_HAL::millis() - start_ms < BENCH_RUN_MS) {
+        for (uint32_t i = 0; i < msgs_per_ms; i++) {
+            pkt.time_us = AP_HAL::micros64();
+            pkt.seq = seq++;
+            if (logger.WriteBlock_first_succeed(&pkt, sizeof(pkt))) {
+                bytes += sizeof(pkt);
+            }
+        }
+        hal.scheduler->delay(1);
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    logger.flush();
+#endif
+    const uint32_t dt_ms = AP_HAL::millis() - start_ms;
+    const uint32_t dropped = logger.num_dropped() - dropped_start;
+
+    hal.console->printf("stall=%ums sent=%u accepted=%.2fMB rate=%.2fMB/s dropped=%u (%.1f%%)\n",
+                        unsigned(stall_ms),
+                        unsigned(seq),
+                        bytes * 1.0e-6,
+                        bytes * 1.0e-3 / MAX(dt_ms, 1U),
+                        unsigned(dropped),
+                        seq > 0 ? 100.0 * dropped / seq : 0.0);
+
+    logger.StopLogging();
+}
+
+void AP_LoggerTest_WriteBench::setup(void)
+{
+    hal.console->printf("Logger write benchmark 1.0\n");
+
+    log_bitmask.set((uint32_t)-1);
+    logger.init(log_bitmask, log_structure, ARRAY_SIZE(log_structure));
+    logger.set_vehicle_armed(true);
+
+    hal.scheduler->delay(20);
+
+    run(0);
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    // an SD card holding off writes for tens of milliseconds is
+    // common, and occasional stalls of a few hundred are not unusual
+    run(20);
+    run(100);
+    run(300);
+#endif
+
+    hal.console->printf("benchmark done\n");
+}
+
+void AP_LoggerTest_WriteBench::loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+GCS_Dummy _gcs;
+
+static AP_LoggerTest_WriteBench loggertest;
+
+AP_HAL_MAIN_CALLBACKS(&loggertest);
@@ -0,0 +1,328 @@
+#include "PolygonIndex.h"
+#include "AP_Math.h"
+
+#include <AP_InternalError/AP_InternalError.h>
+
+/*
+  build the index for a polygon of n points
+ */
+void PolygonIndex::init(const Vector2f *points, const Vector2l *points_lla, uint16_t n)
+{
+    clear();
+
+    _points = points;
+    _points_lla = points_lla;
+    if (n == 0) {
+        return;
+    }
+    _num_points = Polygon_complete(points, n) ? n-1 : n;
+    _num_points_lla = Polygon_complete(points_lla, n) ? n-1 : n;
+
+    _min_cm = _max_cm = points[0];
+    _min_lla = _max_lla = points_lla[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min_cm.x = MIN(_min_cm.x, points[i].x);
+        _min_cm.y = MIN(_min_cm.y, points[i].y);
+        _max_cm.x = MAX(_max_cm.x, points[i].x);
+        _max_cm.y = MAX(_max_cm.y, points[i].y);
+        _min_lla.x = MIN(_min_lla.x, points_lla[i].x);
+        _min_lla.y = MIN(_min_lla.y, points_lla[i].y);
+        _max_lla.x = MAX(_max_lla.x, points_lla[i].x);
+        _max_lla.y = MAX(_max_lla.y, points_lla[i].y);
+    }
+
+    if (MIN(_num_points, _num_points_lla) < POLYGON_INDEX_MIN_POINTS) {
+        return;
+    }
+    const Vector2f span_cm = _max_cm - _min_cm;
+    if (!is_positive(span_cm.x) || !is_positive(span_cm.y)) {
+        // degenerate polygon, leave it to the full scans
+        return;
+    }
+    _num_slabs = constrain_int16(_num_points_lla / POLYGON_INDEX_EDGES_PER_SLAB, 1, POLYGON_INDEX_SLABS_MAX);
+    _slab_width_lla = (uint32_t(_max_lla.y) - uint32_t(_min_lla.y)) / _num_slabs + 1;
+    _grid_size = constrain_int16(sqrtf(_num_points / POLYGON_INDEX_EDGES_PER_SLAB), 2, POLYGON_INDEX_GRID_MAX);
+    _cell_width_cm = span_cm / _grid_size;
+    const uint16_t num_cells = _grid_size * _grid_size;
+
+    // the edges are added in three passes.  The first counts the total
+    // entries to size the allocation and the second counts the entries
+    // of each bucket b into start[b+1], which are then summed into the
+    // start of each bucket.  The last advances start[b] to the end of b
+    // as it fills it, and the starts are then shifted back into place.
+    // Each bucket's edges are left in polygon order
+    uint32_t num_entries_lla = 0;
+    uint32_t num_entries_cm = 0;
+    enum class Pass { TOTAL, COUNT, FILL };
+    auto add_edges = [&](Pass pass) {
+        for (uint16_t i=0; i<_num_points_lla; i++) {
+            const int32_t y1 = points_lla[i].y;
+            const int32_t y2 = points_lla[(i+1) % _num_points_lla].y;
+            if (y1 == y2) {
+                // edges of constant y never straddle a point
+                continue;
+            }
+            for (uint16_t s=slab_lla(MIN(y1, y2)); s<=slab_lla(MAX(y1, y2)); s++) {
+                switch (pass) {
+                case Pass::TOTAL:
+                    num_entries_lla++;
+                    break;
+                case Pass::COUNT:
+                    _lla.start[s+1]++;
+                    break;
+                case Pass::FILL:
+                    _lla.edges[_lla.start[s]++] = i;
+                    break;
+                }
+            }
+        }
+        for (uint16_t i=0; i<_num_points; i++) {
+            const Vector2f &v1 = points[i];
+            const Vector2f &v2 = points[(i+1) % _num_points];
+            const uint8_t x_max = cell_cm(MAX(v1.x, v2.x), _min_cm.x, _cell_width_cm.x);
+            const uint8_t y_max = cell_cm(MAX(v1.y, v2.y), _min_cm.y, _cell_width_cm.y);
+            for (uint8_t y=cell_cm(MIN(v1.y, v2.y), _min_cm.y, _cell_width_cm.y); y<=y_max; y++) {
+                for (uint8_t x=cell_cm(MIN(v1.x, v2.x), _min_cm.x, _cell_width_cm.x); x<=x_max; x++) {
+                    const uint16_t c = y * _grid_size + x;
+                    switch (pass) {
+                    case Pass::TOTAL:
+                        num_entries_cm++;
+                        break;
+                    case Pass::COUNT:
+                        _grid.start[c+1]++;
+                        break;
+                    case Pass::FILL:
+                        _grid.edges[_grid.start[c]++] = i;
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    add_edges(Pass::TOTAL);
+    if (num_entries_lla > UINT16_MAX || num_entries_cm > UINT16_MAX) {
+        return;
+    }
+    _bucket_data = NEW_NOTHROW uint16_t[(_num_slabs + 1) + (num_cells + 1) + num_entries_lla + num_entries_cm];
+    if (_bucket_data == nullptr) {
+        return;
+    }
+    _lla.start = _bucket_data;
+    _grid.start = &_lla.start[_num_slabs + 1];
+    _lla.edges = &_grid.start[num_cells + 1];
+    _grid.edges = &_lla.edges[num_entries_lla];
+
+    add_edges(Pass::COUNT);
+    for (uint16_t s=1; s<_num_slabs; s++) {
+        _lla.start[s+1] += _lla.start[s];
+    }
+    for (uint16_t c=1; c<num_cells; c++) {
+        _grid.start[c+1] += _grid.start[c];
+    }
+    add_edges(Pass::FILL);
+    for (uint16_t s=_num_slabs; s>0; s--) {
+        _lla.start[s] = _lla.start[s-1];
+    }
+    _lla.start[0] = 0;
+    for (uint16_t c=num_cells; c>0; c--) {
+        _grid.start[c] = _grid.start[c-1];
+    }
+    _grid.start[0] = 0;
+
+    if (_lla.start[_num_slabs] != num_entries_lla ||
+        _grid.start[num_cells] != num_entries_cm) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        clear();
+    }
+}
+
+/*
+  release the buckets and forget the polygon
+ */
+void PolygonIndex::clear()
+{
+    delete[] _bucket_data;
+    _bucket_data = nullptr;
+    _lla = {};
+    _grid = {};
+    _num_slabs = 0;
+    _grid_size = 0;
+    _points = nullptr;
+    _points_lla = nullptr;
+    _num_points = 0;
+    _num_points_lla = 0;
+    _min_cm.zero();
+    _max_cm.zero();
+    _min_lla.zero();
+    _max_lla.zero();
+}
+
+// slab holding latitude/longitude y, which must be within the bounds
+uint16_t PolygonIndex::slab_lla(int32_t y) const
+{
+    return (uint32_t(y) - uint32_t(_min_lla.y)) / _slab_width_lla;
+}
+
+// cell column or row holding v in cm, clamped to the grid
+uint8_t PolygonIndex::cell_cm(float v, float min_v, float cell_width) const
+{
+    const float f = (v - min_v) / cell_width;
+    if (!(f > 0)) {
+        return 0;
+    }
+    if (f >= _grid_size) {
+        return _grid_size - 1;
+    }
+    return uint8_t(f);
+}
+
+/*
+  return true if P is outside the polygon.  Only edges straddling P.y
+  can toggle the result, and those are all in P's slab
+ */
+bool PolygonIndex::outside(const Vector2l &P) const
+{
+    if (P.y < _min_lla.y || P.y >= _max_lla.y ||
+        P.x < _min_lla.x || P.x > _max_lla.x) {
+        // no edge straddles P, or all that do are to one side of it
+        return true;
+    }
+
+    bool outside = true;
+    if (!indexed()) {
+        for (uint16_t i=0; i<_num_points_lla; i++) {
+            if (Polygon_edge_crosses(P, _points_lla[i], _points_lla[(i+1) % _num_points_lla])) {
+                outside = !outside;
+            }
+        }
+        return outside;
+    }
+
+    const uint16_t s = slab_lla(P.y);
+    for (uint16_t k=_lla.start[s]; k<_lla.start[s+1]; k++) {
+        const uint16_t i = _lla.edges[k];
+        if (Polygon_edge_crosses(P, _points_lla[i], _points_lla[(i+1) % _num_points_lla])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+/*
+  distance in cm from p to the bounding box of the polygon
+ */
+float PolygonIndex::bounds_distance(const Vector2f &p) const
+{
+    const float dx = MAX(MAX(_min_cm.x - p.x, p.x - _max_cm.x), 0.0f);
+    const float dy = MAX(MAX(_min_cm.y - p.y, p.y - _max_cm.y), 0.0f);
+    return norm(dx, dy);
+}
+
+/*
+  return the closest distance from p to an edge of the polygon, visiting
+  rings of cells outwards from p's own until the unvisited cells are
+  further away than the closest edge found or than limit
+ */
+bool PolygonIndex::closest_distance_point(const Vector2f &p, float &closest, float limit) const
+{
+    if (_num_points < 3) {
+        // not a polygon
+        return false;
+    }
+    if (!indexed() || isnan(p.x) || isnan(p.y)) {
+        return closest_distance_all(p, closest);
+    }
+    if (bounds_distance(p) >= limit) {
+        closest = limit;
+        return true;
+    }
+
+    // allowance for rounding in cell_cm() when bounding unvisited edges
+    const float eps = 1.0f + 1.0e-5f * (fabsf(_min_cm.x) + fabsf(_max_cm.x) + fabsf(_min_cm.y) + fabsf(_max_cm.y));
+
+    // distance of p outside the bounds along each axis
+    const float outside_x = MAX(MAX(_min_cm.x - p.x, p.x - _max_cm.x), 0.0f);
+    const float outside_y = MAX(MAX(_min_cm.y - p.y, p.y - _max_cm.y), 0.0f);
+
+    const int16_t px = cell_cm(p.x, _min_cm.x, _cell_width_cm.x);
+    const int16_t py = cell_cm(p.y, _min_cm.y, _cell_width_cm.y);
+    float closest_sq = FLT_MAX;
+    for (int16_t ring=0; ; ring++) {
+        const int16_t x_min = MAX(px - ring, 0);
+        const int16_t x_max = MIN(px + ring, _grid_size - 1);
+        const int16_t y_min = MAX(py - ring, 0);
+        const int16_t y_max = MIN(py + ring, _grid_size - 1);
+        for (int16_t y=y_min; y<=y_max; y++) {
+            // only the ends of rows strictly inside the ring are on it
+            const bool whole_row = abs(y - py) == ring;
+            for (int16_t x=x_min; x<=x_max; x++) {
+                if (!whole_row && abs(x - px) != ring) {
+                    continue;
+                }
+                const uint16_t c = y * _grid_size + x;
+                for (uint16_t k=_grid.start[c]; k<_grid.start[c+1]; k++) {
+                    const uint16_t i = _grid.edges[k];
+                    const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(_points[i], _points[(i+1) % _num_points], p);
+                    if (dist_sq < closest_sq) {
+                        closest_sq = dist_sq;
+                    }
+                }
+            }
+        }
+
+        // every unvisited edge lies wholly beyond one side of the square
+        // of cells visited so far, and within the bounds along that side
+        float gap = FLT_MAX;
+        if (px - ring > 0) {
+            gap = MIN(gap, norm(MAX(p.x - (_min_cm.x + (px - ring) * _cell_width_cm.x) - eps, 0.0f), outside_y));
+        }
+        if (px + ring + 1 < _grid_size) {
+            gap = MIN(gap, norm(MAX((_min_cm.x + (px + ring + 1) * _cell_width_cm.x) - p.x - eps, 0.0f), outside_y));
+        }
+        if (py - ring > 0) {
+            gap = MIN(gap, norm(MAX(p.y - (_min_cm.y + (py - ring) * _cell_width_cm.y) - eps, 0.0f), outside_x));
+        }
+        if (py + ring + 1 < _grid_size) {
+            gap = MIN(gap, norm(MAX((_min_cm.y + (py + ring + 1) * _cell_width_cm.y) - p.y - eps, 0.0f), outside_x));
+        }
+        if (gap >= FLT_MAX) {
+            // all cells visited
+            break;
+        }
+        if (is_positive(gap)) {
+            if (gap >= limit && closest_sq >= sq(limit)) {
+                closest = limit;
+                return true;
+            }
+            if (sq(gap) >= closest_sq) {
+                break;
+            }
+        }
+    }
+
+    if (is_equal(closest_sq, FLT_MAX)) {
+        closest = 0.0f;
+        return false;
+    }
+    closest = sqrtf(closest_sq);
+    return true;
+}
+
+// scan every edge, as Polygon_closest_distance_point
+bool PolygonIndex::closest_distance_all(const Vector2f &p, float &closest) const
+{
+    float closest_sq = FLT_MAX;
+    for (uint16_t i=0; i<_num_points; i++) {
+        const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(_points[i], _points[(i+1) % _num_points], p);
+        if (dist_sq < closest_sq) {
+            closest_sq = dist_sq;
+        }
+    }
+    if (is_equal(closest_sq, FLT_MAX)) {
+        closest = 0.0f;
+        return false;
+    }
+    closest = sqrtf(closest_sq);
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include "vector2.h"
+
+#include <float.h>
+
+/*
+ * PolygonIndex accelerates repeated point queries against a fixed polygon
+ *
+ * The polygon's edges are bucketed twice.  Slabs along y of the
+ * latitude/longitude points hold every edge that can straddle a point,
+ * so the inside/outside test only looks at the edges in the point's own
+ * slab.  A grid of cells over the offsets in cm is searched in rings
+ * outwards from the point for the closest edge, until no unvisited cell
+ * can hold a nearer one.
+ *
+ * Results are identical to Polygon_outside() and
+ * Polygon_closest_distance_point() on the same points.  The index holds
+ * pointers to the caller's points, which must outlive it and must not
+ * change without calling init() again.
+ */
+
+// polygons with fewer points than this are only bounded, as scanning
+// every edge is as quick as looking up the buckets
+#ifndef POLYGON_INDEX_MIN_POINTS
+#define POLYGON_INDEX_MIN_POINTS 16
+#endif
+
+// average number of edges per slab or cell, and the limits on slabs
+// per polygon and cells along each side of its grid
+#ifndef POLYGON_INDEX_EDGES_PER_SLAB
+#define POLYGON_INDEX_EDGES_PER_SLAB 4
+#endif
+#ifndef POLYGON_INDEX_SLABS_MAX
+#define POLYGON_INDEX_SLABS_MAX 64
+#endif
+#ifndef POLYGON_INDEX_GRID_MAX
+#define POLYGON_INDEX_GRID_MAX 16
+#endif
+
+class PolygonIndex {
+public:
+    PolygonIndex() {}
+    ~PolygonIndex() { clear(); }
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(PolygonIndex);
+
+    // build the index for a polygon of n points, given both as offsets
+    // in cm and as latitude/longitude.  If memory for the buckets can't be
+    // allocated the queries still work, scanning every edge
+    void init(const Vector2f *points, const Vector2l *points_lla, uint16_t n);
+
+    // release the buckets and forget the polygon
+    void clear();
+
+    // returns true if the buckets were allocated
+    bool indexed() const { return _bucket_data != nullptr; }
+
+    // same result as Polygon_outside(P, points_lla, n)
+    bool outside(const Vector2l &P) const WARN_IF_UNUSED;
+
+    // same result as Polygon_closest_distance_point(points, n, p, closest),
+    // except that if no edge is nearer than limit (in cm) closest may
+    // be set to limit instead of the true distance.  limit must be positive
+    bool closest_distance_point(const Vector2f &p, float &closest, float limit = FLT_MAX) const WARN_IF_UNUSED;
+
+    // bounding box of the points in cm
+    const Vector2f &get_min_cm() const { return _min_cm; }
+    const Vector2f &get_max_cm() const { return _max_cm; }
+
+    // distance in cm from p to the bounding box, zero if inside it.
+    // No edge of the polygon is nearer than this
+    float bounds_distance(const Vector2f &p) const;
+
+private:
+
+    // edges of bucket b are edges[start[b]] to edges[start[b+1]-1]
+    struct Buckets {
+        uint16_t *start;
+        uint16_t *edges;
+    };
+
+    // slab holding latitude/longitude y
+    uint16_t slab_lla(int32_t y) const;
+    // grid column or row holding v in cm
+    uint8_t cell_cm(float v, float min_v, float cell_width) const;
+
+    // scan every edge for the closest, as Polygon_closest_distance_point
+    bool closest_distance_all(const Vector2f &p, float &closest) const;
+
+    const Vector2f *_points = nullptr;
+    const Vector2l *_points_lla = nullptr;
+    // number of points in each ring, dropping a repeated closing point
+    uint16_t _num_points = 0;
+    uint16_t _num_points_lla = 0;
+
+    Vector2f _min_cm;
+    Vector2f _max_cm;
+    Vector2l _min_lla;
+    Vector2l _max_lla;
+
+    uint16_t _num_slabs = 0;
+    uint32_t _slab_width_lla;
+    Buckets _lla {};
+    uint8_t _grid_size = 0;
+    Vector2f _cell_width_cm;
+    Buckets _grid {};
+    // single allocation holding the slabs and the grid
+    uint16_t *_bucket_data = nullptr;
+};
@@ -0,0 +1,158 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/PolygonIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  a synthetic geofence: one large inclusion polygon of 250 points
+  around the origin with a number of 120 point exclusion polygons
+  scattered inside it, as a complex survey fence would have.  Points
+  are given both as latitude/longitude and as offsets in cm, as
+  AC_PolyFence_loader holds them
+ */
+static const uint8_t inclusion_points = 250;
+static const uint8_t exclusion_points = 120;
+static const uint16_t num_queries = 256;
+
+struct synthetic_fence {
+    uint16_t num_polygons;
+    uint16_t counts[33];
+    Vector2f *points[33];
+    Vector2l *points_lla[33];
+    PolygonIndex index[33];
+    Vector2f query[num_queries];
+    Vector2l query_lla[num_queries];
+};
+
+static uint32_t fence_rand(uint32_t &seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+// about 1.1cm per 1e-7 degree at the equator
+static Vector2f lla_to_cm(const Vector2l &p)
+{
+    return Vector2f(p.x * 1.113195f, p.y * 1.113195f);
+}
+
+// star shaped polygon of n points around centre with radius varying from r/2 to r
+static void make_polygon(synthetic_fence &f, uint32_t &seed, uint8_t n, const Vector2l &centre, int32_t r)
+{
+    const uint16_t k = f.num_polygons++;
+    f.counts[k] = n;
+    f.points[k] = new Vector2f[n];
+    f.points_lla[k] = new Vector2l[n];
+    for (uint8_t i=0; i<n; i++) {
+        const float angle = M_2PI * i / n;
+        const float radius = r * (0.5f + (fence_rand(seed) % 1000) * 0.0005f);
+        f.points_lla[k][i] = Vector2l(centre.x + radius * cosf(angle), centre.y + radius * sinf(angle));
+        f.points[k][i] = lla_to_cm(f.points_lla[k][i]);
+    }
+    f.index[k].init(f.points[k], f.points_lla[k], n);
+}
+
+static void make_fence(synthetic_fence &f, uint8_t num_exclusions)
+{
+    uint32_t seed = 1;
+    f.num_polygons = 0;
+    make_polygon(f, seed, inclusion_points, Vector2l(0, 0), 200000);
+    for (uint8_t i=0; i<num_exclusions; i++) {
+        const Vector2l centre(int32_t(fence_rand(seed) % 160000) - 80000, int32_t(fence_rand(seed) % 160000) - 80000);
+        make_polygon(f, seed, exclusion_points, centre, 5000 + fence_rand(seed) % 10000);
+    }
+    for (uint16_t i=0; i<num_queries; i++) {
+        f.query_lla[i] = Vector2l(int32_t(fence_rand(seed) % 300000) - 150000, int32_t(fence_rand(seed) % 300000) - 150000);
+        f.query[i] = lla_to_cm(f.query_lla[i]);
+    }
+}
+
+static void free_fence(synthetic_fence &f)
+{
+    for (uint16_t k=0; k<f.num_polygons; k++) {
+        f.index[k].clear();
+        delete[] f.points[k];
+        delete[] f.points_lla[k];
+    }
+}
+
+/*
+  inside/outside and closest edge of every polygon scanning all edges,
+  as AC_PolyFence_loader::breached() did
+ */
+static void BM_FenceScan(benchmark::State& state)
+{
+    static synthetic_fence f;
+    make_fence(f, state.range(0));
+    uint16_t q = 0;
+    while (state.KeepRunning()) {
+        float sum = 0;
+        for (uint16_t k=0; k<f.num_polygons; k++) {
+            float distance;
+            if (Polygon_closest_distance_point(f.points[k], f.counts[k], f.query[q], distance)) {
+                sum += distance;
+            }
+            sum += Polygon_outside(f.query_lla[q], f.points_lla[k], f.counts[k]);
+        }
+        gbenchmark_escape(&sum);
+        q = (q + 1) % num_queries;
+    }
+    free_fence(f);
+}
+
+/*
+  the same queries through the index of each polygon
+ */
+static void BM_FenceIndex(benchmark::State& state)
+{
+    static synthetic_fence f;
+    make_fence(f, state.range(0));
+    uint16_t q = 0;
+    while (state.KeepRunning()) {
+        float sum = 0;
+        for (uint16_t k=0; k<f.num_polygons; k++) {
+            float distance;
+            if (f.index[k].closest_distance_point(f.query[q], distance)) {
+                sum += distance;
+            }
+            sum += f.index[k].outside(f.query_lla[q]);
+        }
+        gbenchmark_escape(&sum);
+        q = (q + 1) % num_queries;
+    }
+    free_fence(f);
+}
+
+/*
+  the index with distances only searched as far as the nearest
+  exclusion so far, as breached() does when outside them
+ */
+static void BM_FenceIndexLimited(benchmark::State& state)
+{
+    static synthetic_fence f;
+    make_fence(f, state.range(0));
+    uint16_t q = 0;
+    while (state.KeepRunning()) {
+        float nearest = FLT_MAX;
+        uint16_t num_inside = 0;
+        for (uint16_t k=0; k<f.num_polygons; k++) {
+            float distance;
+            if (f.index[k].closest_distance_point(f.query[q], distance, nearest) && distance < nearest) {
+                nearest = distance;
+            }
+            num_inside += !f.index[k].outside(f.query_lla[q]);
+        }
+        gbenchmark_escape(&nearest);
+        gbenchmark_escape(&num_inside);
+        q = (q + 1) % num_queries;
+    }
+    free_fence(f);
+}
+
+BENCHMARK(BM_FenceScan)->Arg(0)->Arg(8)->Arg(32);
+BENCHMARK(BM_FenceIndex)->Arg(0)->Arg(8)->Arg(32);
+BENCHMARK(BM_FenceIndexLimited)->Arg(0)->Arg(8)->Arg(32);
+
+BENCHMARK_MAIN();
@@ -23,6 +23,8 @@ template <typename T>
 bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
 template <typename T>
 bool        Polygon_complete(const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
+template <typename T>
+bool        Polygon_edge_crosses(const Vector2<T> &P, const Vector2<T> &Vi, const Vector2<T> &Vj) WARN_IF_UNUSED;
 
 /*
   determine if the polygon of N verticies defined by points V is
@@ -0,0 +1,104 @@
+#include <AP_gtest.h>
+#include <AP_Common/AP_Common.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/PolygonIndex.h>
+
+static uint32_t test_rand(uint32_t &seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+/*
+  star shaped polygons with jagged radii and runs of points of equal
+  longitude, checked against the full scans for points inside, outside,
+  on vertices and level with them
+ */
+static void check_polygon(uint32_t &seed, uint8_t n, bool closed)
+{
+    Vector2l points_lla[256];
+    Vector2f points[256];
+    const uint8_t ring = closed ? n-1 : n;
+    const int32_t radius = 1000 + test_rand(seed) % 200000;
+    for (uint8_t i=0; i<ring; i++) {
+        const float angle = M_2PI * i / ring;
+        const float r = radius * (0.3f + (test_rand(seed) % 1000) * 0.0007f);
+        points_lla[i] = Vector2l(r * cosf(angle), r * 1.5f * sinf(angle));
+        if (i % 7 == 3) {
+            points_lla[i].y = points_lla[i-1].y;
+        }
+    }
+    if (closed) {
+        points_lla[n-1] = points_lla[0];
+    }
+    for (uint8_t i=0; i<n; i++) {
+        points[i] = Vector2f(points_lla[i].x * 1.113195f, points_lla[i].y * 0.9f);
+    }
+
+    PolygonIndex index;
+    index.init(points, points_lla, n);
+    EXPECT_EQ(index.indexed(), n - (closed ? 1 : 0) >= POLYGON_INDEX_MIN_POINTS);
+
+    for (uint16_t q=0; q<500; q++) {
+        Vector2l P(int32_t(test_rand(seed) % (5 * radius)) - 5 * radius / 2,
+                   int32_t(test_rand(seed) % (5 * radius)) - 5 * radius / 2);
+        if (q % 10 == 0) {
+            P = points_lla[test_rand(seed) % n];
+        } else if (q % 10 == 1) {
+            P.y = points_lla[test_rand(seed) % n].y;
+        }
+        const Vector2f p(P.x * 1.113195f, P.y * 0.9f);
+
+        EXPECT_EQ(Polygon_outside(P, points_lla, n), index.outside(P));
+
+        float closest1, closest2;
+        const bool valid1 = Polygon_closest_distance_point(points, n, p, closest1);
+        EXPECT_EQ(valid1, index.closest_distance_point(p, closest2));
+        EXPECT_EQ(closest1, closest2);
+
+        // a limit may cut the search short, but only beyond it
+        const float limit = 1.0f + test_rand(seed) % radius;
+        EXPECT_EQ(valid1, index.closest_distance_point(p, closest2, limit));
+        if (closest1 < limit) {
+            EXPECT_EQ(closest1, closest2);
+        } else {
+            EXPECT_GE(closest2, limit);
+        }
+    }
+}
+
+TEST(PolygonIndex, matches_full_scan)
+{
+    uint32_t seed = 1;
+    for (uint16_t trial=0; trial<200; trial++) {
+        const uint8_t n = 4 + test_rand(seed) % 250;
+        check_polygon(seed, n, (trial % 2) == 0);
+    }
+}
+
+TEST(PolygonIndex, degenerate)
+{
+    PolygonIndex index;
+    index.init(nullptr, nullptr, 0);
+    EXPECT_TRUE(index.outside(Vector2l(0, 0)));
+    float closest;
+    EXPECT_FALSE(index.closest_distance_point(Vector2f(0, 0), closest));
+
+    // all points on one line of latitude/longitude
+    Vector2l points_lla[20];
+    Vector2f points[20];
+    for (uint8_t i=0; i<20; i++) {
+        points_lla[i] = Vector2l(i * 100, 0);
+        points[i] = Vector2f(i * 100, 0);
+    }
+    index.init(points, points_lla, 20);
+    EXPECT_FALSE(index.indexed());
+    EXPECT_EQ(Polygon_outside(Vector2l(50, 0), points_lla, 20), index.outside(Vector2l(50, 0)));
+    float closest2;
+    EXPECT_EQ(Polygon_closest_distance_point(points, 20, Vector2f(50, 10), closest),
+              index.closest_distance_point(Vector2f(50, 10), closest2));
+    EXPECT_EQ(closest, closest2);
+}
+
+AP_GTEST_MAIN()
@@ -300,8 +300,14 @@ bool AP_Mission::clear()
 void AP_Mission::truncate(uint16_t index)
 {
     if ((unsigned)_cmd_total > index) {
+        WITH_SEMAPHORE(_rsem);
         _cmd_total.set_and_save(index);
         _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_JUMP_TAG_TABLE_SIZE > 0
+        // cached commands beyond the end are never returned, and are
+        // invalidated when they are rewritten
+        _jump_tag_table.valid = false;
+#endif
     }
 }
 
@@ -832,6 +838,14 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    Mission_Command &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+    if (cached.index == index) {
+        cmd = cached;
+        return true;
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -890,6 +904,10 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    cached = cmd;
+#endif
+
     // return success
     return true;
 }
@@ -954,6 +972,8 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         memcpy(packed.bytes, &cmd.content, 12);
     }
 
+    invalidate_cmd_cache(index);
+
     // calculate where in storage the command should be placed
     uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
 
@@ -988,6 +1008,21 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
     return true;
 }
 
+/// invalidate_cmd_cache - forget any decoded copy of the command at
+///     index, and the jump tag table. Must be called with _rsem held
+void AP_Mission::invalidate_cmd_cache(uint16_t index)
+{
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    Mission_Command &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+    if (cached.index == index) {
+        cached.index = 0;
+    }
+#endif
+#if AP_MISSION_JUMP_TAG_TABLE_SIZE > 0
+    _jump_tag_table.valid = false;
+#endif
+}
+
 /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
 ///     home is taken directly from ahrs
 void AP_Mission::write_home_to_storage()
@@ -2294,6 +2329,49 @@ bool AP_Mission::jump_to_tag(const uint16_t tag)
 uint16_t AP_Mission::get_index_of_jump_tag(const uint16_t tag) const
 {
     const auto count = num_commands();
+#if AP_MISSION_JUMP_TAG_TABLE_SIZE > 0
+    WITH_SEMAPHORE(_rsem);
+    if (!_jump_tag_table.valid) {
+        _jump_tag_table.count = 0;
+        _jump_tag_table.overflow = false;
+        for (uint16_t i = 1; i < count; i++) {
+            if (get_command_id(i) != uint16_t(MAV_CMD_JUMP_TAG)) {
+                continue;
+            }
+            Mission_Command tmp;
+            if (!read_cmd_from_storage(i, tmp) || tmp.id != MAV_CMD_JUMP_TAG) {
+                continue;
+            }
+            bool found = false;
+            for (uint8_t j = 0; j < _jump_tag_table.count; j++) {
+                if (_jump_tag_table.items[j].tag == tmp.content.jump.target) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                continue;
+            }
+            if (_jump_tag_table.count >= ARRAY_SIZE(_jump_tag_table.items)) {
+                _jump_tag_table.overflow = true;
+                break;
+            }
+            _jump_tag_table.items[_jump_tag_table.count].tag = tmp.content.jump.target;
+            _jump_tag_table.items[_jump_tag_table.count].index = i;
+            _jump_tag_table.count++;
+        }
+        _jump_tag_table.valid = true;
+    }
+    for (uint8_t j = 0; j < _jump_tag_table.count; j++) {
+        if (_jump_tag_table.items[j].tag == tag) {
+            return _jump_tag_table.items[j].index;
+        }
+    }
+    if (!_jump_tag_table.overflow) {
+        return 0;
+    }
+    // too many tags to remember them all, search the rest of the mission
+#endif
     for (uint16_t i = 1; i < count; i++) {
         if (get_command_id(i) != uint16_t(MAV_CMD_JUMP_TAG)) {
             continue;
@@ -2925,6 +3003,15 @@ const char *AP_Mission::Mission_Command::type() const
  */
 uint16_t AP_Mission::get_command_id(uint16_t index) const
 {
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    {
+        WITH_SEMAPHORE(_rsem);
+        const Mission_Command &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+        if (index != 0 && cached.index == index) {
+            return cached.id;
+        }
+    }
+#endif
     const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
     uint8_t b[3] {};
     if (!_storage.read_block(b, pos_in_storage, sizeof(b))) {
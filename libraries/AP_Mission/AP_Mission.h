@@ -34,6 +34,24 @@
 #endif
 #endif
 
+#ifndef AP_MISSION_CMD_CACHE_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000
+#define AP_MISSION_CMD_CACHE_SIZE           256     // number of decoded commands cached in RAM
+#elif HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_MISSION_CMD_CACHE_SIZE           64      // number of decoded commands cached in RAM
+#else
+#define AP_MISSION_CMD_CACHE_SIZE           0       // no command cache
+#endif
+#endif
+
+#ifndef AP_MISSION_JUMP_TAG_TABLE_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_MISSION_JUMP_TAG_TABLE_SIZE      16      // number of distinct JUMP_TAG tags remembered
+#else
+#define AP_MISSION_JUMP_TAG_TABLE_SIZE      0       // always search the mission for tags
+#endif
+#endif
+
 #define AP_MISSION_JUMP_REPEAT_FOREVER      -1      // when do-jump command's repeat count is -1 this means endless repeat
 
 #define AP_MISSION_CMD_ID_NONE              0       // mavlink cmd id of zero means invalid or missing command
@@ -930,6 +948,31 @@ private:
     // fast call to get command ID of a mission index
     uint16_t get_command_id(uint16_t index) const;
 
+#if AP_MISSION_CMD_CACHE_SIZE > 0
+    // direct mapped cache of decoded commands, indexed by command
+    // index modulo the cache size. A slot holding index 0 is empty as
+    // home is never read from storage. Protected by _rsem
+    mutable Mission_Command _cmd_cache[AP_MISSION_CMD_CACHE_SIZE];
+#endif
+
+#if AP_MISSION_JUMP_TAG_TABLE_SIZE > 0
+    // index of the first JUMP_TAG for each tag in the mission, built
+    // on demand and invalidated on any change. Protected by _rsem
+    mutable struct {
+        struct {
+            uint16_t tag;
+            uint16_t index;
+        } items[AP_MISSION_JUMP_TAG_TABLE_SIZE];
+        uint8_t count;
+        bool valid;
+        bool overflow;  // more tags than fit in items
+    } _jump_tag_table;
+#endif
+
+    // invalidate cached copies of a command and anything derived
+    // from the mission contents
+    void invalidate_cmd_cache(uint16_t index);
+
     // memoisation of contains-relative:
     bool _contains_terrain_alt_items;  // true if the mission has terrain-relative items
     uint32_t _last_contains_relative_calculated_ms;  // will be equal to _last_change_time_ms if _contains_terrain_alt_items is up-to-date
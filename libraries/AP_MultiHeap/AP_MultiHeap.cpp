@@ -203,4 +203,21 @@ void *MultiHeap::change_size(void *ptr, uint32_t old_size, uint32_t new_size)
     return newp;
 }
 
+/*
+  get free space and fragmentation statistics over all heaps
+ */
+void MultiHeap::get_stats(Stats &st) const
+{
+    st = {};
+    if (!available()) {
+        return;
+    }
+    st.total_size = sum_size;
+    for (uint8_t i=0; i<num_heaps; i++) {
+        if (heaps[i].hp != nullptr) {
+            heap_stats(heaps[i].hp, st);
+        }
+    }
+}
+
 #endif // ENABLE_HEAP
@@ -42,6 +42,17 @@ public:
         return expanded_to;
     }
 
+    /*
+      free space and fragmentation over all heaps
+     */
+    struct Stats {
+        uint32_t total_size;    // total size of all heaps
+        uint32_t free_bytes;    // bytes free for allocation
+        uint32_t largest_free;  // largest free block
+        uint32_t free_blocks;   // number of free blocks
+    };
+    void get_stats(Stats &st) const;
+
 private:
     struct Heap {
         void *hp;
@@ -78,6 +89,9 @@ private:
     // free some memory that was allocated by heap_allocate. The implementation must
     // be able to determine which heap the allocation was from using the pointer
     void heap_free(void *ptr);
+
+    // add the free space and fragmentation of a heap to st
+    void heap_stats(void *heap, Stats &st) const;
 };
 
 #endif // ENABLE_HEAP
@@ -4,6 +4,7 @@
 
 #include "AP_MultiHeap.h"
 #include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Math/AP_Math.h>
 
 #if ENABLE_HEAP && CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
 
@@ -44,4 +45,12 @@ void MultiHeap::heap_free(void *ptr)
     return chHeapFree(ptr);
 }
 
+void MultiHeap::heap_stats(void *heap, Stats &st) const
+{
+    size_t total_free, largest_free;
+    st.free_blocks += chHeapStatus((memory_heap_t *)heap, &total_free, &largest_free);
+    st.free_bytes += total_free;
+    st.largest_free = MAX(st.largest_free, largest_free);
+}
+
 #endif // ENABLE_HEAP && CONFIG_HAL_BOARD
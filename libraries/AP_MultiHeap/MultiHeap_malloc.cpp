@@ -4,41 +4,243 @@
 #if ENABLE_HEAP && CONFIG_HAL_BOARD != HAL_BOARD_CHIBIOS
 
 /*
-  on systems other than chibios we map the allocation to the system
-  malloc/free functions
+  on systems other than chibios each heap is a single region taken
+  from the system malloc at creation time. Allocations within the
+  region use a two level segregated fit (TLSF) allocator, giving O(1)
+  allocate and free without touching the system allocator, and so
+  without contending with other threads for the malloc lock
  */
 
 #include <AP_InternalError/AP_InternalError.h>
+#include <AP_Math/AP_Math.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*
-  low level allocator interface using system malloc
+  all blocks are aligned to and a multiple of TLSF_ALIGN bytes. Free
+  blocks are kept on lists indexed by a first level (power of two)
+  and second level (linear subdivision of that power of two) size
+  class, with a bitmap per level giving constant time search
  */
+#define TLSF_ALIGN_LOG2     4
+#define TLSF_ALIGN          (1U<<TLSF_ALIGN_LOG2)
+#define TLSF_SL_LOG2        4
+#define TLSF_SL_COUNT       (1U<<TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT       (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_MAX         30
+#define TLSF_FL_COUNT       (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK    (1U<<TLSF_FL_SHIFT)
+#define TLSF_HEADER_SIZE    TLSF_ALIGN
+#define TLSF_MIN_BLOCK      TLSF_ALIGN
+// largest heap we will create, keeping block sizes within the first level index
+#define TLSF_MAX_HEAP_SIZE  (1U<<(TLSF_FL_MAX-1))
+
+// block flags, doubling as a check against bad or double frees
+#define TLSF_BLOCK_USED     0xa5c3e100U
+#define TLSF_BLOCK_FREE     0xa5c3e101U
+
 /*
-  default functions for heap management for lua scripting for systems
-  that don't have the ability to create separable heaps
+  header at the start of each block. The payload follows the header
+  at an offset of TLSF_HEADER_SIZE
  */
+struct tlsf_block {
+    struct tlsf_block *prev_phys; // previous block in memory, nullptr for the first block
+    uint32_t size;                // payload size, not including this header
+    uint32_t flags;
+};
 
-struct heap_allocation_header {
-    struct heap *hp;
-    uint32_t allocation_size; // size of allocated block, not including this header
+/*
+  free list links, stored in the payload of free blocks
+ */
+struct tlsf_links {
+    struct tlsf_block *next;
+    struct tlsf_block *prev;
 };
 
+static_assert(sizeof(tlsf_block) <= TLSF_HEADER_SIZE, "TLSF header too large");
+static_assert(sizeof(tlsf_links) <= TLSF_MIN_BLOCK, "TLSF minimum block too small");
+
 #define HEAP_MAGIC 0x5681ef9f
 
 struct heap {
     uint32_t magic;
     uint32_t max_heap_size;
-    uint32_t current_heap_usage;
+    uint32_t current_heap_usage; // bytes in allocated blocks, including headers
+    uint32_t free_bytes;         // payload bytes in free blocks
+    uint32_t free_blocks;        // number of free blocks
+    uint8_t *region_start;
+    uint8_t *region_end;
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[TLSF_FL_COUNT];
+    struct tlsf_block *free_list[TLSF_FL_COUNT][TLSF_SL_COUNT];
 };
 
+static inline uint8_t tlsf_fls(uint32_t v)
+{
+    return 31 - __builtin_clz(v);
+}
+
+static inline uint8_t tlsf_ffs(uint32_t v)
+{
+    return __builtin_ctz(v);
+}
+
+static inline uint8_t *tlsf_payload(struct tlsf_block *b)
+{
+    return (uint8_t *)b + TLSF_HEADER_SIZE;
+}
+
+static inline struct tlsf_links *tlsf_block_links(struct tlsf_block *b)
+{
+    return (struct tlsf_links *)tlsf_payload(b);
+}
+
+static inline struct tlsf_block *tlsf_next_phys(struct tlsf_block *b)
+{
+    return (struct tlsf_block *)(tlsf_payload(b) + b->size);
+}
+
+/*
+  get the free list index holding blocks of a given size
+ */
+static void tlsf_mapping_insert(uint32_t size, uint8_t &fl, uint8_t &sl)
+{
+    if (size < TLSF_SMALL_BLOCK) {
+        // small blocks get one list per size
+        fl = 0;
+        sl = size >> TLSF_ALIGN_LOG2;
+    } else {
+        const uint8_t b = tlsf_fls(size);
+        sl = (size >> (b - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        fl = b - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+/*
+  get the first free list index where every block is at least size bytes
+ */
+static void tlsf_mapping_search(uint32_t size, uint8_t &fl, uint8_t &sl)
+{
+    if (size >= TLSF_SMALL_BLOCK) {
+        size += (1U << (tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+    }
+    tlsf_mapping_insert(size, fl, sl);
+}
+
+static void tlsf_insert_free(struct heap *heapp, struct tlsf_block *b)
+{
+    uint8_t fl, sl;
+    tlsf_mapping_insert(b->size, fl, sl);
+    auto *links = tlsf_block_links(b);
+    links->next = heapp->free_list[fl][sl];
+    links->prev = nullptr;
+    if (links->next != nullptr) {
+        tlsf_block_links(links->next)->prev = b;
+    }
+    heapp->free_list[fl][sl] = b;
+    heapp->fl_bitmap |= 1U << fl;
+    heapp->sl_bitmap[fl] |= 1U << sl;
+    b->flags = TLSF_BLOCK_FREE;
+    heapp->free_bytes += b->size;
+    heapp->free_blocks++;
+}
+
+static void tlsf_remove_free(struct heap *heapp, struct tlsf_block *b)
+{
+    uint8_t fl, sl;
+    tlsf_mapping_insert(b->size, fl, sl);
+    auto *links = tlsf_block_links(b);
+    if (links->prev != nullptr) {
+        tlsf_block_links(links->prev)->next = links->next;
+    } else {
+        heapp->free_list[fl][sl] = links->next;
+        if (links->next == nullptr) {
+            heapp->sl_bitmap[fl] &= ~(1U << sl);
+            if (heapp->sl_bitmap[fl] == 0) {
+                heapp->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+    if (links->next != nullptr) {
+        tlsf_block_links(links->next)->prev = links->prev;
+    }
+    heapp->free_bytes -= b->size;
+    heapp->free_blocks--;
+}
+
+/*
+  find a free block of at least size bytes, or nullptr
+ */
+static struct tlsf_block *tlsf_find_free(struct heap *heapp, uint32_t size)
+{
+    uint8_t fl, sl;
+    tlsf_mapping_search(size, fl, sl);
+    if (fl >= TLSF_FL_COUNT) {
+        return nullptr;
+    }
+    uint32_t sl_map = heapp->sl_bitmap[fl] & (~0U << sl);
+    if (sl_map == 0) {
+        // nothing in this first level, use the next larger one
+        const uint32_t fl_map = heapp->fl_bitmap & (~0U << (fl + 1));
+        if (fl_map == 0) {
+            return nullptr;
+        }
+        fl = tlsf_ffs(fl_map);
+        sl_map = heapp->sl_bitmap[fl];
+    }
+    sl = tlsf_ffs(sl_map);
+    return heapp->free_list[fl][sl];
+}
+
+/*
+  size of the largest free block. The largest block is on the highest
+  non-empty list, which is usually short
+ */
+static uint32_t tlsf_largest_free(struct heap *heapp)
+{
+    if (heapp->fl_bitmap == 0) {
+        return 0;
+    }
+    const uint8_t fl = tlsf_fls(heapp->fl_bitmap);
+    const uint8_t sl = tlsf_fls(heapp->sl_bitmap[fl]);
+    uint32_t largest = 0;
+    for (auto *b = heapp->free_list[fl][sl]; b != nullptr; b = tlsf_block_links(b)->next) {
+        largest = MAX(largest, b->size);
+    }
+    return largest;
+}
+
 void *MultiHeap::heap_create(uint32_t size)
 {
-    struct heap *new_heap = (struct heap*)malloc(sizeof(struct heap));
-    if (new_heap != nullptr) {
-        new_heap->magic = HEAP_MAGIC;
-        new_heap->max_heap_size = size;
+    if (size > TLSF_MAX_HEAP_SIZE || size < 2*TLSF_HEADER_SIZE + TLSF_MIN_BLOCK) {
+        return nullptr;
     }
+    // the heap state and the block region come from a single
+    // allocation, with room to align the start of the region
+    auto *mem = (uint8_t *)malloc(sizeof(struct heap) + TLSF_ALIGN + size);
+    if (mem == nullptr) {
+        return nullptr;
+    }
+    struct heap *new_heap = (struct heap *)mem;
+    memset(new_heap, 0, sizeof(*new_heap));
+    new_heap->magic = HEAP_MAGIC;
+    new_heap->max_heap_size = size;
+
+    const uintptr_t start = ((uintptr_t)(mem + sizeof(struct heap)) + TLSF_ALIGN - 1) & ~uintptr_t(TLSF_ALIGN - 1);
+    new_heap->region_start = (uint8_t *)start;
+    new_heap->region_end = new_heap->region_start + (size & ~(TLSF_ALIGN - 1));
+
+    // one free block covering the region, followed by a zero sized
+    // allocated sentinel so the last block never merges past the end
+    auto *b = (struct tlsf_block *)new_heap->region_start;
+    b->prev_phys = nullptr;
+    b->size = (new_heap->region_end - new_heap->region_start) - 2*TLSF_HEADER_SIZE;
+    auto *sentinel = tlsf_next_phys(b);
+    sentinel->prev_phys = b;
+    sentinel->size = 0;
+    sentinel->flags = TLSF_BLOCK_USED;
+    tlsf_insert_free(new_heap, b);
+
     return (void *)new_heap;
 }
 
@@ -59,7 +261,7 @@ void MultiHeap::heap_destroy(void *heap_ptr)
     }
 #endif
 
-    // free the heap structure
+    // free the heap structure and its region
     free(heapp);
 }
 
@@ -76,25 +278,33 @@ void *MultiHeap::heap_allocate(void *heap_ptr, uint32_t size)
         INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
         return nullptr;
     }
-
-    if (heapp->current_heap_usage + size > heapp->max_heap_size) {
-        // fail the allocation as we don't have the memory. Note that
-        // we don't simulate the fragmentation that we would get with
-        // HAL_ChibiOS
+    if (size > heapp->max_heap_size) {
         return nullptr;
     }
 
-    auto *header = (heap_allocation_header *)malloc(size + sizeof(heap_allocation_header));
-    if (header == nullptr) {
-        // can't allocate the new memory
+    const uint32_t block_size = MAX((size + TLSF_ALIGN - 1) & ~(TLSF_ALIGN - 1), TLSF_MIN_BLOCK);
+    auto *b = tlsf_find_free(heapp, block_size);
+    if (b == nullptr) {
+        // no free block large enough, which may be due to fragmentation
         return nullptr;
     }
-    header->hp = heapp;
-    header->allocation_size = size;
+    tlsf_remove_free(heapp, b);
+
+    if (b->size >= block_size + TLSF_HEADER_SIZE + TLSF_MIN_BLOCK) {
+        // split off the remainder as a new free block. Its next
+        // neighbour is in use, as free neighbours are always merged
+        auto *rem = (struct tlsf_block *)(tlsf_payload(b) + block_size);
+        rem->prev_phys = b;
+        rem->size = b->size - block_size - TLSF_HEADER_SIZE;
+        tlsf_next_phys(rem)->prev_phys = rem;
+        b->size = block_size;
+        tlsf_insert_free(heapp, rem);
+    }
+    b->flags = TLSF_BLOCK_USED;
 
-    heapp->current_heap_usage += size;
+    heapp->current_heap_usage += b->size + TLSF_HEADER_SIZE;
 
-    return header + 1;
+    return tlsf_payload(b);
 }
 
 /*
@@ -102,18 +312,58 @@ void *MultiHeap::heap_allocate(void *heap_ptr, uint32_t size)
  */
 void MultiHeap::heap_free(void *ptr)
 {
-    // extract header
-    auto *header = ((struct heap_allocation_header *)ptr)-1;
-    auto *heapp = header->hp;
-    if (heapp->magic != HEAP_MAGIC) {
+    // find the heap whose region holds this pointer
+    struct heap *heapp = nullptr;
+    for (uint8_t i=0; i<num_heaps; i++) {
+        auto *hp = (struct heap *)heaps[i].hp;
+        if (hp != nullptr && (uint8_t *)ptr > hp->region_start && (uint8_t *)ptr < hp->region_end) {
+            heapp = hp;
+            break;
+        }
+    }
+    if (heapp == nullptr || heapp->magic != HEAP_MAGIC) {
         INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
         return;
     }
-    const uint32_t size = header->allocation_size;
-    heapp->current_heap_usage -= size;
+    auto *b = (struct tlsf_block *)((uint8_t *)ptr - TLSF_HEADER_SIZE);
+    if (b->flags != TLSF_BLOCK_USED) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return;
+    }
+    heapp->current_heap_usage -= b->size + TLSF_HEADER_SIZE;
+
+    // merge with free neighbours
+    auto *prev = b->prev_phys;
+    if (prev != nullptr && prev->flags == TLSF_BLOCK_FREE) {
+        tlsf_remove_free(heapp, prev);
+        b->flags = 0;
+        prev->size += TLSF_HEADER_SIZE + b->size;
+        b = prev;
+        tlsf_next_phys(b)->prev_phys = b;
+    }
+    auto *next = tlsf_next_phys(b);
+    if (next->flags == TLSF_BLOCK_FREE) {
+        tlsf_remove_free(heapp, next);
+        next->flags = 0;
+        b->size += TLSF_HEADER_SIZE + next->size;
+        tlsf_next_phys(b)->prev_phys = b;
+    }
+    tlsf_insert_free(heapp, b);
+}
 
-    // free the memory
-    free(header);
+/*
+  add free space and fragmentation of a heap to the statistics
+ */
+void MultiHeap::heap_stats(void *heap_ptr, Stats &st) const
+{
+    struct heap *heapp = (struct heap*)heap_ptr;
+    if (heapp->magic != HEAP_MAGIC) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return;
+    }
+    st.free_bytes += heapp->free_bytes;
+    st.free_blocks += heapp->free_blocks;
+    st.largest_free = MAX(st.largest_free, tlsf_largest_free(heapp));
 }
 
 #endif // ENABLE_HEAP && CONFIG_HAL_BOARD != HAL_BOARD_CHIBIOS
@@ -0,0 +1,147 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_MultiHeap/AP_MultiHeap.h>
+
+#include <stdlib.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if ENABLE_HEAP
+
+/*
+  replay a Lua allocation trace. Each entry resizes one live slot as
+  lua_Alloc would, with a size of zero freeing it. The trace is built
+  the way a 50Hz script allocates: short lived strings grown by
+  concatenation, table arrays doubling, small closures and userdata,
+  and periodic collection of garbage
+ */
+struct trace_op {
+    uint16_t slot;
+    uint32_t size;
+};
+
+static const uint16_t trace_slots = 512;
+
+static uint32_t trace_rand(uint32_t &seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+// builds the trace, returning the index of the final frees
+static uint32_t build_trace(trace_op *ops, uint32_t &num_ops, uint32_t max_ops)
+{
+    uint32_t sizes[trace_slots] {};
+    uint32_t seed = 1;
+    num_ops = 0;
+    while (num_ops < max_ops) {
+        const uint16_t slot = trace_rand(seed) % trace_slots;
+        uint32_t size;
+        switch (trace_rand(seed) % 8) {
+        case 0:
+        case 1:
+        case 2:
+            // string being built by concatenation
+            size = sizes[slot] != 0 && sizes[slot] < 400 ? sizes[slot] + 8 + trace_rand(seed) % 24 : 24 + trace_rand(seed) % 40;
+            break;
+        case 3:
+            // table array part doubling
+            size = sizes[slot] >= 16 && sizes[slot] < 2048 ? sizes[slot] * 2 : 16;
+            break;
+        case 4:
+        case 5:
+            // closures, upvalues and userdata
+            size = 32 + 8 * (trace_rand(seed) % 8);
+            break;
+        default:
+            // garbage collected
+            size = 0;
+            break;
+        }
+        if (size == 0 && sizes[slot] == 0) {
+            continue;
+        }
+        ops[num_ops++] = { slot, size };
+        sizes[slot] = size;
+    }
+    // free everything left at the end of the trace
+    const uint32_t final_frees = num_ops;
+    for (uint16_t slot = 0; slot < trace_slots; slot++) {
+        if (sizes[slot] != 0) {
+            ops[num_ops++] = { slot, 0 };
+        }
+    }
+    return final_frees;
+}
+
+static void BM_MultiHeapTrace(benchmark::State& state)
+{
+    const uint32_t max_ops = state.range(0);
+    auto *ops = new trace_op[max_ops + trace_slots];
+    uint32_t num_ops;
+    const uint32_t final_frees = build_trace(ops, num_ops, max_ops);
+
+    static MultiHeap heap;
+    heap.create(1024*1024, 10, false, 0);
+    void *ptrs[trace_slots] {};
+    uint32_t sizes[trace_slots] {};
+
+    auto replay = [&](uint32_t start, uint32_t end) {
+        for (uint32_t i = start; i < end; i++) {
+            const auto &op = ops[i];
+            ptrs[op.slot] = heap.change_size(ptrs[op.slot], sizes[op.slot], op.size);
+            sizes[op.slot] = ptrs[op.slot] != nullptr ? op.size : 0;
+        }
+    };
+
+    while (state.KeepRunning()) {
+        replay(0, num_ops);
+        gbenchmark_escape(ptrs);
+    }
+
+    // report fragmentation with the trace's live set still allocated
+    replay(0, final_frees);
+    MultiHeap::Stats st;
+    heap.get_stats(st);
+    state.counters["free_bytes"] = st.free_bytes;
+    state.counters["largest_free"] = st.largest_free;
+    state.counters["free_blocks"] = st.free_blocks;
+    replay(final_frees, num_ops);
+    heap.destroy();
+    delete[] ops;
+}
+
+/*
+  the same trace through the system allocator, as a baseline
+ */
+static void BM_MallocTrace(benchmark::State& state)
+{
+    const uint32_t max_ops = state.range(0);
+    auto *ops = new trace_op[max_ops + trace_slots];
+    uint32_t num_ops;
+    build_trace(ops, num_ops, max_ops);
+
+    void *ptrs[trace_slots] {};
+
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < num_ops; i++) {
+            const auto &op = ops[i];
+            if (op.size == 0) {
+                free(ptrs[op.slot]);
+                ptrs[op.slot] = nullptr;
+            } else {
+                ptrs[op.slot] = realloc(ptrs[op.slot], op.size);
+            }
+        }
+        gbenchmark_escape(ptrs);
+    }
+    delete[] ops;
+}
+
+BENCHMARK(BM_MultiHeapTrace)->RangeMultiplier(4)->Range(1024, 65536);
+BENCHMARK(BM_MallocTrace)->RangeMultiplier(4)->Range(1024, 65536);
+
+#endif // ENABLE_HEAP
+
+BENCHMARK_MAIN();
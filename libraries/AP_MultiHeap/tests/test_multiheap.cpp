@@ -54,4 +54,42 @@ TEST(MultiHeap, Tests)
     delete[] allocs;
 }
 
+TEST(MultiHeap, Stats)
+{
+    static MultiHeap h;
+
+    EXPECT_TRUE(h.create(20000, 1, false, 0));
+    MultiHeap::Stats st0;
+    h.get_stats(st0);
+    EXPECT_EQ(st0.total_size, 20000U);
+    EXPECT_GT(st0.free_bytes, 0U);
+    EXPECT_LE(st0.free_bytes, st0.total_size);
+
+    // free every other block to fragment the heap
+    void *ptrs[20] {};
+    for (auto &p : ptrs) {
+        p = h.allocate(500);
+        EXPECT_NE(p, nullptr);
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(ptrs); i+=2) {
+        h.deallocate(ptrs[i]);
+        ptrs[i] = nullptr;
+    }
+    MultiHeap::Stats st;
+    h.get_stats(st);
+    EXPECT_GE(st.free_blocks, ARRAY_SIZE(ptrs)/2);
+    EXPECT_LT(st.largest_free, st.free_bytes);
+
+    // freeing the rest should merge back to the starting state
+    for (auto &p : ptrs) {
+        h.deallocate(p);
+        p = nullptr;
+    }
+    h.get_stats(st);
+    EXPECT_EQ(st.free_bytes, st0.free_bytes);
+    EXPECT_EQ(st.largest_free, st0.largest_free);
+    EXPECT_EQ(st.free_blocks, st0.free_blocks);
+    h.destroy();
+}
+
 AP_GTEST_MAIN()
@@ -18,7 +18,6 @@
 
 NavEKF_core_common::Matrix24 NavEKF_core_common::KH;
 NavEKF_core_common::Matrix24 NavEKF_core_common::KHP;
-NavEKF_core_common::Matrix24 NavEKF_core_common::nextP;
 NavEKF_core_common::Vector28 NavEKF_core_common::Kfusion;
 
 /*
@@ -33,7 +32,6 @@ void NavEKF_core_common::fill_scratch_variables(void)
     // iterations
     fill_nanf(&KH[0][0], sizeof(KH)/sizeof(ftype));
     fill_nanf(&KHP[0][0], sizeof(KHP)/sizeof(ftype));
-    fill_nanf(&nextP[0][0], sizeof(nextP)/sizeof(ftype));
     fill_nanf(&Kfusion[0], sizeof(Kfusion)/sizeof(ftype));
 #endif
 }
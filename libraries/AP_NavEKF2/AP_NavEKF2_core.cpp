@@ -10,6 +10,9 @@ extern const AP_HAL::HAL& hal;
 
 #define earthRate 0.000072921f // earth rotation rate (rad/sec)
 
+// covariance prediction scratch space shared by all cores
+NavEKF2_core::Matrix24 NavEKF2_core::nextP;
+
 // initial imu bias uncertainty (deg/sec)
 #define INIT_ACCEL_BIAS_UNCERTAINTY 0.5f
 
@@ -543,6 +546,9 @@ void NavEKF2_core::UpdateFilter(bool predict)
 #endif
 
     fill_scratch_variables();
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf(&nextP[0][0], sizeof(nextP)/sizeof(ftype));
+#endif
 
     // TODO - in-flight restart method
 
@@ -30,6 +30,7 @@ class EKFGSF_yaw;
 
 class NavEKF3 {
     friend class NavEKF3_core;
+    friend class NavEKF3_core_Benchmark;
 
 public:
     NavEKF3();
@@ -7,6 +7,9 @@
 #include <AP_Logger/AP_Logger.h>
 #include <AP_DAL/AP_DAL.h>
 
+// covariance prediction scratch space shared by all cores
+NavEKF3_core::PackedMatrix24 NavEKF3_core::nextP;
+
 // constructor
 NavEKF3_core::NavEKF3_core(NavEKF3 *_frontend, AP_DAL &_dal) :
     dal(_dal),
@@ -632,6 +635,9 @@ void NavEKF3_core::UpdateFilter(bool predict)
     }
 
     fill_scratch_variables();
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf(&nextP[0][0], sizeof(nextP)/sizeof(ftype));
+#endif
 
     // update sensor selection (for affinity)
     update_sensor_selection();
@@ -1182,7 +1188,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     }
 
     // calculate the predicted covariance due to inertial sensor error propagation
-    // we calculate the lower diagonal and copy to take advantage of symmetry
+    // we calculate the upper diagonal into packed storage and copy to take advantage of symmetry
 
     // intermediate calculations
     const ftype PS0 = sq(q1);
@@ -1421,7 +1427,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
     nextP[3][3] = PS0*PS3 + PS1*PS2 - PS11*PS156 + PS12*PS152 + PS13*PS153 + PS151*PS7 - PS154*PS34 - PS155*PS6 + PS157 + PS5*PS95;
 
     if (quatCovResetOnly) {
-        // covariance matrix is symmetrical, so copy diagonals and copy lower half in nextP
+        // covariance matrix is symmetrical, so copy diagonals and copy upper half in nextP
         // to lower and upper half in P
         for (uint8_t row = 0; row <= 3; row++) {
             // copy diagonals
@@ -1751,7 +1757,7 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
         for (uint8_t index=0; index<3; index++) {
             const uint8_t stateIndex = index + 13;
             if (dvelBiasAxisInhibit[index]) {
-                zeroCols(nextP,stateIndex,stateIndex);
+                nextP.zeroCol(stateIndex);
                 nextP[stateIndex][stateIndex] = dvelBiasAxisVarPrev[index];
             }
         }
@@ -1766,20 +1772,21 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
         {
             for (uint8_t j=0; j<=stateIndexLim; j++)
             {
-                nextP[i][j] = P[i][j];
-                nextP[j][i] = P[j][i];
+                // only the upper half is stored
+                if (j < i) {
+                    nextP[j][i] = P[j][i];
+                } else {
+                    nextP[i][j] = P[i][j];
+                }
             }
         }
     }
 
-    // covariance matrix is symmetrical, so copy diagonals and copy lower half in nextP
-    // to lower and upper half in P
+    // covariance matrix is symmetrical, so copy the upper half in nextP
+    // to lower and upper half in P, reading each packed row in order
     for (uint8_t row = 0; row <= stateIndexLim; row++) {
-        // copy diagonals
-        P[row][row] = nextP[row][row];
-        // copy off diagonals
-        for (uint8_t column = 0 ; column < row; column++) {
-            P[row][column] = P[column][row] = nextP[column][row];
+        for (uint8_t column = row; column <= stateIndexLim; column++) {
+            P[row][column] = P[column][row] = nextP[row][column];
         }
     }
 
@@ -1797,6 +1804,14 @@ void NavEKF3_core::CovariancePrediction(Vector3F *rotVarVecPtr)
 #endif
 }
 
+// zero the stored part of a column of the packed predicted covariance matrix
+void NavEKF3_core::PackedMatrix24::zeroCol(uint8_t index)
+{
+    for (uint8_t row = 0; row <= index; row++) {
+        (*this)[row][index] = 0;
+    }
+}
+
 // zero specified range of rows in the state covariance matrix
 void NavEKF3_core::zeroRows(Matrix24 &covMat, uint8_t first, uint8_t last)
 {
@@ -126,6 +126,8 @@
 
 class NavEKF3_core : public NavEKF_core_common
 {
+    friend class NavEKF3_core_Benchmark;
+
 public:
     // Constructor
     NavEKF3_core(class NavEKF3 *_frontend, class AP_DAL &dal);
@@ -549,6 +551,43 @@ private:
     typedef uint32_t Vector_u32_50[50];
 #endif
 
+    /*
+      upper triangle of a symmetric 24x24 matrix, packed row by row so
+      that element [row][col] with row <= col is stored at
+      row*(47-row)/2 + col. This holds 300 rather than 576 elements
+      while keeping the [row][col] syntax used by the generated
+      covariance prediction code. Each row of the upper half is
+      contiguous, as it is in a full matrix, so the compiler can still
+      combine the stores of neighbouring elements in a row.
+     */
+    class PackedMatrix24 {
+    public:
+#if MATH_CHECK_INDEXES
+        class Row {
+        public:
+            Row(ftype *v, uint8_t row) : _v(v), _row(row) {}
+            ftype &operator[](uint8_t col) const {
+                assert(_row <= col && col < 24);
+                return _v[col];
+            }
+        private:
+            ftype *_v;
+            const uint8_t _row;
+        };
+
+        Row operator[](uint8_t row) { return Row(&_v[row*(47-row)/2], row); }
+#else
+        // a plain pointer, so that the accessor is always inlined
+        ftype *operator[](uint8_t row) { return &_v[row*(47-row)/2]; }
+#endif
+
+        // zero the stored part of a column, nextP[0..index][index]
+        void zeroCol(uint8_t index);
+
+    private:
+        ftype _v[24*25/2];
+    };
+
     // the states are available in two forms, either as a Vector24, or
     // broken down as individual elements. Both are equivalent (same
     // memory)
@@ -1075,6 +1114,7 @@ private:
 
     ftype gpsNoiseScaler;           // Used to scale the  GPS measurement noise and consistency gates to compensate for operation with small satellite counts
     Matrix24 P;                     // covariance matrix
+    static PackedMatrix24 nextP;    // upper half of the predicted covariance matrix, scratch space shared by all cores
     EKF_IMU_buffer_t<imu_elements> storedIMU;      // IMU data buffer
     EKF_obs_buffer_t<gps_elements> storedGPS;      // GPS data buffer
     EKF_obs_buffer_t<mag_elements> storedMag;      // Magnetometer data buffer
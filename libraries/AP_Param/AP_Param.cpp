@@ -25,6 +25,7 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
@@ -104,6 +105,10 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+struct AP_Param::NameIndex AP_Param::_name_index;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -912,11 +917,171 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  FNV-1a hash of a parameter name. Names are compared without regard
+  to case, so the hash is of the upper case name
+ */
+uint32_t AP_Param::name_index_hash(const char *name)
+{
+    uint32_t hash = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        hash ^= uint8_t(toupper(name[i]));
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/*
+  rebuild the name index if the parameter tree has changed since it
+  was last built. Returns false if the index can't be used, in which
+  case callers should fall back to walking the tree. Must be called
+  with _count_sem held
+ */
+bool AP_Param::name_index_update(void)
+{
+    if (!hal.scheduler->is_system_initialized()) {
+        // parameters are enabled and counts invalidated many times
+        // during startup, so don't keep rebuilding the index
+        return false;
+    }
+    if (_name_index.alloc_failed) {
+        return false;
+    }
+    if (_name_index.entries != nullptr &&
+        _name_index.marker == _count_marker) {
+        return true;
+    }
+
+    const uint16_t marker = _count_marker;
+    const uint16_t count = count_parameters();
+
+    if (count > _name_index.capacity) {
+        // leave some room for parameters being enabled later
+        const uint16_t capacity = MIN(uint32_t(count) + count/8U, 0xFFFEU);
+        uint32_t num_slots = 1;
+        while (num_slots < 2U*capacity) {
+            num_slots <<= 1;
+        }
+        delete[] _name_index.entries;
+        delete[] _name_index.slots;
+        _name_index.entries = nullptr;
+        _name_index.slots = nullptr;
+        if (num_slots <= 0x10000U) {
+            _name_index.entries = NEW_NOTHROW NameIndexEntry[capacity];
+            _name_index.slots = NEW_NOTHROW uint16_t[num_slots];
+        }
+        if (_name_index.entries == nullptr || _name_index.slots == nullptr) {
+            delete[] _name_index.entries;
+            delete[] _name_index.slots;
+            _name_index.entries = nullptr;
+            _name_index.slots = nullptr;
+            _name_index.capacity = 0;
+            _name_index.alloc_failed = true;
+            DEV_PRINTF("Param: no memory for name index\n");
+            return false;
+        }
+        _name_index.capacity = capacity;
+        _name_index.slot_mask = num_slots - 1;
+        DEV_PRINTF("Param: name index of %u params using %u bytes\n",
+                   unsigned(count), unsigned(name_index_memory()));
+    }
+
+    const uint16_t mask = _name_index.slot_mask;
+    memset(_name_index.slots, 0xFF, (uint32_t(mask)+1U)*sizeof(uint16_t));
+
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t n = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && n < _name_index.capacity;
+         ap = next_scalar(&token, &type)) {
+        NameIndexEntry &e = _name_index.entries[n];
+        e.ap = ap;
+        e.token = token;
+        e.type = type;
+        if (type <= AP_PARAM_FLOAT) {
+            // linear probing keeps the first of any duplicate names
+            // ahead of later ones, matching a walk of the tree
+            char name[AP_MAX_NAME_SIZE+1];
+            ap->copy_name_token(token, name, sizeof(name), true);
+            uint16_t slot = name_index_hash(name) & mask;
+            while (_name_index.slots[slot] != 0xFFFF) {
+                slot = (slot + 1) & mask;
+            }
+            _name_index.slots[slot] = n;
+        }
+        n++;
+    }
+    _name_index.count = n;
+    _name_index.marker = marker;
+    return true;
+}
+
+/*
+  find a scalar parameter in the name index, returning nullptr if
+  not found or the index is not available
+ */
+const AP_Param::NameIndexEntry *AP_Param::name_index_find(const char *name)
+{
+    if (!name_index_update()) {
+        return nullptr;
+    }
+    const uint16_t mask = _name_index.slot_mask;
+    uint16_t slot = name_index_hash(name) & mask;
+    while (_name_index.slots[slot] != 0xFFFF) {
+        const NameIndexEntry &e = _name_index.entries[_name_index.slots[slot]];
+        char buf[AP_MAX_NAME_SIZE+1];
+        e.ap->copy_name_token(e.token, buf, sizeof(buf), true);
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            return &e;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+/*
+  return memory used by the name index
+ */
+uint32_t AP_Param::name_index_memory(void)
+{
+    WITH_SEMAPHORE(_count_sem);
+    if (_name_index.entries == nullptr) {
+        return 0;
+    }
+    return _name_index.capacity * sizeof(NameIndexEntry) +
+        (uint32_t(_name_index.slot_mask)+1U) * sizeof(uint16_t);
+}
+#endif // AP_PARAM_NAME_INDEX_ENABLED
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_count_sem);
+        const NameIndexEntry *e = name_index_find(name);
+        if (e != nullptr) {
+            *ptype = (enum ap_var_type)e->type;
+            if (flags != nullptr && var_info(e->token.key).type == AP_PARAM_GROUP) {
+                uint32_t group_element = 0;
+                const struct GroupInfo *ginfo;
+                struct GroupNesting group_nesting {};
+                uint8_t idx;
+                e->ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
+                if (ginfo != nullptr) {
+                    *flags = ginfo->flags;
+                }
+            }
+            return e->ap;
+        }
+    }
+    // not a scalar in the index (for example a whole Vector3f or a
+    // disabled parameter), so walk the tree
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         uint8_t type = info.type;
@@ -958,11 +1123,26 @@ AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Note that this is quite slow without the
+// name index.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_count_sem);
+        if (name_index_update() && _name_index.count == count_parameters()) {
+            if (idx >= _name_index.count) {
+                return nullptr;
+            }
+            const NameIndexEntry &e = _name_index.entries[idx];
+            *token = e.token;
+            *ptype = (enum ap_var_type)e.type;
+            return e.ap;
+        }
+    }
+#endif
     AP_Param *ap;
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
@@ -976,6 +1156,17 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 // by-name equivalent of find_by_index()
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_count_sem);
+        const NameIndexEntry *e = name_index_find(name);
+        if (e != nullptr) {
+            *token = e->token;
+            *ptype = (enum ap_var_type)e->type;
+            return e->ap;
+        }
+    }
+#endif
     AP_Param *ap;
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
@@ -575,6 +575,11 @@ public:
     // invalidate parameter count
     static void invalidate_count(void);
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    // memory used by the parameter name index, in bytes
+    static uint32_t name_index_memory(void);
+#endif
+
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
     // set frame type flags. Used to unhide frame specific parameters
@@ -813,6 +818,32 @@ private:
     static uint16_t             _count_marker;
     static uint16_t             _count_marker_done;
     static HAL_Semaphore        _count_sem;
+
+#if AP_PARAM_NAME_INDEX_ENABLED
+    /*
+      index of the scalar parameters in find_by_index() order, with an
+      open addressed hash table of entry numbers keyed on the
+      parameter name. Rebuilt on demand when the parameter count is
+      invalidated, and protected by _count_sem
+     */
+    struct NameIndexEntry {
+        AP_Param *ap;
+        ParamToken token;
+        uint8_t type;
+    };
+    static struct NameIndex {
+        NameIndexEntry *entries;
+        uint16_t *slots;
+        uint16_t count;
+        uint16_t capacity;
+        uint16_t slot_mask;
+        uint16_t marker;
+        bool alloc_failed;
+    } _name_index;
+    static uint32_t name_index_hash(const char *name);
+    static bool name_index_update(void);
+    static const NameIndexEntry *name_index_find(const char *name);
+#endif
     static const struct Info *  _var_info;
 
 #if AP_PARAM_DYNAMIC_ENABLED
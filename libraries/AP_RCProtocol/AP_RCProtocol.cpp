@@ -242,6 +242,157 @@ void AP_RCProtocol::process_pulse_list(const uint32_t *widths, uint16_t n, bool
     }
 }
 
+// bytes a decoder stays awake for after a byte that could begin one
+// of its frames, longer than the longest frame
+#ifndef AP_RCPROTOCOL_DETECT_WAKE_BYTES
+#define AP_RCPROTOCOL_DETECT_WAKE_BYTES 128
+#endif
+
+// time to wait on a serial config that has seen nothing that could
+// begin a frame before moving on to the next. This leaves time for
+// listen-only SRXL2 receivers, which we handshake with after 250ms
+#ifndef AP_RCPROTOCOL_SEARCH_QUIET_MS
+#define AP_RCPROTOCOL_SEARCH_QUIET_MS 500
+#endif
+
+// first bytes a serial config needs to see in that time to be given
+// the full second. A receiver at the right config sends one every
+// frame, a receiver at another baud rate only makes the odd one
+#ifndef AP_RCPROTOCOL_SEARCH_QUIET_STARTS
+#define AP_RCPROTOCOL_SEARCH_QUIET_STARTS 4
+#endif
+
+/*
+  the baud rates each byte protocol decodes at and the bytes that can
+  begin one of its frames. While searching, a decoder is only fed bytes
+  after one of its first bytes has been seen, unless it has none
+ */
+static const struct ByteSignature {
+    AP_RCProtocol::rcprotocol_t protocol;
+    uint32_t bauds[3];
+    uint8_t start_bytes[4];
+    uint8_t num_start_bytes;
+} byte_signatures[] {
+#if AP_RCPROTOCOL_IBUS_ENABLED
+    { AP_RCProtocol::IBUS,     { 115200 },                   { 0x20 }, 1 },
+#endif
+#if AP_RCPROTOCOL_SBUS_ENABLED
+    { AP_RCProtocol::SBUS,     { 100000 },                   { 0x0F }, 1 },
+#endif
+#if AP_RCPROTOCOL_SBUS_NI_ENABLED
+    { AP_RCProtocol::SBUS_NI,  { 100000 },                   { 0x0F }, 1 },
+#endif
+#if AP_RCPROTOCOL_FASTSBUS_ENABLED
+    { AP_RCProtocol::FASTSBUS, { 200000 },                   { 0x0F }, 1 },
+#endif
+#if AP_RCPROTOCOL_DSM_ENABLED
+    // frames start with the fade count, which can be anything
+    { AP_RCProtocol::DSM,      { 115200 },                   { },      0 },
+#endif
+#if AP_RCPROTOCOL_SUMD_ENABLED
+    { AP_RCProtocol::SUMD,     { 115200 },                   { 0xA8 }, 1 },
+#endif
+#if AP_RCPROTOCOL_SRXL_ENABLED
+    { AP_RCProtocol::SRXL,     { 115200 },                   { SRXL_HEADER_V1, SRXL_HEADER_V2, SRXL_HEADER_V5 }, 3 },
+#endif
+#if AP_RCPROTOCOL_SRXL2_ENABLED
+    // SPEKTRUM_SRXL_ID
+    { AP_RCProtocol::SRXL2,    { 115200 },                   { 0xA6 }, 1 },
+#endif
+#if AP_RCPROTOCOL_CRSF_ENABLED
+    // flight controller address
+    { AP_RCProtocol::CRSF,     { CRSF_BAUDRATE, 1000000, 2000000 }, { 0xC8 }, 1 },
+#endif
+#if AP_RCPROTOCOL_ST24_ENABLED
+    { AP_RCProtocol::ST24,     { 115200 },                   { ST24_STX1 }, 1 },
+#endif
+#if AP_RCPROTOCOL_FPORT_ENABLED
+    { AP_RCProtocol::FPORT,    { 115200 },                   { 0x7E }, 1 },
+#endif
+#if AP_RCPROTOCOL_FPORT2_ENABLED
+    // frame lengths
+    { AP_RCProtocol::FPORT2,   { 115200 },                   { 0x0D, 0x18, 0x23, 0x08 }, 4 },
+#endif
+#if AP_RCPROTOCOL_GHST_ENABLED
+    // flight controller address
+    { AP_RCProtocol::GHST,     { CRSF_BAUDRATE, GHST_BAUDRATE }, { 0x82 }, 1 },
+#endif
+};
+
+// work out which protocols decode at a baud rate and their first bytes
+void AP_RCProtocol::set_detect_baudrate(uint32_t baudrate)
+{
+    detect.baudrate = baudrate;
+    detect.candidates = 0;
+    detect.always = 0;
+    memset(detect.start_bytes, 0, sizeof(detect.start_bytes));
+    for (const auto &sig : byte_signatures) {
+        if (backend[sig.protocol] == nullptr) {
+            continue;
+        }
+        bool decodes = false;
+        for (const auto b : sig.bauds) {
+            decodes |= b == baudrate;
+        }
+        if (!decodes) {
+            continue;
+        }
+        detect.candidates |= 1U << sig.protocol;
+        if (sig.num_start_bytes == 0) {
+            detect.always |= 1U << sig.protocol;
+        }
+        for (uint8_t i=0; i<sig.num_start_bytes; i++) {
+            const uint8_t b = sig.start_bytes[i];
+            detect.start_bytes[b>>3] |= 1U << (b&7);
+        }
+    }
+}
+
+uint32_t AP_RCProtocol::detect_byte(uint8_t byte, uint32_t baudrate)
+{
+    if (baudrate != detect.baudrate) {
+        set_detect_baudrate(baudrate);
+    }
+    detect.byte_count++;
+
+    // wake the decoders this byte could begin a frame for
+    bool woken = false;
+    if (detect.start_bytes[byte>>3] & (1U << (byte&7))) {
+        for (const auto &sig : byte_signatures) {
+            const uint32_t bit = 1U << sig.protocol;
+            if ((detect.candidates & bit) == 0 || !protocol_enabled(sig.protocol)) {
+                continue;
+            }
+            for (uint8_t i=0; i<sig.num_start_bytes; i++) {
+                if (sig.start_bytes[i] == byte) {
+                    detect.awake |= bit;
+                    detect.awake_until[sig.protocol] = detect.byte_count + AP_RCPROTOCOL_DETECT_WAKE_BYTES;
+                    woken = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // protocols with no first byte don't count, as every byte
+    // could begin one of their frames
+    if (woken && detect.start_count < UINT8_MAX) {
+        detect.start_count++;
+    }
+
+    // and put to sleep the decoders that have gone too long without one
+    for (uint32_t m = detect.awake; m != 0; m &= m-1) {
+        const uint8_t i = __builtin_ctz(m);
+        if (int16_t(detect.awake_until[i] - detect.byte_count) <= 0) {
+            detect.awake &= ~(1U << i);
+        }
+    }
+
+    // decoders woken at another baud rate stay awake, in case bytes
+    // arrive from more than one source
+    return detect.always | (detect.awake & detect.candidates);
+}
+
 bool AP_RCProtocol::process_byte(uint8_t byte, uint32_t baudrate)
 {
     uint32_t now = AP_HAL::millis();
@@ -271,8 +422,10 @@ bool AP_RCProtocol::process_byte(uint8_t byte, uint32_t baudrate)
         return true;
     }
 
-    // otherwise scan all protocols
-    for (uint8_t i = 0; i < ARRAY_SIZE(backend); i++) {
+    // otherwise scan the protocols that could be sending this byte
+    const uint32_t wake_mask = detect_byte(byte, baudrate);
+    for (uint32_t m = wake_mask; m != 0; m &= m-1) {
+        const uint8_t i = __builtin_ctz(m);
         if (backend[i] != nullptr) {
             if (!protocol_enabled(rcprotocol_t(i))) {
                 continue;
@@ -371,6 +524,7 @@ void AP_RCProtocol::check_added_uart(void)
         added.opened = true;
         added.last_config_change_ms = AP_HAL::millis();
         serial_configs[added.config_num].apply_to_uart(added.uart);
+        detect.start_count = 0;
     }
 #if AP_RC_CHANNEL_ENABLED
     rc_protocols_mask = rc().enabled_protocols();
@@ -387,8 +541,12 @@ void AP_RCProtocol::check_added_uart(void)
         }
     }
     if (searching) {
-        if (now - added.last_config_change_ms > 1000) {
-            // change configs if not detected once a second
+        const uint32_t config_ms = now - added.last_config_change_ms;
+        const bool quiet = detect.start_count < AP_RCPROTOCOL_SEARCH_QUIET_STARTS || detect.baudrate != current_baud;
+        if (config_ms > 1000 || (quiet && config_ms > AP_RCPROTOCOL_SEARCH_QUIET_MS)) {
+            // change configs if not detected once a second, or
+            // sooner if next to nothing has been seen that could begin a
+            // frame of a protocol using this config
             added.config_num++;
             if (added.config_num >= ARRAY_SIZE(serial_configs)) {
                 added.config_num = 0;
@@ -280,6 +280,11 @@ private:
     // having them make an "add_input" callback):
     bool detect_async_protocol(rcprotocol_t protocol);
 
+    // feed a byte to the detection front end, returning the
+    // protocols that should decode it while searching
+    uint32_t detect_byte(uint8_t byte, uint32_t baudrate);
+    void set_detect_baudrate(uint32_t baudrate);
+
     enum rcprotocol_t _detected_protocol = NONE;
     uint16_t _disabled_for_pulses;
     bool _detected_with_bytes;
@@ -297,6 +302,18 @@ private:
         uint8_t config_num;
     } added;
 
+    // detection front end for byte input
+    struct {
+        uint32_t baudrate;          // baud rate the fields below are for
+        uint32_t candidates;        // protocols decoding at baudrate
+        uint32_t always;            // candidates with no fixed first byte
+        uint32_t awake;             // candidates that have seen a first byte
+        uint8_t start_bytes[32];    // bitmap of the first bytes of the candidates
+        uint16_t byte_count;
+        uint16_t awake_until[NONE]; // byte_count each awake protocol sleeps at
+        uint8_t start_count;        // first bytes seen since the serial config changed
+    } detect;
+
     // allowed RC protocols mask (first bit means "all")
     uint32_t rc_protocols_mask;
 
@@ -0,0 +1,182 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_RCProtocol/AP_RCProtocol_config.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// frame gaps come from the simulated clock
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && AP_RCPROTOCOL_ENABLED
+
+#include <AP_RCProtocol/AP_RCProtocol.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+#include <RC_Channel/RC_Channel.h>
+#include <AP_VideoTX/AP_VideoTX.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+class RC_Channel_Benchmark : public RC_Channel {};
+
+class RC_Channels_Benchmark : public RC_Channels
+{
+public:
+    RC_Channel_Benchmark obj_channels[NUM_RC_CHANNELS];
+
+    RC_Channel_Benchmark *channel(const uint8_t chan) override {
+        if (chan >= NUM_RC_CHANNELS) {
+            return nullptr;
+        }
+        return &obj_channels[chan];
+    }
+
+protected:
+    int8_t flight_mode_channel_number() const override { return 5; }
+};
+
+#define RC_CHANNELS_SUBCLASS RC_Channels_Benchmark
+#define RC_CHANNEL_SUBCLASS RC_Channel_Benchmark
+
+#include <RC_Channel/RC_Channels_VarInfo.h>
+
+static RC_Channels_Benchmark rchannels;
+static AP_SerialManager serial_manager;
+static AP_VideoTX vtx;
+GCS_Dummy _gcs;
+
+// frame period of the recorded streams
+#define FRAME_INTERVAL_MS 10
+
+// give up if a protocol hasn't locked after this many frames
+#define MAX_FRAMES 50
+
+/*
+  frames recorded from receivers, as used by the RCProtocolTest example
+ */
+static const uint8_t sbus_bytes[] = {
+    0x0F, 0x4C, 0x1C, 0x5F, 0x32, 0x34, 0x38, 0xDD, 0x89,
+    0x83, 0x0F, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+static const uint8_t ibus_bytes[] = {
+    0x20, 0x40, 0xdc, 0x05, 0xdc, 0x05, 0xe8, 0x03, 0xdc, 0x05, 0xdc, 0x05,
+    0xdc, 0x05, 0xdc, 0x05, 0xdc, 0x05, 0xdc, 0x05, 0xdc, 0x05, 0xdc, 0x05,
+    0xdc, 0x05, 0xdc, 0x05, 0xdc, 0x05, 0x47, 0xf3 };
+static const uint8_t sumd_bytes[] = {
+    0xA8, 0x01, 0x08, 0x2F, 0x50, 0x31, 0xE8, 0x21, 0xA0,
+    0x2F, 0x50, 0x22, 0x60, 0x22, 0x60, 0x2E, 0xE0, 0x2E,
+    0xE0, 0x87, 0xC6 };
+static const uint8_t srxl_bytes[] = {
+    0xa5, 0x03, 0x0c, 0x04, 0x2f, 0x6c, 0x10, 0xb4, 0x26,
+    0x16, 0x34, 0x01, 0x04, 0x76, 0x1c, 0x40, 0xf5, 0x3b };
+static const uint8_t crsf_bytes[] = {
+    0xC8, 0x14, 0x17, 0x20, 0x03, 0x0C, 0xA0, 0x00, 0xF6, 0xB7, 0x6E, 0x94, 0xFC,
+    0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE, 0x0F, 0x6E };
+static const uint8_t fport_bytes[] = {
+    0x7e, 0x19, 0x00, 0xe7, 0x3b, 0xdf, 0x5a, 0xce,
+    0x07, 0x10, 0x75, 0x49, 0x9c, 0x15, 0xe0, 0x03,
+    0x1f, 0xf8, 0xc0, 0x07, 0x3e, 0xf0, 0x81, 0x0f,
+    0x7c, 0x00, 0x38, 0xfa, 0x7e };
+static const uint8_t fport2_bytes[] = {
+    0x18, 0xff,
+    0xac, 0x00, 0x5f, 0xf8, 0xc0, 0x07, 0x3e, 0xf0, 0x81, 0x0f, 0x7c,
+    0xe0, 0x03, 0x1f, 0xf8, 0xc0, 0x07, 0x3e, 0xf0, 0x81, 0x0f, 0x7c,
+    0x00, 0x5e, 0x98 };
+// DSMX 22ms, two frames
+static const uint8_t dsm_bytes[] = {
+    0x00, 0xB2, 0x0C, 0x00, 0x29, 0x56, 0x14, 0x00,
+    0x25, 0xF8, 0x34, 0x00, 0x54, 0x00, 0xFF, 0xFF,
+    0x00, 0xB2, 0x81, 0x50, 0x3C, 0x00, 0x1B, 0xFD,
+    0x44, 0x00, 0x4C, 0x00, 0x5C, 0x00, 0xFF, 0xFF };
+
+static const struct {
+    const char *name;
+    uint32_t baudrate;
+    const uint8_t *bytes;
+    uint8_t nbytes;
+    // bytes per frame, a frame gap follows each
+    uint8_t frame_len;
+} streams[] {
+    { "SBUS",   100000, sbus_bytes,   sizeof(sbus_bytes),   sizeof(sbus_bytes) },
+    { "IBUS",   115200, ibus_bytes,   sizeof(ibus_bytes),   sizeof(ibus_bytes) },
+    { "SUMD",   115200, sumd_bytes,   sizeof(sumd_bytes),   sizeof(sumd_bytes) },
+    { "SRXL",   115200, srxl_bytes,   sizeof(srxl_bytes),   sizeof(srxl_bytes) },
+    { "CRSF",   416666, crsf_bytes,   sizeof(crsf_bytes),   sizeof(crsf_bytes) },
+    { "FPORT",  115200, fport_bytes,  sizeof(fport_bytes),  sizeof(fport_bytes) },
+    { "FPORT2", 115200, fport2_bytes, sizeof(fport2_bytes), sizeof(fport2_bytes) },
+    { "DSM",    115200, dsm_bytes,    sizeof(dsm_bytes),    16 },
+};
+
+static void advance_clock_ms(uint32_t ms)
+{
+    hal.scheduler->stop_clock(AP_HAL::micros64() + ms*1000);
+}
+
+/*
+  replay a recorded stream into a freshly started decoder until it
+  locks on. The time is the CPU needed to get there, the label shows
+  the frames and simulated time the lock took
+ */
+static void BM_RCProtocolLock(benchmark::State& state)
+{
+    const auto &s = streams[state.range(0)];
+    uint32_t frames = 0;
+    uint32_t nbytes = 0;
+    bool locked = false;
+    while (state.KeepRunning()) {
+        AP_RCProtocol *rcprot = new AP_RCProtocol();
+        rcprot->init();
+        advance_clock_ms(FRAME_INTERVAL_MS);
+        frames = 0;
+        locked = false;
+        uint8_t ofs = 0;
+        while (!locked && frames < MAX_FRAMES) {
+            for (uint8_t i=0; i<s.frame_len; i++) {
+                locked |= rcprot->process_byte(s.bytes[ofs++], s.baudrate);
+            }
+            nbytes += s.frame_len;
+            ofs %= s.nbytes;
+            frames++;
+            advance_clock_ms(FRAME_INTERVAL_MS);
+        }
+        delete rcprot;
+    }
+    char label[40];
+    if (locked) {
+        snprintf(label, sizeof(label), "%s: %u frames %ums", s.name, unsigned(frames), unsigned(frames*FRAME_INTERVAL_MS));
+    } else {
+        snprintf(label, sizeof(label), "%s: no lock", s.name);
+    }
+    state.SetLabel(label);
+    state.SetItemsProcessed(nbytes);
+}
+
+BENCHMARK(BM_RCProtocolLock)->DenseRange(0, ARRAY_SIZE(streams)-1);
+
+/*
+  cost per byte of searching a stream that isn't RC input, such as a
+  receiver sending at another baud rate
+ */
+static void BM_RCProtocolSearch(benchmark::State& state)
+{
+    const uint32_t baudrate = state.range(0);
+    AP_RCProtocol *rcprot = new AP_RCProtocol();
+    rcprot->init();
+    uint8_t bytes[1024];
+    uint32_t seed = 1;
+    for (auto &b : bytes) {
+        seed = seed * 1664525U + 1013904223U;
+        b = seed >> 24;
+    }
+    while (state.KeepRunning()) {
+        for (const auto b : bytes) {
+            rcprot->process_byte(b, baudrate);
+        }
+        advance_clock_ms(FRAME_INTERVAL_MS);
+    }
+    delete rcprot;
+    state.SetItemsProcessed(state.iterations() * sizeof(bytes));
+}
+
+BENCHMARK(BM_RCProtocolSearch)->Arg(100000)->Arg(115200)->Arg(416666);
+
+#endif  // CONFIG_HAL_BOARD == HAL_BOARD_SITL && AP_RCPROTOCOL_ENABLED
+
+BENCHMARK_MAIN();
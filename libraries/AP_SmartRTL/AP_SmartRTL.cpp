@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 4k of memory.
+    // @Range: 0 1000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -62,7 +62,9 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    points when their line segments get close. This algorithm will never
 *    compare two consecutive line segments. Obviously the segments (p1,p2) and
 *    (p2,p3) will get very close (they touch), but there would be nothing to
-*    trim between them.
+*    trim between them.  Segments are indexed by the cells of a horizontal grid
+*    they pass through, so each new segment is only compared with the segments
+*    near it.
 *
 *    2. Simplification uses the Ramer-Douglas-Peucker algorithm. See Wikipedia
 *    for a more complete description.
@@ -115,15 +117,34 @@ void AP_SmartRTL::init()
     _simplify.stack_max = _points_max * SMARTRTL_SIMPLIFY_STACK_LEN_MULT;
     _simplify.stack = (simplify_start_finish_t*)calloc(_simplify.stack_max, sizeof(simplify_start_finish_t));
 
+    // one grid bucket for every two points, rounded up to a power of two
+    _grid.buckets_count = 16;
+    while (_grid.buckets_count < _points_max / 2) {
+        _grid.buckets_count *= 2;
+    }
+    _grid.buckets = (uint16_t*)calloc(_grid.buckets_count, sizeof(uint16_t));
+
+    _grid.entries_max = _points_max * SMARTRTL_GRID_ENTRIES_MULT;
+    _grid.entries = (grid_entry_t*)calloc(_grid.entries_max, sizeof(grid_entry_t));
+
+    _grid.long_segments_max = _points_max * SMARTRTL_GRID_LONG_BUFFER_LEN_MULT;
+    _grid.long_segments = (uint16_t*)calloc(_grid.long_segments_max, sizeof(uint16_t));
+
     // check if memory allocation failed
-    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr) {
+    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr ||
+        _grid.buckets == nullptr || _grid.entries == nullptr || _grid.long_segments == nullptr) {
         log_action(Action::DEACTIVATED_INIT_FAILED);
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "SmartRTL deactivated: init failed");
         free(_path);
         free(_prune.loops);
         free(_simplify.stack);
+        free(_grid.buckets);
+        free(_grid.entries);
+        free(_grid.long_segments);
+        _path = nullptr;
         return;
     }
+    grid_reset();
 
     _path_points_max = _points_max;
 
@@ -162,6 +183,7 @@ bool AP_SmartRTL::pop_point(Vector3f& point)
 
     // return last point and remove from path
     point = _path[--_path_points_count];
+    _path_version++;
 
     // record count of last point popped
     _path_points_completed_limit = _path_points_count;
@@ -213,6 +235,7 @@ void AP_SmartRTL::set_home(bool position_ok, const Vector3f& current_pos)
 
     // clear path
     _path_points_count = 0;
+    _path_version++;
 
     // reset simplification and pruning.  These functions access members that should normally only
     // be touched by the background thread but it will not be running because active should be false
@@ -507,6 +530,7 @@ void AP_SmartRTL::detect_simplifications()
         _simplify.stack[0].start = (_simplify.path_points_completed > 0) ? _simplify.path_points_completed - 1 : 0;
         _simplify.stack[0].finish = _simplify.path_points_count-1;
         _simplify.stack_count++;
+        _simplify.start_index = _simplify.stack[0].start;
     }
 
     const uint32_t start_time_us = AP_HAL::micros();
@@ -562,6 +586,7 @@ void AP_SmartRTL::detect_simplifications()
 *   This method runs for the allotted time, and detects loops in a path. Any detected loops are added to _prune.loops,
 *   this function does not alter the path in memory. It works by comparing the line segment between any two sequential points
 *   to the line segment between any other two sequential points. If they get close enough, anything between them could be pruned.
+*   Segments are first added to the grid index, which is then used to find the segments close to each new segment.
 *
 *   reset_pruning should have been called at least once before this function is called to setup the indexes (_prune.i, etc)
 */
@@ -573,39 +598,154 @@ void AP_SmartRTL::detect_loops()
         return;
     }
 
+    // clear the grid index if points have been removed or moved, or the accuracy has changed, since it was built
+    if (_grid.path_version != _path_version || !is_equal(_grid.cell_size, (float)SMARTRTL_GRID_CELL_SIZE)) {
+        grid_reset();
+    }
+
     // capture start time
     const uint32_t start_time_us = AP_HAL::micros();
 
     // run for defined amount of time
     while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
 
-        // advance inner loop
-        _prune.j++;
-        if (_prune.j > _prune.i - 2) {
-            // set inner loop back to first point
-            _prune.j = 1;
-            // reduce outer loop
-            _prune.i--;
-            // complete when outer loop has run out of new points to check
-            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+        // bring the grid index up to date before searching it
+        if (_grid.next_segment < _prune.path_points_count) {
+            grid_add_segment(_grid.next_segment++);
+            continue;
+        }
+
+        // complete when we have run out of new segments to check
+        if (_prune.i < 3 || _prune.i < _prune.path_points_completed) {
+            _prune.complete = true;
+            _prune.path_points_completed = _prune.path_points_count;
+            return;
+        }
+
+        // if there is a loop here, add to loop array
+        uint16_t start_index;
+        Vector3f midpoint;
+        if (find_loop(_prune.i, start_index, midpoint)) {
+            if (!add_loop(start_index, _prune.i-1, midpoint)) {
+                // if the buffer is full, stop trying to prune
                 _prune.complete = true;
-                _prune.path_points_completed = _prune.path_points_count;
                 return;
             }
         }
 
-        // find the closest distance between two line segments and the mid-point
-        dist_point dp = segment_segment_dist(_path[_prune.i], _path[_prune.i-1], _path[_prune.j-1], _path[_prune.j]);
+        // move to the previous segment
+        _prune.i--;
+    }
+}
+
+// find the earliest segment which comes within SMARTRTL_PRUNING_DELTA of the segment ending at point end_index
+//  returns true if found, with start_index set to the end point of that segment and midpoint to the point between them
+bool AP_SmartRTL::find_loop(uint16_t end_index, uint16_t& start_index, Vector3f& midpoint) const
+{
+    // consecutive segments always touch, so only segments ending before end_index-1 are checked
+    start_index = end_index - 1;
+    bool found = false;
+
+    int32_t min_x, min_y, max_x, max_y;
+    if (_grid.overflow || grid_cells(end_index, 0.0f, min_x, min_y, max_x, max_y) > SMARTRTL_GRID_CELLS_MAX) {
+        // check every earlier segment, the first loop found is the longest
+        for (uint16_t j = 1; j < start_index; j++) {
+            const dist_point dp = segment_segment_dist(_path[end_index], _path[end_index-1], _path[j-1], _path[j]);
+            if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                start_index = j;
+                midpoint = dp.midpoint;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // check segments in the cells near this one and all long segments, keeping the longest loop
+    auto check_segment = [&](uint16_t j) {
+        if (j >= start_index) {
+            return;
+        }
+        const dist_point dp = segment_segment_dist(_path[end_index], _path[end_index-1], _path[j-1], _path[j]);
         if (dp.distance < SMARTRTL_PRUNING_DELTA) {
-            // if there is a loop here, add to loop array
-            if (!add_loop(_prune.j, _prune.i-1, dp.midpoint)) {
-                // if the buffer is full, stop trying to prune
-                _prune.complete = true;
+            start_index = j;
+            midpoint = dp.midpoint;
+            found = true;
+        }
+    };
+    for (int32_t x = min_x; x <= max_x; x++) {
+        for (int32_t y = min_y; y <= max_y; y++) {
+            for (uint16_t e = _grid.buckets[grid_bucket(x, y)]; e != SMARTRTL_GRID_NONE; e = _grid.entries[e].next) {
+                check_segment(_grid.entries[e].segment);
+            }
+        }
+    }
+    for (uint16_t k = 0; k < _grid.long_segments_count; k++) {
+        check_segment(_grid.long_segments[k]);
+    }
+    return found;
+}
+
+// clear the grid index of path segments
+void AP_SmartRTL::grid_reset()
+{
+    for (uint16_t b = 0; b < _grid.buckets_count; b++) {
+        _grid.buckets[b] = SMARTRTL_GRID_NONE;
+    }
+    _grid.entries_count = 0;
+    _grid.long_segments_count = 0;
+    _grid.next_segment = 1;
+    _grid.path_version = _path_version;
+    _grid.cell_size = SMARTRTL_GRID_CELL_SIZE;
+    _grid.margin = SMARTRTL_PRUNING_DELTA;
+    _grid.overflow = false;
+}
+
+// add the segment ending at point index to the grid index
+void AP_SmartRTL::grid_add_segment(uint16_t index)
+{
+    int32_t min_x, min_y, max_x, max_y;
+    const uint32_t num_cells = grid_cells(index, _grid.margin, min_x, min_y, max_x, max_y);
+    if (num_cells <= SMARTRTL_GRID_CELLS_MAX && _grid.entries_count + num_cells <= _grid.entries_max) {
+        for (int32_t x = min_x; x <= max_x; x++) {
+            for (int32_t y = min_y; y <= max_y; y++) {
+                const uint16_t b = grid_bucket(x, y);
+                _grid.entries[_grid.entries_count] = grid_entry_t {index, _grid.buckets[b]};
+                _grid.buckets[b] = _grid.entries_count++;
             }
-            // set inner loop forward to trigger outer loop move to next segment
-            _prune.j = _prune.i;
         }
+        return;
+    }
+    if (_grid.long_segments_count < _grid.long_segments_max) {
+        _grid.long_segments[_grid.long_segments_count++] = index;
+        return;
+    }
+    // the index can not hold this segment, so loop detection falls back to checking every segment
+    _grid.overflow = true;
+}
+
+// get the range of grid cells covered by the segment ending at point index, expanded by margin (in meters)
+//  returns the number of cells covered
+uint32_t AP_SmartRTL::grid_cells(uint16_t index, float margin, int32_t& min_x, int32_t& min_y, int32_t& max_x, int32_t& max_y) const
+{
+    const Vector3f &p1 = _path[index-1];
+    const Vector3f &p2 = _path[index];
+    min_x = floorf((MIN(p1.x, p2.x) - margin) / _grid.cell_size);
+    min_y = floorf((MIN(p1.y, p2.y) - margin) / _grid.cell_size);
+    max_x = floorf((MAX(p1.x, p2.x) + margin) / _grid.cell_size);
+    max_y = floorf((MAX(p1.y, p2.y) + margin) / _grid.cell_size);
+    const uint32_t num_x = max_x - min_x + 1;
+    const uint32_t num_y = max_y - min_y + 1;
+    if (num_x > SMARTRTL_GRID_CELLS_MAX || num_y > SMARTRTL_GRID_CELLS_MAX) {
+        // avoid overflow for very long segments
+        return UINT32_MAX;
     }
+    return num_x * num_y;
+}
+
+// get the hash bucket holding a grid cell
+uint16_t AP_SmartRTL::grid_bucket(int32_t x, int32_t y) const
+{
+    return ((uint32_t(x) * 73856093U) ^ (uint32_t(y) * 19349663U)) & (_grid.buckets_count - 1);
 }
 
 // restart simplify if new points have been added to path
@@ -631,6 +771,7 @@ void AP_SmartRTL::restart_pruning_if_new_points()
 void AP_SmartRTL::restart_simplification(uint16_t path_points_count)
 {
     _simplify.complete = false;
+    _simplify.start_index = 0;
     _simplify.removal_required = false;
     _simplify.bitmask.setall();
     _simplify.stack_count = 0;
@@ -649,7 +790,6 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 {
     _prune.complete = false;
     _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
-    _prune.j = 0;
     _prune.path_points_count = path_points_count;
 }
 
@@ -668,9 +808,10 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     if (!_path_sem.take_nonblocking()) {
         return;
     }
-    uint16_t dest = 1;
+    // points before the start of the last simplify run are never removed, so skip over them
+    uint16_t dest = _simplify.start_index + 1;
     uint16_t removed = 0;
-    for (uint16_t src = 1; src < _path_points_count; src++) {
+    for (uint16_t src = dest; src < _path_points_count; src++) {
         if (!_simplify.bitmask.get(src)) {
             log_action(Action::POINT_SIMPLIFY, _path[src]);
             removed++;
@@ -679,6 +820,9 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
             dest++;
         }
     }
+    if (removed > 0) {
+        _path_version++;
+    }
 
     // reduce count of the number of points simplified
     if (_path_points_count > removed && _simplify.path_points_count > removed) {
@@ -752,6 +896,7 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
 
         // remove last prune loop from array
         _prune.loops_count--;
+        _path_version++;
     }
 
     _path_sem.give();
@@ -7,8 +7,8 @@
 
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
-#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 40bytes * this number.
+#define SMARTRTL_POINTS_MAX              1000   // the absolute maximum number of points this library can support.
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -21,6 +21,11 @@
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_GRID_CELL_SIZE MAX(_accuracy * 8.0f, 1.0f)  // size (in meters) of the grid cells used to index path segments for loop detection
+#define SMARTRTL_GRID_CELLS_MAX          4      // segments covering more grid cells than this are checked against every segment
+#define SMARTRTL_GRID_ENTRIES_MULT       2      // grid index entries as compared to maximum number of points
+#define SMARTRTL_GRID_LONG_BUFFER_LEN_MULT 0.25f // grid index long segment buffer size as compared to maximum number of points
+#define SMARTRTL_GRID_NONE               UINT16_MAX // marks the end of a grid index bucket
 
 class AP_SmartRTL {
 
@@ -170,6 +175,23 @@ private:
     // get the closest distance between 2 line segments and the point midway between the closest points
     static dist_point segment_segment_dist(const Vector3f& p1, const Vector3f& p2, const Vector3f& p3, const Vector3f& p4);
 
+    // find the earliest segment which comes within SMARTRTL_PRUNING_DELTA of the segment ending at point end_index
+    //  returns true if found, with start_index set to the end point of that segment and midpoint to the point between them
+    bool find_loop(uint16_t end_index, uint16_t& start_index, Vector3f& midpoint) const;
+
+    // clear the grid index of path segments
+    void grid_reset();
+
+    // add the segment ending at point index to the grid index
+    void grid_add_segment(uint16_t index);
+
+    // get the range of grid cells covered by the segment ending at point index, expanded by margin (in meters)
+    //  returns the number of cells covered
+    uint32_t grid_cells(uint16_t index, float margin, int32_t& min_x, int32_t& min_y, int32_t& max_x, int32_t& max_y) const;
+
+    // get the hash bucket holding a grid cell
+    uint16_t grid_bucket(int32_t x, int32_t y) const;
+
     // de-activate SmartRTL, send warning to GCS and logger
     void deactivate(Action action, const char *reason);
 
@@ -201,6 +223,7 @@ private:
     uint16_t _path_points_max;  // after the array has been allocated, we will need to know how big it is. We can't use the parameter, because a user could change the parameter in-flight
     uint16_t _path_points_count;// number of points in the path array
     uint16_t _path_points_completed_limit;  // set by main thread to the path_point_count when a point is popped.  used by simplify and prune algorithms to detect path shrinking
+    uint16_t _path_version;     // incremented whenever points are removed from or moved within the path.  used to detect when the grid index is out of date
     HAL_Semaphore _path_sem;   // semaphore for updating path
 
     // Simplify
@@ -214,6 +237,7 @@ private:
         bool removal_required;  // true if some simplify-able points have been found on the path, set true by detect_simplifications, set false by remove_points_by_simplify_bitmask
         uint16_t path_points_count; // copy of _path_points_count taken when the simply algorithm started
         uint16_t path_points_completed = SMARTRTL_POINTS_MAX; // number of points in that path that have already been simplified and should be ignored
+        uint16_t start_index;   // index of the first point checked by this run of the simplify algorithm, no points before it will be removed
         simplify_start_finish_t* stack;
         uint16_t stack_max;     // maximum number of elements in the _simplify_stack array
         uint16_t stack_count;   // number of elements in _simplify_stack array
@@ -231,13 +255,36 @@ private:
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
         uint16_t path_points_completed; // number of points in that path that have already been checked for loops and should be ignored
-        uint16_t i;     // loop search's outer loop index
-        uint16_t j;     // loop search's inner loop index
+        uint16_t i;     // end index of the segment being checked for loops
         prune_loop_t* loops;// the result of the pruning algorithm
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
     } _prune;
 
+    // Grid index
+    // path segments are indexed by the cells of a uniform horizontal grid that they pass near, so that loop
+    // detection only compares each new segment with segments nearby. Cells are hashed into a fixed number of buckets,
+    // each holding a linked list of entries. Segments too long to index are kept in a separate list
+    typedef struct {
+        uint16_t segment;   // end index of the segment
+        uint16_t next;      // next entry in the same bucket, or SMARTRTL_GRID_NONE
+    } grid_entry_t;
+    struct {
+        uint16_t* buckets;      // first entry in each bucket, or SMARTRTL_GRID_NONE
+        uint16_t buckets_count; // number of buckets, a power of two
+        grid_entry_t* entries;
+        uint16_t entries_max;   // maximum number of elements in the entries array
+        uint16_t entries_count; // number of elements in the entries array
+        uint16_t* long_segments;    // end index of segments covering too many cells to index
+        uint16_t long_segments_max;
+        uint16_t long_segments_count;
+        uint16_t next_segment;  // end index of the next segment to be added
+        uint16_t path_version;  // copy of _path_version taken when the index was cleared
+        float cell_size;        // cell size (in meters) when the index was cleared
+        float margin;           // distance (in meters) that indexed segments are expanded by
+        bool overflow;          // true if a segment could not be indexed, in which case every segment must be checked
+    } _grid;
+
     // returns true if the two loops overlap (used within add_loop to determine which loops to keep or throw away)
     bool loops_overlap(const prune_loop_t& loop1, const prune_loop_t& loop2) const;
 };
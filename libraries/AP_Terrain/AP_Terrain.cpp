@@ -30,6 +30,14 @@
 
 extern const AP_HAL::HAL& hal;
 
+// minimum ground speed in m/s for prefetching grids ahead of the vehicle
+#ifndef TERRAIN_PREFETCH_MIN_SPEED
+#define TERRAIN_PREFETCH_MIN_SPEED 5.0f
+#endif
+
+// number of grids to prefetch ahead of the vehicle
+#define TERRAIN_PREFETCH_BLOCKS 2
+
 AP_Terrain *AP_Terrain::singleton;
 
 #if APM_BUILD_TYPE(APM_BUILD_ArduSub)
@@ -58,7 +66,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Terrain options
     // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download
+    // @Bitmask: 0:Disable Download,1:Disable memory mapped terrain files
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -134,30 +142,32 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 
     calculate_grid_info(loc, info);
 
-    // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
-
-    /*
-      note that we rely on the one square overlap to ensure these
-      calculations don't go past the end of the arrays
-     */
-    ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
-    ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
+    // hXY are the heights of the 4 surrounding grid points
+    int16_t h[2][2];
+    bool have_heights = false;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    if (!(options.get() & uint16_t(Options::DisableMMap))) {
+        // blocks the IO thread has already mapped and validated are
+        // read from the mapped file
+        WITH_SEMAPHORE(mmap_sem);
+        const struct grid_block *mgrid = mmap_find_block(info);
+        have_heights = mgrid != nullptr && get_heights(*mgrid, info, h);
+    }
+#endif
 
-    // check we have all 4 required heights
-    if (!check_bitmap(grid, info.idx_x,   info.idx_y) ||
-        !check_bitmap(grid, info.idx_x,   info.idx_y+1) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y+1)) {
-        return false;
+    if (!have_heights) {
+        // find the grid
+        const struct grid_block &grid = find_grid_cache(info).grid;
+        if (!get_heights(grid, info, h)) {
+            return false;
+        }
     }
 
-    // hXY are the heights of the 4 surrounding grid points
-    const auto h00 = grid.height[info.idx_x+0][info.idx_y+0];
-    const auto h01 = grid.height[info.idx_x+0][info.idx_y+1];
-    const auto h10 = grid.height[info.idx_x+1][info.idx_y+0];
-    const auto h11 = grid.height[info.idx_x+1][info.idx_y+1];
+    const auto h00 = h[0][0];
+    const auto h01 = h[0][1];
+    const auto h10 = h[1][0];
+    const auto h11 = h[1][1];
 
     // do a simple dual linear interpolation. We could do something
     // fancier, but it probably isn't worth it as long as the
@@ -390,10 +400,14 @@ void AP_Terrain::update(void)
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
+        update_velocity_prefetch(loc);
     } else {
         have_surrounding_tiles = false;
     }
 
+    // load grids for the mission legs we are about to fly
+    update_mission_prefetch();
+
     // update capabilities and status
     if (allocate()) {
         if (!pos_valid) {
@@ -428,6 +442,52 @@ bool AP_Terrain::update_surrounding_tiles(const Location &loc)
     return ret;
 }
 
+/*
+  prefetch grids ahead of the vehicle, beyond the surrounding tiles,
+  so that fast moving vehicles find the data in memory when they get
+  there
+ */
+void AP_Terrain::update_velocity_prefetch(const Location &loc)
+{
+    if (cache_size < TERRAIN_PREFETCH_MIN_CACHE_SIZE) {
+        // not enough room to hold the grids without evicting the surrounding tiles
+        return;
+    }
+
+    const Vector2f &groundspeed = AP::ahrs().groundspeed_vector();
+    const float speed = groundspeed.length();
+    if (speed < TERRAIN_PREFETCH_MIN_SPEED) {
+        return;
+    }
+
+    const Vector2f direction = groundspeed / speed;
+    for (uint8_t i=1; i<=TERRAIN_PREFETCH_BLOCKS; i++) {
+        Location loc2 = loc;
+        loc2.offset(direction.x*(i+1)*TERRAIN_GRID_BLOCK_SIZE_X*0.7f*grid_spacing,
+                    direction.y*(i+1)*TERRAIN_GRID_BLOCK_SIZE_Y*0.7f*grid_spacing);
+        prefetch_grid(loc2);
+    }
+}
+
+/*
+  start loading the grid holding a location into the cache, without
+  waiting for the data. Any data missing from disk is then requested
+  from the GCS along with the rest of the cache
+ */
+void AP_Terrain::prefetch_grid(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+#if AP_TERRAIN_MMAP_ENABLED
+    if (!(options.get() & uint16_t(Options::DisableMMap))) {
+        // have the IO thread get the mapped block ready too
+        WITH_SEMAPHORE(mmap_sem);
+        mmap_find_block(info);
+    }
+#endif
+    find_grid_cache(info);
+}
+
 bool AP_Terrain::pre_arm_checks(char *failure_msg, uint8_t failure_msg_len) const
 {
     // check no outstanding requests for data:
@@ -23,6 +23,9 @@
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Logger/AP_Logger_config.h>
+#if AP_TERRAIN_MMAP_ENABLED
+#include <AP_HAL/Semaphores.h>
+#endif
 
 #define TERRAIN_DEBUG 0
 
@@ -47,8 +50,39 @@
 
 // number of grid_blocks in the LRU memory cache
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 32
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
+#endif
+
+// number of grid_blocks read from disk in each pass of the IO timer
+#ifndef TERRAIN_DISK_IO_BATCH
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define TERRAIN_DISK_IO_BATCH 4
+#else
+#define TERRAIN_DISK_IO_BATCH 1
+#endif
+#endif
+
+// grid_blocks ahead of the vehicle and on the next mission legs are
+// only prefetched if the cache has room for them as well as the
+// blocks surrounding the vehicle
+#ifndef TERRAIN_PREFETCH_MIN_CACHE_SIZE
+#define TERRAIN_PREFETCH_MIN_CACHE_SIZE 20
+#endif
+
+// number of degree files that can be memory mapped at once
+#ifndef TERRAIN_MMAP_MAX_FILES
+#define TERRAIN_MMAP_MAX_FILES 4
+#endif
+
+// number of recently looked up blocks the IO thread keeps ready in
+// the mapped files
+#ifndef TERRAIN_MMAP_WANT_BLOCKS
+#define TERRAIN_MMAP_WANT_BLOCKS 16
+#endif
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -265,8 +299,8 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+        // the access sequence number of the last access to this block, used for LRU
+        uint32_t last_access;
     };
 
     /*
@@ -318,6 +352,12 @@ private:
     */
     bool check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint8_t idx_y);
 
+    /*
+      get the 4 heights surrounding a grid_info, returning false if
+      they are not all available
+    */
+    bool get_heights(const struct grid_block &grid, const struct grid_info &info, int16_t heights[2][2]);
+
 #if HAL_GCS_ENABLED
     /*
       request any missing 4x4 grids from a block
@@ -326,6 +366,12 @@ private:
     bool request_missing(mavlink_channel_t chan, const struct grid_info &info);
 #endif
 
+    /*
+      start loading the grid holding a location into the cache, without
+      waiting for the data
+    */
+    void prefetch_grid(const Location &loc);
+
     /*
       look for blocks that need to be read/written to disk
      */
@@ -339,20 +385,28 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
+    int16_t find_io_idx(const struct grid_block &block, enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
-    void open_file(void);
-    void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
-    void write_block(void);
-    void read_block(void);
+    void open_file(const struct grid_block &block);
+    void seek_offset(const struct grid_block &block);
+    uint32_t east_blocks(int8_t lat_degrees, int16_t lon_degrees) const;
+    void write_block(union grid_io_block &io_block);
+    void read_block(union grid_io_block &io_block);
 
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
 
+    // prefetch grids ahead of the vehicle based on its ground velocity
+    void update_velocity_prefetch(const Location &loc);
+
+    /*
+      prefetch grids for the current and next mission legs
+     */
+    void update_mission_prefetch(void);
+
     /*
       check for missing mission terrain data
      */
@@ -379,12 +433,19 @@ private:
 
     enum class Options {
         DisableDownload = (1U<<0),
+        DisableMMap     = (1U<<1),
     };
 
     // cache of grids in memory, LRU
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // incremented on each cache access to order blocks for LRU replacement
+    uint32_t cache_access_count;
+
+    // index of the most recently found block, checked first by find_grid_cache
+    uint8_t cache_hint_idx;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -394,7 +455,67 @@ private:
         DiskIoDoneWrite = 4
     };
     volatile enum DiskIoState disk_io_state;
-    union grid_io_block disk_block;
+    union grid_io_block disk_block[TERRAIN_DISK_IO_BATCH];
+    uint8_t disk_io_count;      // number of disk_block elements to be read or written
+    uint8_t disk_io_done;       // number of disk_block elements read or written so far
+
+#if AP_TERRAIN_MMAP_ENABLED
+    // validation state of each block in a mapped file
+    enum MMapBlockState : uint8_t {
+        MMapBlockUnchecked = 0,
+        MMapBlockValid     = 1,     // validated and resident at the last check
+        MMapBlockInvalid   = 2
+    };
+
+    // a read-only mapping of a degree file
+    struct mmap_file {
+        const uint8_t *data;        // start of mapping, nullptr if not mapped
+        uint32_t size;              // length of mapping in bytes
+        uint8_t *block_state;       // MMapBlockState for each block in the mapping
+        uint32_t num_blocks;        // number of entries in block_state
+        uint32_t east_blocks;       // blocks in a stride for spacing
+        uint32_t last_access;       // access sequence number, for LRU replacement
+        uint32_t last_map_ms;       // last time we tried to map the file
+        uint16_t spacing;           // grid spacing east_blocks and block_state are for
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+        bool in_use;                // slot holds this degree file, mapped or not
+    } mmap_files[TERRAIN_MMAP_MAX_FILES];
+    uint32_t mmap_access_count;
+
+    // a block looked up by height_amsl() recently, which the IO
+    // thread keeps mapped, validated and resident
+    struct mmap_want {
+        struct grid_info info;
+        uint32_t want_ms;           // last time it was looked up
+        bool in_use;
+    } mmap_wants[TERRAIN_MMAP_WANT_BLOCKS];
+    bool mmap_want_pending;         // a block is wanted that is not ready
+    uint32_t mmap_last_check_ms;    // last time the IO thread checked the wanted blocks
+
+    /*
+      protects mmap_files and mmap_wants. Only the IO thread maps,
+      unmaps, validates and faults in blocks, and it never holds the
+      semaphore across a system call, so lookups from the main thread
+      don't wait on the disk
+     */
+    HAL_Semaphore mmap_sem;
+
+    /*
+      heights in blocks already on disk are read straight from the
+      mapping, without taking a cache slot
+     */
+    const struct grid_block *mmap_find_block(const struct grid_info &info);
+    void mmap_want_block(const struct grid_info &info, bool ready);
+    void mmap_io_timer(void);
+    void mmap_prepare_block(const struct grid_info &info, bool check_resident);
+    struct mmap_file *mmap_find_file(int8_t lat_degrees, int16_t lon_degrees);
+    bool mmap_map_file(struct mmap_file &file);
+    void mmap_unmap_file(struct mmap_file &file);
+    bool mmap_check_block(const struct grid_block &block, const struct grid_info &info) const;
+    bool mmap_resident(const uint8_t *p, uint32_t len) const;
+    void mmap_block_written(const struct grid_block &block);
+#endif
 
 #if HAL_GCS_ENABLED
     // last time we asked for more grids
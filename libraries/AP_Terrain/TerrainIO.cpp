@@ -29,17 +29,21 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Up to
+  TERRAIN_DISK_IO_BATCH blocks are read in one pass of the IO timer
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    disk_io_count = 0;
+    disk_io_done = 0;
+    for (uint16_t i=0; i<cache_size && disk_io_count<TERRAIN_DISK_IO_BATCH; i++) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+            disk_block[disk_io_count++].block = cache[i].grid;
         }
-    }    
+    }
+    if (disk_io_count > 0) {
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -49,7 +53,9 @@ void AP_Terrain::check_disk_write(void)
 {
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
-            disk_block.block = cache[i].grid;
+            disk_block[0].block = cache[i].grid;
+            disk_io_count = 1;
+            disk_io_done = 0;
             disk_io_state = DiskIoWaitWrite;
             return;
         }
@@ -72,34 +78,30 @@ void AP_Terrain::schedule_disk_io(void)
 
     switch (disk_io_state) {
     case DiskIoIdle:
-        // look for a block that needs reading or writing
-        check_disk_read();
-        if (disk_io_state == DiskIoIdle) {
-            // still idle, check for writes
-            check_disk_write();            
-        }
         break;
-        
-    case DiskIoDoneRead: {
-        // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
-        if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
-                // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+
+    case DiskIoDoneRead:
+        // a batch of reads has completed
+        for (uint8_t i=0; i<disk_io_count; i++) {
+            const struct grid_block &block = disk_block[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DISKWAIT);
+            if (cache_idx != -1) {
+                if (block.bitmap != 0) {
+                    // when bitmap is zero we read an empty block
+                    cache[cache_idx].grid = block;
+                }
+                cache[cache_idx].state = GRID_CACHE_VALID;
+                cache[cache_idx].last_access = ++cache_access_count;
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
         disk_io_state = DiskIoIdle;
         break;
-    }
 
     case DiskIoDoneWrite: {
         // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
+        int16_t cache_idx = find_io_idx(disk_block[0].block, GRID_CACHE_DIRTY);
         if (cache_idx != -1) {
-            if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
+            if (cache[cache_idx].grid.bitmap == disk_block[0].block.bitmap) {
                 // only mark valid if more grids haven't been added
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
@@ -111,7 +113,15 @@ void AP_Terrain::schedule_disk_io(void)
     case DiskIoWaitWrite:
     case DiskIoWaitRead:
         // waiting for io_timer()
-        break;
+        return;
+    }
+
+    // look for more blocks that need reading or writing, so the IO
+    // timer does not have to wait for another call to start them
+    check_disk_read();
+    if (disk_io_state == DiskIoIdle) {
+        // still idle, check for writes
+        check_disk_write();
     }
 }
 
@@ -131,11 +141,10 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  open the degree file for a block
  */
-void AP_Terrain::open_file(void)
+void AP_Terrain::open_file(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
     if (fd != -1 && 
         block.lat_degrees == file_lat_degrees &&
         block.lon_degrees == file_lon_degrees) {
@@ -217,13 +226,13 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(int8_t lat_degrees, int16_t lon_degrees) const
 {
     Location loc1, loc2;
-    loc1.lat = block.lat_degrees*10*1000*1000L;
-    loc1.lng = block.lon_degrees*10*1000*1000L;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
     loc2.lat = loc1.lat;
-    loc2.lng = (block.lon_degrees+1)*10*1000*1000L;
+    loc2.lng = (lon_degrees+1)*10*1000*1000L;
 
     // shift another two blocks east to ensure room is available
     loc2.offset(0, 2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
@@ -232,13 +241,12 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  seek to the right offset for a block
  */
-void AP_Terrain::seek_offset(void)
+void AP_Terrain::seek_offset(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
-    uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
+    uint32_t blocknum = east_blocks(block.lat_degrees, block.lon_degrees) * block.grid_idx_x + block.grid_idx_y;
     uint32_t file_offset = blocknum * sizeof(union grid_io_block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
@@ -252,19 +260,24 @@ void AP_Terrain::seek_offset(void)
 }
 
 /*
-  write out disk_block
+  write out a block
  */
-void AP_Terrain::write_block(void)
+void AP_Terrain::write_block(union grid_io_block &io_block)
 {
-    seek_offset();
+    seek_offset(io_block.block);
     if (io_failure) {
         return;
     }
 
-    disk_block.block.crc = get_block_crc(disk_block.block);
+    io_block.block.crc = get_block_crc(io_block.block);
+
+#if AP_TERRAIN_MMAP_ENABLED
+    // stop the mapped copy being used while it is being written
+    mmap_block_written(io_block.block);
+#endif
 
-    ssize_t ret = AP::FS().write(fd, &disk_block, sizeof(disk_block));
-    if (ret  != sizeof(disk_block)) {
+    ssize_t ret = AP::FS().write(fd, &io_block, sizeof(io_block));
+    if (ret  != sizeof(io_block)) {
 #if TERRAIN_DEBUG
         hal.console->printf("write failed - %s\n", strerror(errno));
 #endif
@@ -273,65 +286,69 @@ void AP_Terrain::write_block(void)
         io_failure = true;
     } else {
         AP::FS().fsync(fd);
+#if AP_TERRAIN_MMAP_ENABLED
+        // validate the mapped copy again with the new contents
+        mmap_block_written(io_block.block);
+#endif
 #if TERRAIN_DEBUG
         printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
-               (long)disk_block.block.lat,
-               (long)disk_block.block.lon,
+               (long)io_block.block.lat,
+               (long)io_block.block.lon,
                (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+               (unsigned long long)io_block.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneWrite;
+    disk_io_done++;
 }
 
 /*
-  read in disk_block
+  read in a block
  */
-void AP_Terrain::read_block(void)
+void AP_Terrain::read_block(union grid_io_block &io_block)
 {
-    seek_offset();
+    seek_offset(io_block.block);
     if (io_failure) {
         return;
     }
-    int32_t lat = disk_block.block.lat;
-    int32_t lon = disk_block.block.lon;
-
-    ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
-    if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+    int32_t lat = io_block.block.lat;
+    int32_t lon = io_block.block.lon;
+
+    ssize_t ret = AP::FS().read(fd, &io_block, sizeof(io_block));
+    if (ret != sizeof(io_block) || 
+        !TERRAIN_LATLON_EQUAL(io_block.block.lat,lat) ||
+        !TERRAIN_LATLON_EQUAL(io_block.block.lon,lon) ||
+        io_block.block.bitmap == 0 ||
+        io_block.block.spacing != grid_spacing ||
+        io_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
+        io_block.block.crc != get_block_crc(io_block.block)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
                (long)lon,
                (int)ret,
-               (long)disk_block.block.lat,
-               (long)disk_block.block.lon,
-               (unsigned)disk_block.block.spacing,
-               (unsigned long)disk_block.block.bitmap,
-               (unsigned)disk_block.block.crc,
-               (unsigned)get_block_crc(disk_block.block));
+               (long)io_block.block.lat,
+               (long)io_block.block.lon,
+               (unsigned)io_block.block.spacing,
+               (unsigned long)io_block.block.bitmap,
+               (unsigned)io_block.block.crc,
+               (unsigned)get_block_crc(io_block.block));
 #endif
         // a short read or bad data is not an IO failure, just a
         // missing block on disk
-        memset(&disk_block, 0, sizeof(disk_block));
-        disk_block.block.lat = lat;
-        disk_block.block.lon = lon;
-        disk_block.block.bitmap = 0;
+        memset(&io_block, 0, sizeof(io_block));
+        io_block.block.lat = lat;
+        io_block.block.lon = lon;
+        io_block.block.bitmap = 0;
     } else {
 #if TERRAIN_DEBUG
         printf("read block at %ld %ld ret=%d mask=%07llx\n",
                (long)lat,
                (long)lon,
                (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+               (unsigned long long)io_block.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneRead;
+    disk_io_done++;
 }
 
 /*
@@ -351,6 +368,10 @@ void AP_Terrain::io_timer(void)
 
     update_reference_offset();
 
+#if AP_TERRAIN_MMAP_ENABLED
+    mmap_io_timer();
+#endif
+
     switch (disk_io_state) {
     case DiskIoIdle:
     case DiskIoDoneRead:
@@ -360,20 +381,31 @@ void AP_Terrain::io_timer(void)
         
     case DiskIoWaitWrite:
         // need to write out the block
-        open_file();
+        open_file(disk_block[0].block);
         if (fd == -1) {
             return;
         }
-        write_block();
+        write_block(disk_block[0]);
+        if (disk_io_done == disk_io_count) {
+            disk_io_state = DiskIoDoneWrite;
+        }
         break;
 
     case DiskIoWaitRead:
-        // need to read in the block
-        open_file();
-        if (fd == -1) {
-            return;
+        // need to read in a batch of blocks. On failure the remaining
+        // blocks are retried on a later pass
+        while (disk_io_done < disk_io_count) {
+            union grid_io_block &io_block = disk_block[disk_io_done];
+            open_file(io_block.block);
+            if (fd == -1 || io_failure) {
+                return;
+            }
+            read_block(io_block);
+            if (io_failure) {
+                return;
+            }
         }
-        read_block();
+        disk_io_state = DiskIoDoneRead;
         break;
     }
 }
@@ -0,0 +1,418 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped access to terrain degree files on Linux and SITL
+
+  Degree files are mapped read-only, so lookups of terrain already on
+  disk need neither a cache slot nor a trip through the disk IO state
+  machine. height_amsl() only reads blocks the IO thread has already
+  mapped, validated and faulted in, and asks for the rest to be
+  prepared. All writes still go through the normal disk IO path.
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Vehicle/AP_Vehicle_Type.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+extern const AP_HAL::HAL& hal;
+
+// minimum time between attempts to map a missing file or remap one
+// that is too short to hold a block
+#define TERRAIN_MMAP_RETRY_MS 1000
+
+// interval at which the IO thread checks wanted blocks are still resident
+#define TERRAIN_MMAP_CHECK_MS 1000
+
+// blocks not looked up for this long are no longer kept resident
+#define TERRAIN_MMAP_WANT_MS 10000
+
+/*
+  find the block for a grid_info in the mapped degree file, returning
+  nullptr unless the IO thread has already validated it and found it
+  resident. Blocks that are not ready are requested from the IO
+  thread. Must be called with mmap_sem held, and the block is only
+  valid while it is held
+ */
+const struct AP_Terrain::grid_block *AP_Terrain::mmap_find_block(const struct grid_info &info)
+{
+    for (auto &f : mmap_files) {
+        if (!f.in_use ||
+            f.lat_degrees != info.lat_degrees ||
+            f.lon_degrees != info.lon_degrees) {
+            continue;
+        }
+        const uint32_t blocknum = f.east_blocks * info.grid_idx_x + info.grid_idx_y;
+        if (f.data == nullptr ||
+            f.spacing != uint16_t(grid_spacing.get()) ||
+            blocknum >= f.num_blocks ||
+            f.block_state[blocknum] != MMapBlockValid) {
+            break;
+        }
+        f.last_access = ++mmap_access_count;
+        mmap_want_block(info, true);
+        return &((const union grid_io_block *)f.data)[blocknum].block;
+    }
+    mmap_want_block(info, false);
+    return nullptr;
+}
+
+/*
+  note that a block has been looked up, so the IO thread keeps it
+  ready. Must be called with mmap_sem held
+ */
+void AP_Terrain::mmap_want_block(const struct grid_info &info, bool ready)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    struct mmap_want *oldest = &mmap_wants[0];
+    for (auto &w : mmap_wants) {
+        if (w.in_use &&
+            w.info.lat_degrees == info.lat_degrees &&
+            w.info.lon_degrees == info.lon_degrees &&
+            w.info.grid_idx_x == info.grid_idx_x &&
+            w.info.grid_idx_y == info.grid_idx_y) {
+            oldest = &w;
+            break;
+        }
+        if (oldest->in_use && (!w.in_use || w.want_ms < oldest->want_ms)) {
+            oldest = &w;
+        }
+    }
+    oldest->info = info;
+    oldest->want_ms = now_ms;
+    oldest->in_use = true;
+    if (!ready) {
+        mmap_want_pending = true;
+    }
+}
+
+/*
+  called from io_timer() to map, validate and fault in the blocks
+  height_amsl() has asked for, and to check that blocks already
+  prepared are still resident
+ */
+void AP_Terrain::mmap_io_timer(void)
+{
+    if (options.get() & uint16_t(Options::DisableMMap)) {
+        return;
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    struct mmap_want wants[TERRAIN_MMAP_WANT_BLOCKS];
+    bool check_resident;
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        check_resident = now_ms - mmap_last_check_ms >= TERRAIN_MMAP_CHECK_MS;
+        if (!mmap_want_pending && !check_resident) {
+            return;
+        }
+        mmap_want_pending = false;
+        if (check_resident) {
+            mmap_last_check_ms = now_ms;
+        }
+        memcpy(wants, mmap_wants, sizeof(wants));
+    }
+
+    for (const auto &w : wants) {
+        if (w.in_use && now_ms - w.want_ms < TERRAIN_MMAP_WANT_MS) {
+            mmap_prepare_block(w.info, check_resident);
+        }
+    }
+}
+
+/*
+  get a block ready for height_amsl(), mapping the file if needed,
+  faulting the block in and validating it. Called from the IO thread
+  without mmap_sem held
+ */
+void AP_Terrain::mmap_prepare_block(const struct grid_info &info, bool check_resident)
+{
+    struct mmap_file &file = *mmap_find_file(info.lat_degrees, info.lon_degrees);
+
+    if (file.spacing != uint16_t(grid_spacing.get())) {
+        // block offsets depend on the grid spacing
+        WITH_SEMAPHORE(mmap_sem);
+        file.spacing = grid_spacing;
+        file.east_blocks = east_blocks(info.lat_degrees, info.lon_degrees);
+        if (file.block_state != nullptr) {
+            memset(file.block_state, MMapBlockUnchecked, file.num_blocks);
+        }
+    }
+
+    const uint32_t blocknum = file.east_blocks * info.grid_idx_x + info.grid_idx_y;
+    if (blocknum >= file.num_blocks) {
+        // the file may have grown since it was mapped
+        if (AP_HAL::millis() - file.last_map_ms < TERRAIN_MMAP_RETRY_MS ||
+            !mmap_map_file(file) ||
+            blocknum >= file.num_blocks) {
+            return;
+        }
+    }
+
+    // only this thread changes the mapping and block states, so they
+    // can be read without the semaphore
+    const uint8_t *b = &file.data[blocknum * sizeof(union grid_io_block)];
+    const struct grid_block &block = ((const union grid_io_block *)b)->block;
+    switch (file.block_state[blocknum]) {
+    case MMapBlockInvalid:
+        // checked again once a write of the block completes
+        return;
+    case MMapBlockValid:
+        if (!check_resident || mmap_resident(b, sizeof(union grid_io_block))) {
+            return;
+        }
+        {
+            // paged out, stop height_amsl() using it until it is back
+            WITH_SEMAPHORE(mmap_sem);
+            file.block_state[blocknum] = MMapBlockUnchecked;
+        }
+        break;
+    case MMapBlockUnchecked:
+        break;
+    }
+
+    // ask for the pages to be read ahead, then touch them all by
+    // checking the crc, so the main thread never takes the page fault
+    const uintptr_t page_size = uintptr_t(sysconf(_SC_PAGESIZE));
+    const uintptr_t page = uintptr_t(b) & ~(page_size-1);
+    ::madvise((void *)page, uintptr_t(b) + sizeof(union grid_io_block) - page, MADV_WILLNEED);
+    const bool valid = mmap_check_block(block, info);
+
+    WITH_SEMAPHORE(mmap_sem);
+    file.block_state[blocknum] = valid ? MMapBlockValid : MMapBlockInvalid;
+}
+
+/*
+  find the slot for a degree file, taking over the least recently
+  used slot if it is not already mapped. Called from the IO thread
+ */
+struct AP_Terrain::mmap_file *AP_Terrain::mmap_find_file(int8_t lat_degrees, int16_t lon_degrees)
+{
+    struct mmap_file *oldest = &mmap_files[0];
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        for (auto &f : mmap_files) {
+            if (f.in_use && f.lat_degrees == lat_degrees && f.lon_degrees == lon_degrees) {
+                return &f;
+            }
+            if (oldest->in_use && (!f.in_use || f.last_access < oldest->last_access)) {
+                oldest = &f;
+            }
+        }
+    }
+
+    mmap_unmap_file(*oldest);
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        oldest->in_use = true;
+        oldest->lat_degrees = lat_degrees;
+        oldest->lon_degrees = lon_degrees;
+        oldest->spacing = 0;
+    }
+    mmap_map_file(*oldest);
+    return oldest;
+}
+
+/*
+  map (or remap, if it has grown) a degree file. Validation state of
+  blocks already in the mapping is kept. Called from the IO thread
+  without mmap_sem held
+ */
+bool AP_Terrain::mmap_map_file(struct mmap_file &file)
+{
+    file.last_map_ms = AP_HAL::millis();
+
+    const char *terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == nullptr) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    // match AP_Filesystem, which keeps SITL files below the current directory
+    if (*terrain_dir == '/') {
+        terrain_dir++;
+    }
+#endif
+
+    uint32_t lat_tmp = abs((int32_t)file.lat_degrees);
+    if (lat_tmp > 99U) {
+        lat_tmp = 99U;
+    }
+    uint32_t lon_tmp = abs((int32_t)file.lon_degrees);
+    if (lon_tmp > 999U) {
+        lon_tmp = 999U;
+    }
+    char path[128];
+    const int len = hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                                       terrain_dir,
+                                       file.lat_degrees<0?'S':'N',
+                                       (unsigned)lat_tmp,
+                                       file.lon_degrees<0?'W':'E',
+                                       (unsigned)lon_tmp);
+    if (len <= 0 || size_t(len) >= sizeof(path)) {
+        return false;
+    }
+
+    const int fd_map = ::open(path, O_RDONLY|O_CLOEXEC);
+    if (fd_map == -1) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd_map, &st) != 0 ||
+        st.st_size < (off_t)sizeof(union grid_io_block) ||
+        uint64_t(st.st_size) > UINT32_MAX) {
+        ::close(fd_map);
+        return false;
+    }
+    const uint32_t num_blocks = uint32_t(st.st_size) / sizeof(union grid_io_block);
+    if (num_blocks <= file.num_blocks) {
+        // nothing new to map
+        ::close(fd_map);
+        return false;
+    }
+    const uint32_t size = num_blocks * sizeof(union grid_io_block);
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_map, 0);
+    ::close(fd_map);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    uint8_t *block_state = NEW_NOTHROW uint8_t[num_blocks];
+    if (block_state == nullptr) {
+        ::munmap(data, size);
+        return false;
+    }
+    memset(block_state, MMapBlockUnchecked, num_blocks);
+    if (file.block_state != nullptr) {
+        memcpy(block_state, file.block_state, file.num_blocks);
+    }
+
+    const uint8_t *old_data = file.data;
+    const uint32_t old_size = file.size;
+    uint8_t *old_block_state = file.block_state;
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        file.data = (const uint8_t *)data;
+        file.size = size;
+        file.block_state = block_state;
+        file.num_blocks = num_blocks;
+    }
+    if (old_data != nullptr) {
+        ::munmap(const_cast<uint8_t *>(old_data), old_size);
+    }
+    delete[] old_block_state;
+    return true;
+}
+
+/*
+  release the mapping of a degree file. Called from the IO thread
+  without mmap_sem held
+ */
+void AP_Terrain::mmap_unmap_file(struct mmap_file &file)
+{
+    const uint8_t *old_data = file.data;
+    const uint32_t old_size = file.size;
+    uint8_t *old_block_state = file.block_state;
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        file.data = nullptr;
+        file.size = 0;
+        file.block_state = nullptr;
+        file.num_blocks = 0;
+    }
+    if (old_data != nullptr) {
+        ::munmap(const_cast<uint8_t *>(old_data), old_size);
+    }
+    delete[] old_block_state;
+}
+
+/*
+  check that a block in the mapping holds valid data for a grid_info,
+  with the same tests as read_block()
+ */
+bool AP_Terrain::mmap_check_block(const struct grid_block &block, const struct grid_info &info) const
+{
+    if (block.version != TERRAIN_GRID_FORMAT_VERSION ||
+        block.spacing != grid_spacing ||
+        block.bitmap == 0 ||
+        !TERRAIN_LATLON_EQUAL(block.lat, info.grid_lat) ||
+        !TERRAIN_LATLON_EQUAL(block.lon, info.grid_lon)) {
+        return false;
+    }
+
+    // the mapping is read-only, so calculate the crc in three parts
+    // with the crc field taken as zero
+    const uint8_t *b = (const uint8_t *)&block;
+    const uint8_t zero_crc[sizeof(block.crc)] {};
+    const uint32_t crc_ofs = offsetof(struct grid_block, crc);
+    const uint32_t rest_ofs = crc_ofs + sizeof(zero_crc);
+    uint16_t crc = crc16_ccitt(b, crc_ofs, 0);
+    crc = crc16_ccitt(zero_crc, sizeof(zero_crc), crc);
+    crc = crc16_ccitt(&b[rest_ofs], sizeof(block) - rest_ofs, crc);
+    return crc == block.crc;
+}
+
+/*
+  check whether all pages holding a block are resident
+ */
+bool AP_Terrain::mmap_resident(const uint8_t *p, uint32_t len) const
+{
+    const uintptr_t page_size = uintptr_t(sysconf(_SC_PAGESIZE));
+    const uintptr_t page = uintptr_t(p) & ~(page_size-1);
+    const uintptr_t npages = (uintptr_t(p) + len - page + page_size - 1) / page_size;
+    unsigned char vec[4];
+    if (npages > ARRAY_SIZE(vec) ||
+        ::mincore((void *)page, npages * page_size, vec) != 0) {
+        return false;
+    }
+    for (uint8_t i=0; i<npages; i++) {
+        if ((vec[i] & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  called from the IO thread around writes of a block, so the mapped
+  copy is validated again before it is next used
+ */
+void AP_Terrain::mmap_block_written(const struct grid_block &block)
+{
+    WITH_SEMAPHORE(mmap_sem);
+    for (auto &f : mmap_files) {
+        if (!f.in_use ||
+            f.lat_degrees != block.lat_degrees ||
+            f.lon_degrees != block.lon_degrees ||
+            f.spacing != block.spacing) {
+            continue;
+        }
+        const uint32_t blocknum = f.east_blocks * block.grid_idx_x + block.grid_idx_y;
+        if (blocknum < f.num_blocks) {
+            f.block_state[blocknum] = MMapBlockUnchecked;
+        } else {
+            // allow an immediate remap to pick up the new block
+            f.last_map_ms = AP_HAL::millis() - TERRAIN_MMAP_RETRY_MS;
+        }
+    }
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
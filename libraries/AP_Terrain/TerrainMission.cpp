@@ -114,6 +114,52 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+/*
+  prefetch the grids at the ends of the current and next mission
+  legs. update_mission_data() makes sure these are on disk, this
+  brings them back into memory before the vehicle gets there
+ */
+void AP_Terrain::update_mission_prefetch(void)
+{
+#if AP_MISSION_ENABLED
+    if (cache_size < TERRAIN_PREFETCH_MIN_CACHE_SIZE) {
+        // not enough room to hold the grids without evicting the surrounding tiles
+        return;
+    }
+
+    const AP_Mission *mission = AP::mission();
+    if (mission == nullptr || mission->state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+
+    const AP_Mission::Mission_Command &nav_cmd = mission->get_current_nav_cmd();
+    if (nav_cmd.index == AP_MISSION_CMD_INDEX_NONE) {
+        return;
+    }
+
+    // look at the current command and up to 10 following commands,
+    // stopping at the first waypoint after the current one. Jumps are
+    // not followed
+    for (uint16_t i=0; i<=10; i++) {
+        AP_Mission::Mission_Command cmd;
+        if (i == 0) {
+            cmd = nav_cmd;
+        } else if (!mission->read_cmd_from_storage(nav_cmd.index+i, cmd)) {
+            return;
+        }
+        if ((cmd.id != MAV_CMD_NAV_WAYPOINT &&
+             cmd.id != MAV_CMD_NAV_SPLINE_WAYPOINT) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        prefetch_grid(cmd.content.location);
+        if (i > 0) {
+            return;
+        }
+    }
+#endif  // AP_MISSION_ENABLED
+}
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
@@ -51,6 +51,33 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
     return (grid.bitmap & (((uint64_t)1U)<<bitnum)) != 0;
 }
 
+/*
+  get the heights of the 4 grid points surrounding a grid_info
+ */
+bool AP_Terrain::get_heights(const struct grid_block &grid, const struct grid_info &info, int16_t heights[2][2])
+{
+    /*
+      note that we rely on the one square overlap to ensure these
+      calculations don't go past the end of the arrays
+     */
+    ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
+    ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
+
+    // check we have all 4 required heights
+    if (!check_bitmap(grid, info.idx_x,   info.idx_y) ||
+        !check_bitmap(grid, info.idx_x,   info.idx_y+1) ||
+        !check_bitmap(grid, info.idx_x+1, info.idx_y) ||
+        !check_bitmap(grid, info.idx_x+1, info.idx_y+1)) {
+        return false;
+    }
+
+    heights[0][0] = grid.height[info.idx_x+0][info.idx_y+0];
+    heights[0][1] = grid.height[info.idx_x+0][info.idx_y+1];
+    heights[1][0] = grid.height[info.idx_x+1][info.idx_y+0];
+    heights[1][1] = grid.height[info.idx_x+1][info.idx_y+1];
+    return true;
+}
+
 /*
   given a location, calculate the 32x28 grid SW corner, plus the
   grid indices
@@ -106,23 +133,43 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
+    // most lookups are for the same block as the last one
+    if (cache_hint_idx < cache_size) {
+        struct grid_cache &hint = cache[cache_hint_idx];
+        if (TERRAIN_LATLON_EQUAL(hint.grid.lat,info.grid_lat) &&
+            TERRAIN_LATLON_EQUAL(hint.grid.lon,info.grid_lon) &&
+            hint.grid.spacing == grid_spacing) {
+            hint.last_access = ++cache_access_count;
+            return hint;
+        }
+    }
+
+    // least recently used blocks, preferring blocks without unwritten
+    // data from the GCS
+    int16_t oldest_i = -1;
+    int16_t oldest_dirty_i = -1;
 
     // see if we have that grid
     for (uint16_t i=0; i<cache_size; i++) {
         if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
             TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
             cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
+            cache[i].last_access = ++cache_access_count;
+            cache_hint_idx = i;
             return cache[i];
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
+        int16_t &oldest = (cache[i].state == GRID_CACHE_DIRTY) ? oldest_dirty_i : oldest_i;
+        if (oldest == -1 || cache[i].last_access < cache[oldest].last_access) {
+            oldest = i;
         }
     }
+    if (oldest_i == -1) {
+        oldest_i = MAX(oldest_dirty_i, 0);
+    }
 
     // Not found. Use the oldest grid and make it this grid,
     // initially unpopulated
+    cache_hint_idx = oldest_i;
     struct grid_cache &grid = cache[oldest_i];
     memset(&grid, 0, sizeof(grid));
 
@@ -134,7 +181,7 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
+    grid.last_access = ++cache_access_count;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
@@ -143,22 +190,22 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
 }
 
 /*
-  find cache index of disk_block
+  find cache index of a block read from or written to disk
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+int16_t AP_Terrain::find_io_idx(const struct grid_block &block, enum GridCacheState state)
 {
     // try first with given state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon) &&
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon) &&
             cache[i].state == state) {
             return i;
         }
     }    
     // then any state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon)) {
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon)) {
             return i;
         }
     }    
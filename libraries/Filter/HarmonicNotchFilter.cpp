@@ -219,6 +219,10 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint32_t harm
 
     if (_num_filters > 0) {
         _filters = NEW_NOTHROW NotchFilter<T>[_num_filters];
+        if (_filters != nullptr && !allocate_bank(_num_filters)) {
+            delete[] _filters;
+            _filters = nullptr;
+        }
         if (_filters == nullptr) {
             GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
             _num_filters = 0;
@@ -249,6 +253,11 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
         _alloc_has_failed = true;
         return;
     }
+    if (!allocate_bank(total_notches)) {
+        delete[] filters;
+        _alloc_has_failed = true;
+        return;
+    }
     memcpy(filters, _filters, sizeof(filters[0])*_num_filters);
     auto _old_filters = _filters;
     _filters = filters;
@@ -389,6 +398,36 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
     }
 }
 
+/*
+  the SIMD delay lines are only used for 3-axis samples. For those the
+  bank is always sized with the filters so that we never switch
+  between the two sets of delay lines
+ */
+template <class T>
+bool HarmonicNotchFilter<T>::allocate_bank(uint16_t total_notches)
+{
+    return true;
+}
+
+template <>
+bool HarmonicNotchFilter<Vector3f>::allocate_bank(uint16_t total_notches)
+{
+    return _bank.resize(total_notches);
+}
+
+template <class T>
+bool HarmonicNotchFilter<T>::apply_bank(T &sample)
+{
+    return false;
+}
+
+template <>
+bool HarmonicNotchFilter<Vector3f>::apply_bank(Vector3f &sample)
+{
+    sample = _bank.apply(_filters, _num_enabled_filters, sample);
+    return true;
+}
+
 /*
   apply a sample to each of the underlying filters in turn and return the output
  */
@@ -399,6 +438,13 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
         return sample;
     }
 
+#if !NOTCH_DEBUG_LOGGING
+    T bank_output = sample;
+    if (apply_bank(bank_output)) {
+        return bank_output;
+    }
+#endif
+
 #if NOTCH_DEBUG_LOGGING
     static int dfd = -1;
     if (dfd == -1) {
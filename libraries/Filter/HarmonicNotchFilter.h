@@ -18,6 +18,7 @@
 #include <cmath>
 #include <AP_Param/AP_Param.h>
 #include "NotchFilter.h"
+#include "NotchFilterBank.h"
 
 #define HNF_MAX_HARMONICS 16
 
@@ -60,8 +61,15 @@ public:
     void log_notch_centers(uint8_t instance, uint64_t now_us) const;
 
 private:
+    // grow the SIMD delay line storage to match the filter count, only used for Vector3f
+    bool allocate_bank(uint16_t total_notches);
+    // apply a sample using the SIMD delay line storage, returns false if not used for this type
+    bool apply_bank(T &sample);
+
     // underlying bank of notch filters
     NotchFilter<T>*  _filters;
+    // delay lines for the notch filters when filtering Vector3f samples
+    NotchFilterBank3f _bank;
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
@@ -0,0 +1,152 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#pragma GCC optimize("O2")
+#endif
+
+#include "NotchFilterBank.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define NOTCH_BANK_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NOTCH_BANK_NEON
+#elif defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 2)
+// Helium shares the NEON intrinsic names for the operations we need
+#include <arm_mve.h>
+#define NOTCH_BANK_NEON
+#endif
+
+NotchFilterBank3f::~NotchFilterBank3f()
+{
+    delete[] _state;
+}
+
+/*
+  grow the bank to count notches. Note that we rely on the same
+  semaphore as HarmonicNotchFilter::expand_filter_count() for thread
+  safety
+ */
+bool NotchFilterBank3f::resize(uint16_t count)
+{
+    if (count <= _size) {
+        return true;
+    }
+    auto state = NEW_NOTHROW State[count];
+    if (state == nullptr) {
+        return false;
+    }
+    if (_state != nullptr) {
+        memcpy(state, _state, sizeof(state[0])*_size);
+    }
+    auto old_state = _state;
+    _state = state;
+    _size = count;
+    delete[] old_state;
+    return true;
+}
+
+/*
+  run a sample through a cascade of notches. The order of operations
+  matches NotchFilter::apply() so that without fused multiply-add
+  contraction the output is bit-identical to the scalar path
+ */
+Vector3f NotchFilterBank3f::apply(NotchFilter<Vector3f> *filters, uint16_t count, const Vector3f &sample)
+{
+    float v[4] { sample.x, sample.y, sample.z, 0.0f };
+
+#if defined(NOTCH_BANK_SSE)
+    __m128 x = _mm_loadu_ps(v);
+    for (uint16_t i = 0; i < count; i++) {
+        auto &f = filters[i];
+        auto &s = _state[i];
+        if (!f.initialised || f.need_reset) {
+            // pass through and prime the delay line, as NotchFilter::apply()
+            _mm_storeu_ps(s.ntchsig1, x);
+            _mm_storeu_ps(s.ntchsig2, x);
+            _mm_storeu_ps(s.signal1, x);
+            _mm_storeu_ps(s.signal2, x);
+            f.need_reset = false;
+            continue;
+        }
+        const __m128 ntchsig1 = _mm_loadu_ps(s.ntchsig1);
+        const __m128 signal1 = _mm_loadu_ps(s.signal1);
+        __m128 y = _mm_mul_ps(x, _mm_set1_ps(f.b0));
+        y = _mm_add_ps(y, _mm_mul_ps(ntchsig1, _mm_set1_ps(f.b1)));
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(s.ntchsig2), _mm_set1_ps(f.b2)));
+        y = _mm_sub_ps(y, _mm_mul_ps(signal1, _mm_set1_ps(f.a1)));
+        y = _mm_sub_ps(y, _mm_mul_ps(_mm_loadu_ps(s.signal2), _mm_set1_ps(f.a2)));
+        _mm_storeu_ps(s.ntchsig2, ntchsig1);
+        _mm_storeu_ps(s.ntchsig1, x);
+        _mm_storeu_ps(s.signal2, signal1);
+        _mm_storeu_ps(s.signal1, y);
+        x = y;
+    }
+    _mm_storeu_ps(v, x);
+#elif defined(NOTCH_BANK_NEON)
+    float32x4_t x = vld1q_f32(v);
+    for (uint16_t i = 0; i < count; i++) {
+        auto &f = filters[i];
+        auto &s = _state[i];
+        if (!f.initialised || f.need_reset) {
+            // pass through and prime the delay line, as NotchFilter::apply()
+            vst1q_f32(s.ntchsig1, x);
+            vst1q_f32(s.ntchsig2, x);
+            vst1q_f32(s.signal1, x);
+            vst1q_f32(s.signal2, x);
+            f.need_reset = false;
+            continue;
+        }
+        const float32x4_t ntchsig1 = vld1q_f32(s.ntchsig1);
+        const float32x4_t signal1 = vld1q_f32(s.signal1);
+        float32x4_t y = vmulq_n_f32(x, f.b0);
+        y = vaddq_f32(y, vmulq_n_f32(ntchsig1, f.b1));
+        y = vaddq_f32(y, vmulq_n_f32(vld1q_f32(s.ntchsig2), f.b2));
+        y = vsubq_f32(y, vmulq_n_f32(signal1, f.a1));
+        y = vsubq_f32(y, vmulq_n_f32(vld1q_f32(s.signal2), f.a2));
+        vst1q_f32(s.ntchsig2, ntchsig1);
+        vst1q_f32(s.ntchsig1, x);
+        vst1q_f32(s.signal2, signal1);
+        vst1q_f32(s.signal1, y);
+        x = y;
+    }
+    vst1q_f32(v, x);
+#else
+    for (uint16_t i = 0; i < count; i++) {
+        auto &f = filters[i];
+        auto &s = _state[i];
+        if (!f.initialised || f.need_reset) {
+            // pass through and prime the delay line, as NotchFilter::apply()
+            for (uint8_t a = 0; a < 3; a++) {
+                s.ntchsig1[a] = s.ntchsig2[a] = s.signal1[a] = s.signal2[a] = v[a];
+            }
+            f.need_reset = false;
+            continue;
+        }
+        for (uint8_t a = 0; a < 3; a++) {
+            const float output = v[a]*f.b0 + s.ntchsig1[a]*f.b1 + s.ntchsig2[a]*f.b2 - s.signal1[a]*f.a1 - s.signal2[a]*f.a2;
+            s.ntchsig2[a] = s.ntchsig1[a];
+            s.ntchsig1[a] = v[a];
+            s.signal2[a] = s.signal1[a];
+            s.signal1[a] = output;
+            v[a] = output;
+        }
+    }
+#endif
+
+    return Vector3f(v[0], v[1], v[2]);
+}
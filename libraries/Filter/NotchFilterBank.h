@@ -0,0 +1,56 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  delay line storage for a cascade of 3-axis notch filters
+
+  The x, y and z axes of each notch delay line are held in adjacent
+  lanes of a 4 float vector so that a whole sample can be run through
+  one notch with a single set of SIMD operations (SSE, NEON or Helium
+  where available, scalar otherwise). The filter coefficients and the
+  enable/reset state remain owned by the NotchFilter objects, which
+  keeps frequency updates and logging unchanged.
+ */
+
+#include "NotchFilter.h"
+
+class NotchFilterBank3f {
+public:
+    ~NotchFilterBank3f();
+
+    // make room for count notches, preserving existing state. Returns false on allocation failure
+    bool resize(uint16_t count);
+
+    // number of notches with allocated state
+    uint16_t size(void) const { return _size; }
+
+    /*
+      apply a sample to the first count notches of filters in turn,
+      giving the same result as calling filters[i].apply() on each
+     */
+    Vector3f apply(NotchFilter<Vector3f> *filters, uint16_t count, const Vector3f &sample);
+
+private:
+    struct State {
+        float ntchsig1[4];
+        float ntchsig2[4];
+        float signal1[4];
+        float signal2[4];
+    };
+
+    State *_state = nullptr;
+    uint16_t _size = 0;
+};
@@ -0,0 +1,83 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float rate_hz = 2000;
+static const uint8_t num_sources = 4;
+static const uint32_t harmonics = 7;
+
+static void setup_params(HarmonicNotchFilterParams &params)
+{
+    params.set_options(uint16_t(HarmonicNotchFilterParams::Options::TripleNotch));
+    params.set_attenuation(40);
+    params.set_bandwidth_hz(40);
+    params.set_center_freq_hz(80);
+    params.set_freq_min_ratio(1.0);
+}
+
+/*
+  a cascade of individual 3-axis notches, as applied before the SIMD notch bank
+ */
+static void BM_NotchFilterChainVector3f(benchmark::State& state)
+{
+    // harmonics 1-3 of each source as triple notches
+    const uint16_t num_filters = num_sources * 3 * 3;
+    NotchFilter<Vector3f> filters[num_filters] {};
+    for (uint16_t i = 0; i < num_filters; i++) {
+        filters[i].init(rate_hz, 80 + i * 10, 20, 40);
+    }
+    Vector3f sample { 0.1, 0.2, 0.3 };
+
+    while (state.KeepRunning()) {
+        Vector3f output = sample;
+        for (uint16_t i = 0; i < num_filters; i++) {
+            output = filters[i].apply(output);
+        }
+        gbenchmark_escape(&output);
+    }
+}
+
+static void BM_HarmonicNotchFilterVector3f(benchmark::State& state)
+{
+    HarmonicNotchFilterParams params {};
+    setup_params(params);
+    HarmonicNotchFilter<Vector3f> filter {};
+    filter.allocate_filters(num_sources, harmonics, params.num_composite_notches());
+    filter.init(rate_hz, params);
+    const float centers[num_sources] { 80, 90, 100, 110 };
+    filter.update(num_sources, centers);
+    Vector3f sample { 0.1, 0.2, 0.3 };
+
+    while (state.KeepRunning()) {
+        Vector3f output = filter.apply(sample);
+        gbenchmark_escape(&output);
+    }
+}
+
+static void BM_HarmonicNotchFilterFloat3(benchmark::State& state)
+{
+    HarmonicNotchFilterParams params {};
+    setup_params(params);
+    HarmonicNotchFilter<float> filters[3] {};
+    const float centers[num_sources] { 80, 90, 100, 110 };
+    for (auto &f : filters) {
+        f.allocate_filters(num_sources, harmonics, params.num_composite_notches());
+        f.init(rate_hz, params);
+        f.update(num_sources, centers);
+    }
+    Vector3f sample { 0.1, 0.2, 0.3 };
+
+    while (state.KeepRunning()) {
+        Vector3f output { filters[0].apply(sample.x), filters[1].apply(sample.y), filters[2].apply(sample.z) };
+        gbenchmark_escape(&output);
+    }
+}
+
+BENCHMARK(BM_NotchFilterChainVector3f);
+BENCHMARK(BM_HarmonicNotchFilterVector3f);
+BENCHMARK(BM_HarmonicNotchFilterFloat3);
+
+BENCHMARK_MAIN();
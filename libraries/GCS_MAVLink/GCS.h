@@ -441,6 +441,11 @@ public:
       allow forwarding of packets / heartbeats to be blocked as required by some components to reduce traffic
     */
     static void disable_channel_routing(mavlink_channel_t chan) { routing.no_route_mask |= (1U<<(chan-MAVLINK_COMM_0)); }
+
+#if HAL_LOGGING_ENABLED
+    // log the forwarding counters of the routes
+    static void log_routes() { routing.log_routes(); }
+#endif
     
     /*
       search for a component in the routing table with given mav_type and retrieve it's sysid, compid and channel
@@ -895,7 +900,26 @@ private:
     // return interval deferred message bucket should be sent after.
     // When sending parameters and waypoints this may be longer than
     // the interval specified in "deferred"
-    uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
+    uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const {
+        return get_reschedule_interval_ms(deferred, get_reschedule_multiplier());
+    }
+    uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred, uint8_t multiplier) const;
+    // return the factor bucket intervals are multiplied by while we
+    // are busy sending parameters, waypoints or ftp replies
+    uint8_t get_reschedule_multiplier() const;
+
+#if HAL_LOGGING_ENABLED
+    // how late deferred messages and buckets are sent compared to
+    // their requested interval, reset each time the link stats are
+    // logged
+    struct {
+        uint32_t total_ms;
+        uint16_t count;
+        uint16_t max_ms;
+        uint16_t max_interval_ms;   // requested interval of the send which slipped most
+    } send_slip;
+    void record_send_slip(uint16_t ms_since_last_sent, uint16_t interval_ms);
+#endif
 
     bool do_try_send_message(const ap_message id);
 
@@ -1005,6 +1029,31 @@ private:
         int16_t current_session;
         uint32_t last_send_ms;
         uint8_t need_banner_send_mask;
+
+        // offset of the file position, so sequential reads don't seek
+        uint32_t file_offset;
+
+        // burst read pacing and statistics for the open file
+        uint32_t link_rate;         // measured throughput of the link in bytes/s, zero if unknown
+        bool push_stalled;          // a reply had to wait for space on the link
+        uint32_t read_bytes;        // file data sent by burst reads
+        uint32_t read_us;           // time spent in burst reads
+        uint16_t seeks;
+
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+        // file data read ahead by ftp_reader. The reader owns the file
+        // position while active, and holds sem while reading
+        struct {
+            ByteBuffer *buf;
+            HAL_Semaphore sem;
+            HAL_BinarySemaphore wake_reader;    // signalled by ftp_read when the reader has work
+            HAL_BinarySemaphore data_ready;     // signalled by the reader on new data, end of file or error
+            uint32_t offset;            // file offset of the first byte in buf
+            bool active;
+            std::atomic<bool> eof;
+            std::atomic<int> err;
+        } readahead;
+#endif
     };
     static struct ftp_state ftp;
 
@@ -1017,6 +1066,11 @@ private:
     bool send_ftp_reply(const pending_ftp &reply);
     void ftp_worker(void);
     void ftp_push_replies(pending_ftp &reply);
+    static ssize_t ftp_read(uint32_t offset, uint8_t *data, uint32_t len);
+    static void ftp_close_file(void);
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+    void ftp_reader(void);
+#endif
 #endif  // AP_MAVLINK_FTP_ENABLED
 
     void send_distance_sensor(const class AP_RangeFinder_Backend *sensor, const uint8_t instance) const;
@@ -1203,29 +1203,37 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
     return false;
 }
 
-uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
+uint8_t GCS_MAVLINK::get_reschedule_multiplier() const
 {
-    uint32_t interval_ms = deferred.interval_ms;
-
-    interval_ms += stream_slowdown_ms;
+    uint8_t multiplier = 1;
 
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
         // we are sending parameters, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
     if (requesting_mission_items()) {
         // we are sending requests for waypoints, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
 #if AP_MAVLINK_FTP_ENABLED
     if (AP_HAL::millis() - ftp.last_send_ms < 1000) {
         // we are sending ftp replies
-        interval_ms *= 4;
+        multiplier *= 4;
     }
 #endif
 
+    return multiplier;
+}
+
+uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred, uint8_t multiplier) const
+{
+    uint32_t interval_ms = deferred.interval_ms;
+
+    interval_ms += stream_slowdown_ms;
+    interval_ms *= multiplier;
+
     if (interval_ms > 60000) {
         return 60000;
     }
@@ -1244,12 +1252,15 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
     // all done sending this bucket... find another bucket...
     sending_bucket_id = no_bucket_to_send;
     uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
+    // the penalty for busy links is the same for every bucket
+    const uint8_t multiplier = get_reschedule_multiplier();
     for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
+        if (deferred_message_bucket[i].interval_ms == 0) {
+            // unused bucket; buckets are freed as soon as they are
+            // emptied, so this is cheaper than counting entries
             continue;
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
+        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i], multiplier);
         const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
         uint16_t ms_before_send_this_bucket;
         if (ms_since_last_sent > interval) {
@@ -1561,6 +1572,9 @@ void GCS_MAVLINK::update_send()
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
                 const uint16_t interval_ms = deferred_message[next].interval_ms;
+#if HAL_LOGGING_ENABLED
+                record_send_slip(start16 - deferred_message[next].last_sent_ms, interval_ms);
+#endif
                 deferred_message[next].last_sent_ms += interval_ms;
                 // but we do not want to try to catch up too much:
                 if (uint16_t(start16 - deferred_message[next].last_sent_ms) > interval_ms) {
@@ -1610,6 +1624,10 @@ void GCS_MAVLINK::update_send()
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
                 const uint16_t interval_ms = get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
+#if HAL_LOGGING_ENABLED
+                record_send_slip(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms,
+                                 deferred_message_bucket[sending_bucket_id].interval_ms);
+#endif
                 deferred_message_bucket[sending_bucket_id].last_sent_ms += interval_ms;
                 // but we do not want to try to catch up too much:
                 if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
@@ -1645,6 +1663,27 @@ void GCS_MAVLINK::update_send()
     last_tx_seq = _channel_status.current_tx_seq;
 }
 
+#if HAL_LOGGING_ENABLED
+/*
+  record how much later than its requested interval a deferred
+  message or bucket was sent
+ */
+void GCS_MAVLINK::record_send_slip(uint16_t ms_since_last_sent, uint16_t interval_ms)
+{
+    const uint16_t slip_ms = ms_since_last_sent > interval_ms ? ms_since_last_sent - interval_ms : 0;
+    if (send_slip.count == UINT16_MAX) {
+        // not being logged
+        send_slip = {};
+    }
+    send_slip.total_ms += slip_ms;
+    send_slip.count++;
+    if (slip_ms >= send_slip.max_ms) {
+        send_slip.max_ms = slip_ms;
+        send_slip.max_interval_ms = interval_ms;
+    }
+}
+#endif
+
 void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
 {
     deferred_message_bucket[bucket].ap_message_ids.clear(id);
@@ -2070,9 +2109,14 @@ void GCS_MAVLINK::log_mavlink_stats()
     flags                  : flags,
     stream_slowdown_ms     : stream_slowdown_ms,
     times_full             : out_of_space_to_send_count,
+    slip_avg_ms            : uint16_t(send_slip.count > 0 ? send_slip.total_ms / send_slip.count : 0),
+    slip_max_ms            : send_slip.max_ms,
+    slip_max_interval_ms   : send_slip.max_interval_ms,
     };
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    send_slip = {};
 }
 #endif
 
@@ -2730,6 +2774,9 @@ void GCS::update_receive(void)
     for (uint8_t i=0; i<num_gcs(); i++) {
         chan(i)->update_receive();
     }
+#if HAL_LOGGING_ENABLED
+    GCS_MAVLINK::log_routes();
+#endif
     // also update UART pass-thru, if enabled
     update_passthru();
 }
@@ -26,6 +26,7 @@
 #include <AP_Filesystem/AP_Filesystem.h>
 #include <AP_HAL/utility/sparse-endian.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
+#include <AP_Logger/AP_Logger.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -53,6 +54,18 @@ bool GCS_MAVLINK::ftp_init(void) {
         goto failed;
     }
 
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+    // reading ahead is optional, files are read directly without it
+    ftp.readahead.buf = NEW_NOTHROW ByteBuffer(AP_MAVLINK_FTP_READAHEAD_SIZE);
+    if (ftp.readahead.buf != nullptr &&
+        (ftp.readahead.buf->get_size() == 0 ||
+         !hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::ftp_reader, void),
+                                       "FTPR", 2048, AP_HAL::Scheduler::PRIORITY_IO, 0))) {
+        delete ftp.readahead.buf;
+        ftp.readahead.buf = nullptr;
+    }
+#endif
+
     if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::ftp_worker, void),
                                       "FTP", 2560, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
         goto failed;
@@ -149,6 +162,7 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
     ftp.last_send_ms = AP_HAL::millis(); // Used to detect active FTP session
 
     while (!send_ftp_reply(reply)) {
+        ftp.push_stalled = true;
         hal.scheduler->delay(2);
     }
 
@@ -167,6 +181,154 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
     }
 }
 
+/*
+  read from the open file at offset, only seeking when the read
+  doesn't follow on from the previous one. With read ahead the data
+  comes from the buffer filled by ftp_reader, which is restarted at
+  offset when the read isn't sequential
+ */
+ssize_t GCS_MAVLINK::ftp_read(uint32_t offset, uint8_t *data, uint32_t len)
+{
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+    auto &ra = ftp.readahead;
+    if (ra.buf != nullptr) {
+        if (!ra.active || offset != ra.offset) {
+            WITH_SEMAPHORE(ra.sem);
+            ra.buf->clear();
+            ra.active = false;
+            if (offset != ftp.file_offset) {
+                if (AP::FS().lseek(ftp.fd, offset, SEEK_SET) == -1) {
+                    return -1;
+                }
+                ftp.file_offset = offset;
+                ftp.seeks++;
+            }
+            ra.offset = offset;
+            ra.eof = false;
+            ra.err = 0;
+            ra.active = true;
+        } else if (ra.eof && ra.buf->available() == 0) {
+            // the file may have grown since the reader reached the
+            // end of it, as log files do, so have it read again
+            WITH_SEMAPHORE(ra.sem);
+            ra.eof = false;
+        }
+        while (ra.buf->available() < len && !ra.eof && ra.err == 0) {
+            ra.wake_reader.signal();
+            ra.data_ready.wait_blocking();
+        }
+        // the reader commits data before flagging the end of the
+        // file, so check what is available again
+        if (ra.buf->available() == 0 && ra.err != 0) {
+            errno = ra.err;
+            return -1;
+        }
+        const uint32_t n = ra.buf->read(data, len);
+        ra.offset += n;
+        if (ra.buf->space() >= ra.buf->get_size() / 4) {
+            // keep the reader ahead of us
+            ra.wake_reader.signal();
+        }
+        return n;
+    }
+#endif
+
+    if (offset != ftp.file_offset) {
+        if (AP::FS().lseek(ftp.fd, offset, SEEK_SET) == -1) {
+            return -1;
+        }
+        ftp.file_offset = offset;
+        ftp.seeks++;
+    }
+    const ssize_t n = AP::FS().read(ftp.fd, data, len);
+    if (n > 0) {
+        ftp.file_offset += n;
+    }
+    return n;
+}
+
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+/*
+  thread keeping the read ahead buffer full. Data is read straight
+  into the buffer. The thread sleeps until ftp_read has room for more,
+  and wakes ftp_read whenever it has something new to report
+ */
+void GCS_MAVLINK::ftp_reader(void)
+{
+    auto &ra = ftp.readahead;
+    while (true) {
+        bool updated = false;
+        {
+            WITH_SEMAPHORE(ra.sem);
+            ByteBuffer::IoVec vec[2];
+            if (ra.active && !ra.eof && ra.err == 0 &&
+                ra.buf->space() >= ra.buf->get_size() / 4 &&
+                ra.buf->reserve(vec, ra.buf->space()) > 0) {
+                // only the part up to the end of the buffer, the
+                // rest is read on the next pass
+                const ssize_t n = AP::FS().read(ftp.fd, vec[0].data, vec[0].len);
+                if (n > 0) {
+                    ra.buf->commit(n);
+                    ftp.file_offset += n;
+                } else if (n == 0) {
+                    ra.eof = true;
+                } else {
+                    ra.err = errno != 0 ? errno : EIO;
+                }
+                updated = true;
+            }
+        }
+        if (updated) {
+            ra.data_ready.signal();
+        } else {
+            ra.wake_reader.wait_blocking();
+        }
+    }
+}
+#endif  // AP_MAVLINK_FTP_READAHEAD_ENABLED
+
+/*
+  close the open file, logging the statistics of any burst reads
+ */
+void GCS_MAVLINK::ftp_close_file(void)
+{
+#if AP_MAVLINK_FTP_READAHEAD_ENABLED
+    if (ftp.readahead.buf != nullptr) {
+        WITH_SEMAPHORE(ftp.readahead.sem);
+        ftp.readahead.active = false;
+        ftp.readahead.buf->clear();
+    }
+#endif
+
+#if HAL_LOGGING_ENABLED
+    if (ftp.mode == FTP_FILE_MODE::Read && ftp.read_bytes > 0) {
+// @LoggerMessage: MFTP
+// @Description: MAVLink FTP burst read statistics, written when the file is closed
+// @Field: TimeUS: Time since system startup
+// @Field: Bytes: file data sent by burst reads
+// @Field: Time: time spent in burst reads
+// @Field: Rate: throughput achieved by burst reads
+// @Field: LRate: measured link throughput used to pace bursts, zero if not paced
+// @Field: Seeks: reads that did not follow on from the previous read
+        AP::logger().Write(
+            "MFTP",
+            "TimeUS,Bytes,Time,Rate,LRate,Seeks",
+            "s-sBB-",
+            "F-C00-",
+            "QIIIIH",
+            AP_HAL::micros64(),
+            ftp.read_bytes,
+            ftp.read_us / 1000U,
+            ftp.read_us > 0 ? uint32_t(uint64_t(ftp.read_bytes) * 1000000U / ftp.read_us) : 0U,
+            ftp.link_rate,
+            ftp.seeks);
+    }
+#endif
+
+    AP::FS().close(ftp.fd);
+    ftp.fd = -1;
+}
+
 void GCS_MAVLINK::ftp_worker(void) {
     pending_ftp request;
     pending_ftp reply = {};
@@ -222,8 +384,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                 // if a new session appears and the old session has
                 // been idle for more than the timeout then force
                 // close the old session
-                AP::FS().close(ftp.fd);
-                ftp.fd = -1;
+                ftp_close_file();
                 ftp.current_session = -1;
             }
             // dispatch the command as needed
@@ -235,8 +396,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                 case FTP_OP::ResetSessions:
                     // we already handled this, just listed for completeness
                     if (ftp.fd != -1) {
-                        AP::FS().close(ftp.fd);
-                        ftp.fd = -1;
+                        ftp_close_file();
                     }
                     ftp.current_session = -1;
                     reply.opcode = FTP_OP::Ack;
@@ -251,8 +411,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                             // no activity for 3s, assume client has
                             // timed out receiving open reply, close
                             // the file
-                            AP::FS().close(ftp.fd);
-                            ftp.fd = -1;
+                            ftp_close_file();
                             ftp.current_session = -1;
                         }
                         if (ftp.fd != -1) {
@@ -285,6 +444,11 @@ void GCS_MAVLINK::ftp_worker(void) {
                         }
                         ftp.mode = FTP_FILE_MODE::Read;
                         ftp.current_session = request.session;
+                        ftp.file_offset = 0;
+                        ftp.link_rate = 0;
+                        ftp.read_bytes = 0;
+                        ftp.read_us = 0;
+                        ftp.seeks = 0;
 
                         reply.opcode = FTP_OP::Ack;
                         reply.size = sizeof(uint32_t);
@@ -310,14 +474,8 @@ void GCS_MAVLINK::ftp_worker(void) {
                             break;
                         }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-
                         // fill the buffer
-                        const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data),request.size));
+                        const ssize_t read_bytes = ftp_read(request.offset, reply.data, MIN(sizeof(reply.data),request.size));
                         if (read_bytes == -1) {
                             ftp_error(reply, FTP_ERROR::FailErrno);
                             break;
@@ -479,35 +637,41 @@ void GCS_MAVLINK::ftp_worker(void) {
                             break;
                         }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-
                         /*
                           calculate a burst delay so that FTP burst
                           transfer doesn't use more than 1/3 of
-                          available bandwidth on links that don't have
-                          flow control. This reduces the chance of
-                          lost packets a lot, which results in overall
-                          faster transfers
+                          the link's throughput on links that don't
+                          have flow control. This reduces the chance
+                          of lost packets a lot, which results in
+                          overall faster transfers. The throughput
+                          starts at the port's bandwidth and follows
+                          what is measured when the link backs up
                          */
-                        uint32_t burst_delay_ms = 0;
+                        const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
+                        uint32_t port_bw = 0;
+                        uint32_t burst_delay_us = 0;
                         if (valid_channel(request.chan)) {
                             auto *port = mavlink_comm_port[request.chan];
                             if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                                const uint32_t bw = port->bw_in_bytes_per_second();
-                                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                                burst_delay_ms = 3000 * pkt_size / bw;
+                                port_bw = port->bw_in_bytes_per_second();
+                            }
+                        }
+                        if (port_bw > 0) {
+                            if (ftp.link_rate == 0 || ftp.link_rate > port_bw) {
+                                ftp.link_rate = port_bw;
                             }
+                            burst_delay_us = 3000000ULL * pkt_size / ftp.link_rate;
                         }
 
+                        const uint32_t burst_start_us = AP_HAL::micros();
+                        uint32_t link_bytes = 0;
+                        ftp.push_stalled = false;
+
                         // this transfer size is enough for a full parameter file with max parameters
                         const uint32_t transfer_size = 500;
                         for (uint32_t i = 0; (i < transfer_size); i++) {
                             // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data), max_read));
+                            const ssize_t read_bytes = ftp_read(request.offset + i * max_read, reply.data, MIN(sizeof(reply.data), max_read));
                             if (read_bytes == -1) {
                                 ftp_error(reply, FTP_ERROR::FailErrno);
                                 break;
@@ -529,6 +693,8 @@ void GCS_MAVLINK::ftp_worker(void) {
                             reply.size = (uint8_t)read_bytes;
 
                             ftp_push_replies(reply);
+                            ftp.read_bytes += read_bytes;
+                            link_bytes += pkt_size;
 
                             if (read_bytes < max_read) {
                                 // ensure the NACK which we send next is at the right offset
@@ -538,7 +704,26 @@ void GCS_MAVLINK::ftp_worker(void) {
                             // prep the reply to be used again
                             reply.seq_number++;
 
-                            hal.scheduler->delay(burst_delay_ms);
+                            hal.scheduler->delay(burst_delay_us / 1000);
+                            if (burst_delay_us % 1000 != 0) {
+                                hal.scheduler->delay_microseconds(burst_delay_us % 1000);
+                            }
+                        }
+
+                        const uint32_t burst_us = AP_HAL::micros() - burst_start_us;
+                        ftp.read_us += burst_us;
+                        if (port_bw > 0 && link_bytes > 0) {
+                            const uint32_t paced_us = burst_delay_us * (link_bytes / pkt_size);
+                            if (ftp.push_stalled && burst_us > paced_us) {
+                                // the link held up the burst, so the
+                                // time not spent pacing gives its
+                                // throughput
+                                const uint32_t rate = uint64_t(link_bytes) * 1000000U / (burst_us - paced_us);
+                                ftp.link_rate = constrain_uint32(rate, 1, ftp.link_rate);
+                            } else {
+                                // probe back up towards the port's bandwidth
+                                ftp.link_rate = MIN(ftp.link_rate + ftp.link_rate / 8 + 1, port_bw);
+                            }
                         }
 
                         if (reply.opcode != FTP_OP::Nack) {
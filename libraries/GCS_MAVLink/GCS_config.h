@@ -85,6 +85,20 @@
 #define AP_MAVLINK_FTP_ENABLED HAL_GCS_ENABLED
 #endif
 
+// read files ahead of MAVLink FTP reads from a thread of its own
+#ifndef AP_MAVLINK_FTP_READAHEAD_ENABLED
+#define AP_MAVLINK_FTP_READAHEAD_ENABLED (AP_MAVLINK_FTP_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+// bytes of file read ahead
+#ifndef AP_MAVLINK_FTP_READAHEAD_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 65536
+#else
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 16384
+#endif
+#endif
+
 // GCS should be using MISSION_REQUEST_INT instead; this is a waste of
 // flash.  MISSION_REQUEST was deprecated in June 2020.  We started
 // sending warnings to the GCS in Sep 2022 if this command was used.
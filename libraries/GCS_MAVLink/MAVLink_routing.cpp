@@ -27,6 +27,7 @@
 #include "MAVLink_routing.h"
 
 #include <AP_ADSB/AP_ADSB.h>
+#include <AP_Logger/AP_Logger.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -114,7 +115,7 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
 
     // learn new routes including private channels
     // so that find_mav_type works for all channels
-    learn_route(in_link, msg);
+    struct route *source = learn_route(in_link, msg);
 
     if (msg.msgid == MAVLINK_MSG_ID_RADIO ||
         msg.msgid == MAVLINK_MSG_ID_RADIO_STATUS) {
@@ -127,7 +128,7 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
     if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
         // heartbeat needs special handling
         if (!from_private_channel) {
-            handle_heartbeat(in_link, msg);
+            handle_heartbeat(in_link, msg, source);
         }
         return true;
     }
@@ -171,45 +172,52 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    // find the channels with routes matching the targets. Private
+    // channels only get messages for the exact sysid/compid of one of
+    // their routes, which is never a broadcast
+    const uint8_t private_mask = GCS_MAVLINK::private_channel_mask();
+    uint8_t chan_mask = 0;
+    if (broadcast_system) {
+        chan_mask = route_chan_mask & ~private_mask;
+    } else {
+        if (target_component != -1) {
+            chan_mask = target_chan_mask(target_system, target_component);
+        }
+        if (broadcast_component || !match_system) {
+            chan_mask |= system_chan_mask(target_system) & ~private_mask;
+        }
+    }
+    chan_mask &= ~(1U<<(in_link.get_chan()-MAVLINK_COMM_0));
 
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
-        if (out_link == nullptr) {
-            // this is bad
+    // forward on each of them
+    bool forwarded = false;
+    for (uint8_t i=0; chan_mask != 0 && i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((chan_mask & (1U<<i)) == 0) {
             continue;
         }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+        chan_mask &= ~(1U<<i);
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        GCS_MAVLINK *out_link = gcs().chan(channel);
+        if (out_link == nullptr) {
+            // this is bad
             continue;
         }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link.get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_link.get_chan(),
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
+            _mavlink_resend_uart(channel, &msg);
+            if (source != nullptr) {
+                source->packets++;
+                source->bytes += msg.len + GCS_MAVLINK::packet_overhead_chan(channel);
             }
         }
+        forwarded = true;
     }
 
     if ((!forwarded && match_system) ||
@@ -236,29 +244,24 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels where our system ID has been seen
+    const uint8_t chan_mask = system_chan_mask(mavlink_system.sysid);
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
-        }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((chan_mask & (1U<<i)) == 0) {
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u sysid=%u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel,
+                 (unsigned)mavlink_system.sysid);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -266,13 +269,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -312,54 +314,83 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
     return false;
 }
 
+/*
+  find the slot of a hash table holding key, or the unused slot where
+  it should be added. The tables always have unused slots
+*/
+uint16_t MAVLink_routing::find_slot(const target *table, uint16_t key)
+{
+    uint16_t i = (uint32_t(key) * 2654435761U) >> (32 - MAVLINK_ROUTE_HASH_BITS);
+    while (table[i].key != key && table[i].key != 0) {
+        i = (i + 1) & (TARGET_HASH_SIZE - 1);
+    }
+    return i;
+}
+
 /*
   see if the message is for a new route and learn it
 */
-void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
+struct MAVLink_routing::route *MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
-        return;
+        return nullptr;
     }
     if (msg.sysid == mavlink_system.sysid &&
         msg.compid == mavlink_system.compid) {
         // don't learn routes to ourself.  We know where we are.
-        return;
+        return nullptr;
     }
     if (msg.sysid == mavlink_system.sysid &&
         msg.compid == MAV_COMP_ID_ALL) {
         // don't learn routes to the broadcast component ID for our
         // own system id.  We should still broadcast these, but we
         // should also process them locally.
-        return;
+        return nullptr;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    const uint8_t chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    const uint16_t key = (uint16_t(msg.sysid)<<8) | msg.compid;
+    target &t = targets[find_slot(targets, key)];
+    if (t.chan_mask & chan_bit) {
+        // a known route, one of the few to this sysid/compid
+        for (uint8_t i=t.first_route; i!=NO_ROUTE; i=routes[i].next) {
+            if (routes[i].channel == in_channel) {
+                if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                    routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+                }
+                return &routes[i];
             }
-            break;
         }
+        return nullptr;
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-        }
-        num_routes++;
+    if (num_routes >= MAVLINK_MAX_ROUTES) {
+        return nullptr;
+    }
+    const uint8_t i = num_routes++;
+    routes[i].sysid = msg.sysid;
+    routes[i].compid = msg.compid;
+    routes[i].channel = in_channel;
+    if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    routes[i].next = t.key == 0 ? NO_ROUTE : t.first_route;
+    t.key = key;
+    t.first_route = i;
+    t.chan_mask |= chan_bit;
+
+    target &s = systems[find_slot(systems, msg.sysid)];
+    s.key = msg.sysid;
+    s.chan_mask |= chan_bit;
+
+    route_chan_mask |= chan_bit;
 #if ROUTING_DEBUG
-        ::printf("learned route %u %u via %u\n",
-                 (unsigned)msg.sysid,
-                 (unsigned)msg.compid,
-                 (unsigned)in_channel);
+    ::printf("learned route %u %u via %u\n",
+             (unsigned)msg.sysid,
+             (unsigned)msg.compid,
+             (unsigned)in_channel);
 #endif
-    }
+    return &routes[i];
 }
 
 
@@ -368,7 +399,7 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
   propagation heartbeat messages need to be forwarded on all channels
   except channels where the sysid/compid of the heartbeat could come from
 */
-void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_t &msg)
+void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_t &msg, struct route *source)
 {
     uint16_t mask = GCS_MAVLINK::active_channel_mask() & ~GCS_MAVLINK::private_channel_mask();
 
@@ -382,11 +413,7 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
-    }
+    mask &= ~target_chan_mask(msg.sysid, msg.compid);
 
     if (mask == 0) {
         // nothing to send to
@@ -407,11 +434,64 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
                          (unsigned)msg.compid);
 #endif
                 _mavlink_resend_uart(channel, &msg);
+                if (source != nullptr) {
+                    source->packets++;
+                    source->bytes += msg.len + GCS_MAVLINK::packet_overhead_chan(channel);
+                }
             }
         }
     }
 }
 
+#if HAL_LOGGING_ENABLED
+/*
+  log the counters of the routes that have had packets forwarded,
+  showing where the forwarding load comes from
+*/
+void MAVLink_routing::log_routes()
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_log_ms < 10000) {
+        return;
+    }
+    last_log_ms = now_ms;
+
+    AP_Logger *logger = AP_Logger::get_singleton();
+    if (logger == nullptr || !logger->logging_started()) {
+        return;
+    }
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i=0; i<num_routes; i++) {
+        const struct route &r = routes[i];
+        if (r.packets == 0) {
+            continue;
+        }
+// @LoggerMessage: MRTE
+// @Description: MAVLink routes; packets forwarded from each learned route
+// @Field: TimeUS: Time since system startup
+// @Field: SysID: system ID of the route
+// @Field: CompID: component ID of the route
+// @Field: Chan: MAVLink channel the route was learned on
+// @Field: Type: MAV_TYPE from the route's heartbeat
+// @Field: Pkts: packets from the route forwarded to other channels
+// @Field: Bytes: bytes from the route forwarded to other channels
+        logger->Write(
+            "MRTE",
+            "TimeUS,SysID,CompID,Chan,Type,Pkts,Bytes",
+            "s------",
+            "F------",
+            "QBBBBII",
+            now_us,
+            r.sysid,
+            r.compid,
+            (uint8_t)r.channel,
+            r.mavtype,
+            r.packets,
+            r.bytes);
+    }
+}
+#endif  // HAL_LOGGING_ENABLED
+
 
 /*
   extract target sysid and compid from a message. int16_t is used so
@@ -3,11 +3,29 @@
 #pragma once
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Logger/AP_Logger_config.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
+// boards with more memory allow for companion computers with many
+// components behind them
+#ifndef MAVLINK_MAX_ROUTES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define MAVLINK_MAX_ROUTES 64
+#else
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// the route index has at least twice as many slots as there are routes
+#if MAVLINK_MAX_ROUTES <= 32
+#define MAVLINK_ROUTE_HASH_BITS 6
+#elif MAVLINK_MAX_ROUTES <= 64
+#define MAVLINK_ROUTE_HASH_BITS 7
+#elif MAVLINK_MAX_ROUTES <= 128
+#define MAVLINK_ROUTE_HASH_BITS 8
+#else
+#define MAVLINK_ROUTE_HASH_BITS 9
+#endif
 
 /*
   object to handle MAVLink packet routing
@@ -49,28 +67,76 @@ public:
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
+#if HAL_LOGGING_ENABLED
+    // log the forwarding counters of the routes
+    void log_routes();
+#endif
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    static constexpr uint8_t NO_ROUTE = 0xFF;
+    static_assert(MAVLINK_MAX_ROUTES < NO_ROUTE, "too many routes");
+    static_assert(MAVLINK_COMM_NUM_BUFFERS <= 8, "channel masks are 8 bits");
+
+    // routes in the order they were learned
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
         mavlink_channel_t channel;
         uint8_t mavtype;
+        uint8_t next;           // next route to the same sysid/compid, or NO_ROUTE
+        uint32_t packets;       // packets from this route forwarded to other channels
+        uint32_t bytes;
     } routes[MAVLINK_MAX_ROUTES];
-    
+
+    /*
+      the routes are indexed by open addressing hash tables with at
+      least twice as many slots as routes, so probes stay short. As
+      routes are never removed an unused slot always ends a probe
+     */
+    static constexpr uint16_t TARGET_HASH_SIZE = 1U<<MAVLINK_ROUTE_HASH_BITS;
+    static_assert(TARGET_HASH_SIZE >= 2*MAVLINK_MAX_ROUTES, "route index too small");
+
+    struct target {
+        uint16_t key;           // zero for an unused slot
+        uint8_t chan_mask;      // channels with a route to the target
+        uint8_t first_route;    // for targets, the first of the routes to it
+    };
+    // keyed by sysid<<8|compid, the sysid is never zero
+    target targets[TARGET_HASH_SIZE];
+    // keyed by sysid, with the channels of the routes to any component
+    target systems[TARGET_HASH_SIZE];
+
+    // channels with any route
+    uint8_t route_chan_mask;
+
+    // slot holding key, or the unused slot where it would go
+    static uint16_t find_slot(const target *table, uint16_t key);
+
+    // channels with a route to a sysid/compid
+    uint8_t target_chan_mask(uint8_t sysid, uint8_t compid) const {
+        return targets[find_slot(targets, (uint16_t(sysid)<<8) | compid)].chan_mask;
+    }
+    // channels with a route to any component of a sysid
+    uint8_t system_chan_mask(uint8_t sysid) const {
+        return systems[find_slot(systems, sysid)].chan_mask;
+    }
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
-    
-    // learn new routes
-    void learn_route(GCS_MAVLINK &link, const mavlink_message_t &msg);
+
+#if HAL_LOGGING_ENABLED
+    uint32_t last_log_ms;
+#endif
+
+    // learn new routes, returning the route of the sender or nullptr
+    struct route *learn_route(GCS_MAVLINK &link, const mavlink_message_t &msg);
 
     // extract target sysid and compid from a message
     void get_targets(const mavlink_message_t &msg, int16_t &sysid, int16_t &compid);
 
     // special handling for heartbeat messages
-    void handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_t &msg);
+    void handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_t &msg, struct route *source);
 
     void send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, uint8_t pkt_len);
 
@@ -59,6 +59,7 @@ Aircraft::Aircraft(const char *frame_str) :
     set_speedup(1.0f);
 
     last_wall_time_us = get_wall_time_us();
+    last_cpu_time_us = get_cpu_time_us();
 
     // allow for orientation settings, such as with tailsitters
     enum ap_var_type ptype;
@@ -314,10 +315,15 @@ void Aircraft::sync_frame_time(void)
     float dt_wall = (now_ms - last_fps_report_ms) * 0.001;
     if (dt_wall > 0.01) {  // 0.01s average
         achieved_rate_hz = (frame_counter - last_frame_count) / dt_wall;
+        // CPU use as a percentage of one core, so the cost of a
+        // speedup can be compared across parallel instances
+        const uint64_t cpu_time_us = get_cpu_time_us();
+        cpu_load_pct = (cpu_time_us - last_cpu_time_us) * 1.0e-4 / dt_wall;
+        last_cpu_time_us = cpu_time_us;
 #if 0
-        ::printf("Rate: target:%.1f achieved:%.1f speedup %.1f/%.1f\n",
+        ::printf("Rate: target:%.1f achieved:%.1f speedup %.1f/%.1f cpu %.0f%%\n",
                  rate_hz*target_speedup, achieved_rate_hz,
-                 achieved_rate_hz/rate_hz, target_speedup);
+                 achieved_rate_hz/rate_hz, target_speedup, cpu_load_pct);
 #endif
         last_frame_count = frame_counter;
         last_fps_report_ms = now_ms;
@@ -504,18 +510,20 @@ void Aircraft::fill_fdm(struct sitl_fdm &fdm)
 // @Field: As: Airspeed
 // @Field: ASpdU: Achieved simulation speedup value
 // @Field: UFC: Number of times simulation paused for serial0 output
+// @Field: CPU: Simulator process CPU use as a percentage of one core
         Vector3d pos = get_position_relhome();
         Vector3f vel = get_velocity_ef();
         AP::logger().WriteStreaming(
             "SIM2",
-            "TimeUS,PN,PE,PD,VN,VE,VD,As,ASpdU,UFC",
-            "QdddfffffI",
+            "TimeUS,PN,PE,PD,VN,VE,VD,As,ASpdU,UFC,CPU",
+            "QdddfffffIf",
             AP_HAL::micros64(),
             pos.x, pos.y, pos.z,
             vel.x, vel.y, vel.z,
             airspeed_pitot,
             achieved_rate_hz/rate_hz,
-            full_count
+            full_count,
+            cpu_load_pct
         );
     }
 #endif
@@ -664,6 +672,21 @@ uint64_t Aircraft::get_wall_time_us() const
 #endif
 }
 
+/*
+  return CPU time used by all threads of this process, or zero if not
+  available
+ */
+uint64_t Aircraft::get_cpu_time_us() const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+        return uint64_t(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL);
+    }
+#endif
+    return 0;
+}
+
 /*
   set simulation speedup
  */
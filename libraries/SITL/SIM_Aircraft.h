@@ -263,6 +263,8 @@ protected:
     uint64_t last_wall_time_us;
     uint32_t last_fps_report_ms;
     float achieved_rate_hz;  // achieved speedup rate
+    float cpu_load_pct;      // process CPU use over the same interval, percent of one core
+    uint64_t last_cpu_time_us;
     int64_t sleep_debt_us;
     uint32_t last_frame_count;
     uint8_t instance;
@@ -322,6 +324,7 @@ protected:
 
     /* return a monotonic wall clock time in microseconds */
     uint64_t get_wall_time_us(void) const;
+    uint64_t get_cpu_time_us(void) const;
 
     // update attitude and relative position
     void update_dynamics(const Vector3f &rot_accel);
@@ -647,6 +647,14 @@ const AP_Param::GroupInfo SIM::var_info3[] = {
     // @Path: ./SIM_Vicon.cpp
     AP_SUBGROUPINFO(vicon, "VICON_", 56, SIM, ViconParms),
 
+    // @Param: LOG_STALL
+    // @DisplayName: Simulated log write stall
+    // @Description: Delay added to every write to a log file, standing in for a slow or stalling SD card
+    // @Units: ms
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("LOG_STALL",    57, SIM,  log_write_stall_ms, 0),
+
 #ifdef SFML_JOYSTICK
     AP_SUBGROUPEXTENSION("",      63, SIM,  var_sfml_joystick),
 #endif // SFML_JOYSTICK
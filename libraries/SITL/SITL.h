@@ -245,6 +245,7 @@ public:
     AP_Int16 on_hardware_relay_enable_mask;   // mask of relays passed through to actual hardware
 
     AP_Float uart_byte_loss_pct;
+    AP_Int16 log_write_stall_ms; // delay added to each log file write
 
 #ifdef SFML_JOYSTICK
     AP_Int8 sfml_joystick_id;